@@ -0,0 +1,213 @@
+#include "CaptureRecorder.h"
+#include "DSP/MemoryFootprint.h"
+
+//==============================================================================
+/** Drains every recording instance in the process, every few milliseconds. */
+class CaptureRecorder::WriterThread : private juce::Thread
+{
+public:
+    WriterThread() : juce::Thread ("Car Test capture writer") {}
+    ~WriterThread() override { stopThread (4000); }
+
+    void add (CaptureRecorder& recorder)
+    {
+        const juce::ScopedLock sl (lock);
+        recorders.addIfNotAlreadyThere (&recorder);
+
+        if (! isThreadRunning())
+            startThread();
+    }
+
+    /** Once this returns, the thread won't touch recorder again. */
+    void remove (CaptureRecorder& recorder)
+    {
+        const juce::ScopedLock sl (lock);
+        recorders.removeFirstMatchingValue (&recorder);
+    }
+
+private:
+    // Polled rather than signalled, so push() never has to wake anyone
+    static constexpr int kPollMs = 10;
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            {
+                const juce::ScopedLock sl (lock);
+
+                for (auto* recorder : recorders)
+                    recorder->drain();
+            }
+
+            wait (kPollMs);
+        }
+    }
+
+    juce::CriticalSection lock;
+    juce::Array<CaptureRecorder*> recorders;
+};
+
+//==============================================================================
+CaptureRecorder::CaptureRecorder() = default;
+
+CaptureRecorder::~CaptureRecorder()
+{
+    stop();
+}
+
+void CaptureRecorder::prepare (double newSampleRate, int numChannels)
+{
+    numChannels = juce::jmax (1, numChannels);
+
+    if (fifo != nullptr && newSampleRate == sampleRate && numChannels == channels)
+        return;
+
+    // The file's format is fixed, so a new rate or width ends the recording
+    stop();
+
+    const juce::ScopedLock sl (writerLock);
+    sampleRate = newSampleRate;
+    channels   = numChannels;
+
+    const int capacity = static_cast<int> (std::ceil (kRingSeconds * sampleRate)) + 1;
+    ring.setSize (channels, capacity);
+    fifo = std::make_unique<juce::AbstractFifo> (capacity);
+}
+
+size_t CaptureRecorder::getMemoryBytes() const
+{
+    return MemoryFootprint::bytesOf (ring);
+}
+
+juce::Result CaptureRecorder::start (const juce::File& file, Format format)
+{
+    stop();
+
+    if (fifo == nullptr)
+        return juce::Result::fail ("Capture isn't prepared yet: start playback first");
+
+    file.getParentDirectory().createDirectory();
+    file.deleteFile();
+
+    // A large stream buffer keeps the writes few and big, however many instances are recording
+    std::unique_ptr<juce::OutputStream> stream (file.createOutputStream (1 << 18));
+
+    if (stream == nullptr)
+        return juce::Result::fail ("Couldn't open " + file.getFullPathName() + " for writing");
+
+    std::unique_ptr<juce::AudioFormat> audioFormat;
+
+    if (format == Format::flac)
+        audioFormat = std::make_unique<juce::FlacAudioFormat>();
+    else
+        audioFormat = std::make_unique<juce::WavAudioFormat>();
+
+    {
+        const juce::ScopedLock sl (writerLock);
+
+        writer.reset (audioFormat->createWriterFor (stream.get(), sampleRate, static_cast<unsigned int> (channels),
+                                                    kBitDepth, {}, 0));
+
+        if (writer == nullptr)
+            return juce::Result::fail (audioFormat->getFormatName() + " can't record "
+                                       + juce::String (channels) + " channels at " + juce::String (sampleRate) + " Hz");
+
+        stream.release();   // the writer owns it now
+
+        // Leftovers from a push that raced the last stop()
+        fifo->finishedRead (fifo->getNumReady());
+
+        currentFile = file;
+        samplesWritten = 0;
+        samplesDropped = 0;
+        overruns       = 0;
+    }
+
+    recording.store (true, std::memory_order_release);
+    writerThread->add (*this);
+    return juce::Result::ok();
+}
+
+void CaptureRecorder::stop()
+{
+    if (! recording.exchange (false, std::memory_order_acq_rel))
+        return;
+
+    writerThread->remove (*this);
+
+    const juce::ScopedLock sl (writerLock);
+    drain();
+    writer.reset();   // flushes and finalises the header
+}
+
+juce::File CaptureRecorder::getFile() const
+{
+    const juce::ScopedLock sl (writerLock);
+    return currentFile;
+}
+
+CaptureRecorder::Stats CaptureRecorder::getStats() const
+{
+    Stats s;
+    s.samplesWritten = samplesWritten.load (std::memory_order_relaxed);
+    s.samplesDropped = samplesDropped.load (std::memory_order_relaxed);
+    s.overruns       = overruns.load (std::memory_order_relaxed);
+    s.seconds        = sampleRate > 0.0 ? static_cast<double> (s.samplesWritten) / sampleRate : 0.0;
+    return s;
+}
+
+//==============================================================================
+void CaptureRecorder::push (const juce::AudioBuffer<float>& buffer) noexcept
+{
+    if (! recording.load (std::memory_order_acquire))
+        return;
+
+    const int numSamples = buffer.getNumSamples();
+    const int srcChannels = buffer.getNumChannels();
+
+    if (numSamples <= 0 || srcChannels <= 0)
+        return;
+
+    // All or nothing, so the file never has a block split by a gap
+    if (fifo->getFreeSpace() < numSamples)
+    {
+        samplesDropped.fetch_add (numSamples, std::memory_order_relaxed);
+        overruns.fetch_add (1, std::memory_order_relaxed);
+        return;
+    }
+
+    int start1, size1, start2, size2;
+    fifo->prepareToWrite (numSamples, start1, size1, start2, size2);
+
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        const float* src = buffer.getReadPointer (juce::jmin (ch, srcChannels - 1));
+
+        if (size1 > 0)
+            juce::FloatVectorOperations::copy (ring.getWritePointer (ch, start1), src, size1);
+
+        if (size2 > 0)
+            juce::FloatVectorOperations::copy (ring.getWritePointer (ch, start2), src + size1, size2);
+    }
+
+    fifo->finishedWrite (size1 + size2);
+}
+
+void CaptureRecorder::drain()
+{
+    if (writer == nullptr || fifo == nullptr)
+        return;
+
+    int start1, size1, start2, size2;
+    fifo->prepareToRead (fifo->getNumReady(), start1, size1, start2, size2);
+
+    if (size1 > 0)
+        writer->writeFromAudioSampleBuffer (ring, start1, size1);
+
+    if (size2 > 0)
+        writer->writeFromAudioSampleBuffer (ring, start2, size2);
+
+    fifo->finishedRead (size1 + size2);
+    samplesWritten.fetch_add (size1 + size2, std::memory_order_relaxed);
+}
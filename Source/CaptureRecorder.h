@@ -0,0 +1,87 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+
+//==============================================================================
+/**
+    Records the plugin's output to a WAV or FLAC file while the session plays.
+
+    The audio thread only calls push(): a wait-free copy into a preallocated
+    ring (juce::AbstractFifo), with no locks, allocation, file I/O or thread
+    signalling.  If the ring is full the block is dropped whole and counted as
+    an overrun, so a stalled disk costs a gap in the file, never a glitch in
+    playback.
+
+    One writer thread per process, shared through a SharedResourcePointer,
+    wakes every few milliseconds and drains every recording instance.  The
+    ring holds kRingSeconds of audio at the prepared rate, which is the
+    longest disk stall a recording rides out.
+
+    start(), stop() and prepare() belong to the message thread.
+*/
+class CaptureRecorder
+{
+public:
+    enum class Format
+    {
+        wav,
+        flac
+    };
+
+    struct Stats
+    {
+        juce::int64 samplesWritten = 0;
+        juce::int64 samplesDropped = 0;
+        int         overruns       = 0;   // blocks that didn't fit in the ring
+        double      seconds        = 0.0; // written so far
+    };
+
+    static constexpr double kRingSeconds = 2.0;
+    static constexpr int    kBitDepth    = 24;
+
+    CaptureRecorder();
+    ~CaptureRecorder();
+
+    /** Sizes the ring.  A recording in progress is stopped if the rate or channel count changes. */
+    void prepare (double sampleRate, int numChannels);
+
+    /** Heap bytes of the ring. */
+    size_t getMemoryBytes() const;
+
+    /** Opens file and starts capturing from the next push(); any previous recording is stopped first. */
+    juce::Result start (const juce::File& file, Format format);
+
+    /** Writes what's still in the ring and closes the file. */
+    void stop();
+
+    bool isRecording() const { return recording.load (std::memory_order_acquire); }
+    juce::File getFile() const;
+    Stats getStats() const;
+
+    /** Audio thread: queues the block for the writer.  Wait-free. */
+    void push (const juce::AudioBuffer<float>& buffer) noexcept;
+
+private:
+    class WriterThread;
+    friend class WriterThread;
+
+    /** Writes everything in the ring to the file: the writer thread while registered, stop() after. */
+    void drain();
+
+    juce::SharedResourcePointer<WriterThread> writerThread;
+
+    juce::CriticalSection writerLock;
+    std::unique_ptr<juce::AudioFormatWriter> writer;
+    juce::File currentFile;
+
+    juce::AudioBuffer<float> ring;
+    std::unique_ptr<juce::AbstractFifo> fifo;
+    double sampleRate = 44100.0;
+    int    channels   = 0;
+
+    std::atomic<bool> recording { false };
+    std::atomic<juce::int64> samplesWritten { 0 }, samplesDropped { 0 };
+    std::atomic<int> overruns { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CaptureRecorder)
+};
@@ -0,0 +1,302 @@
+#include "AsyncTailConvolver.h"
+#include "MemoryFootprint.h"
+
+//==============================================================================
+AsyncTailConvolver::Tail AsyncTailConvolver::makeTail (const juce::AudioBuffer<float>& ir)
+{
+    Tail t;
+    const int tailLength = ir.getNumSamples() - kHeadLength;
+
+    if (tailLength <= 0 || ir.getNumChannels() == 0)
+        return t;
+
+    t.numPartitions = (tailLength + kPartitionSize - 1) / kPartitionSize;
+
+    juce::dsp::FFT transform (kFFTOrder);
+    std::vector<float> work (static_cast<size_t> (kFFTSize * 2));
+
+    for (int ch = 0; ch < kMaxChannels; ++ch)
+    {
+        const auto* src = ir.getReadPointer (juce::jmin (ch, ir.getNumChannels() - 1));
+        auto& parts = t.partitions[static_cast<size_t> (ch)];
+        parts.resize (static_cast<size_t> (t.numPartitions));
+
+        for (int k = 0; k < t.numPartitions; ++k)
+        {
+            const int start = kHeadLength + k * kPartitionSize;
+            const int count = juce::jmin (kPartitionSize, ir.getNumSamples() - start);
+
+            // Partition in the first half, zeros in the second (overlap-save)
+            std::fill (work.begin(), work.end(), 0.0f);
+            std::copy (src + start, src + start + count, work.begin());
+            transform.performRealOnlyForwardTransform (work.data(), true);
+
+            const auto* bins = reinterpret_cast<const std::complex<float>*> (work.data());
+            parts[static_cast<size_t> (k)].assign (bins, bins + kNumBins);
+        }
+    }
+
+    return t;
+}
+
+//==============================================================================
+AsyncTailConvolver::AsyncTailConvolver() {}
+
+AsyncTailConvolver::~AsyncTailConvolver()
+{
+    release();
+}
+
+void AsyncTailConvolver::prepare (int numChannels, int maxNumPartitions)
+{
+    if (pool == nullptr)
+    {
+        poolHandle.emplace();
+        pool = &poolHandle->get();
+    }
+
+    pool->cancel (job);
+
+    channels      = juce::jlimit (1, kMaxChannels, numChannels);
+    maxPartitions = juce::jmax (1, maxNumPartitions);
+    delayLineSize = maxPartitions + kNumSlots;
+
+    inputs.setSize   (channels, kNumSlots * kPartitionSize);
+    segments.setSize (channels, kNumSlots * kPartitionSize);
+
+    for (auto* scratch : { &inlineScratch, &workerScratch })
+    {
+        scratch->fftBuffer.assign (static_cast<size_t> (kFFTSize * 2), 0.0f);
+        scratch->output.setSize (channels, kPartitionSize);
+
+        for (auto& spectrum : scratch->spectra)
+            spectrum.assign (static_cast<size_t> (kNumBins), {});
+    }
+
+    for (auto& line : delayLine)
+        line.assign (static_cast<size_t> (delayLineSize),
+                     std::vector<std::complex<float>> (static_cast<size_t> (kNumBins)));
+
+    reset();
+}
+
+void AsyncTailConvolver::release()
+{
+    if (pool == nullptr)
+        return;
+
+    pool->cancel (job);
+    pool = nullptr;
+    poolHandle.reset();
+    tail = nullptr;
+
+    inputs.setSize (0, 0);
+    segments.setSize (0, 0);
+
+    for (auto* scratch : { &inlineScratch, &workerScratch })
+    {
+        scratch->fftBuffer = {};
+        scratch->output.setSize (0, 0);
+
+        for (auto& spectrum : scratch->spectra)
+            spectrum = {};
+    }
+
+    for (auto& line : delayLine)
+        line = {};
+}
+
+void AsyncTailConvolver::reset()
+{
+    // Never waits: a run still on a worker is abandoned, and the history it
+    // reads is cleared once it has stopped
+    if (pool != nullptr)
+        pool->abandon (job);
+
+    submittedChunk = -1;
+    clearPending   = true;
+
+    if (job.isIdle())
+        clearHistory();
+}
+
+void AsyncTailConvolver::clearHistory()
+{
+    inputs.clear();
+    segments.clear();
+
+    for (auto& line : delayLine)
+        for (auto& spectrum : line)
+            std::fill (spectrum.begin(), spectrum.end(), std::complex<float>());
+
+    chunkFill    = 0;
+    chunkIndex   = 0;
+    clearPending = false;
+}
+
+size_t AsyncTailConvolver::getMemoryBytes() const
+{
+    size_t bytes = MemoryFootprint::bytesOf (inputs) + MemoryFootprint::bytesOf (segments)
+                 + MemoryFootprint::bytesOf (delayLine);
+
+    for (const auto* scratch : { &inlineScratch, &workerScratch })
+        bytes += MemoryFootprint::bytesOf (scratch->fftBuffer) + MemoryFootprint::bytesOf (scratch->output)
+               + MemoryFootprint::bytesOf (scratch->spectra[0]) * static_cast<size_t> (kMaxChannels);
+
+    return bytes;
+}
+
+void AsyncTailConvolver::setTail (const Tail* newTail)
+{
+    if (newTail != nullptr && newTail->numPartitions == 0)
+        newTail = nullptr;
+
+    reset();
+    tail = newTail;
+}
+
+//==============================================================================
+void AsyncTailConvolver::process (const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output)
+{
+    if (tail == nullptr)
+        return;
+
+    // After a reset, nothing until an abandoned run has let go of the history
+    if (clearPending)
+    {
+        if (! job.isIdle())
+            return;
+
+        clearHistory();
+    }
+
+    const int numSamples = input.getNumSamples();
+    const int chs = juce::jmin (channels, input.getNumChannels(), output.getNumChannels());
+
+    int pos = 0;
+
+    while (pos < numSamples)
+    {
+        const int n = juce::jmin (numSamples - pos, kPartitionSize - chunkFill);
+
+        // The tail starts two partitions into the IR, so this chunk hears
+        // the segment computed from the input two chunks ago
+        const auto segment = chunkIndex - 2;
+        const int  slot    = static_cast<int> (chunkIndex % kNumSlots) * kPartitionSize;
+
+        if (segment >= 0)
+        {
+            const int offset = static_cast<int> (segment % kNumSlots) * kPartitionSize + chunkFill;
+
+            for (int ch = 0; ch < chs; ++ch)
+                output.addFrom (ch, pos, segments, ch, offset, n);
+        }
+
+        for (int ch = 0; ch < chs; ++ch)
+            inputs.copyFrom (ch, slot + chunkFill, input, ch, pos, n);
+
+        chunkFill += n;
+        pos       += n;
+
+        if (chunkFill == kPartitionSize)
+        {
+            // Deadline for the previous partition: its segment is read from the next sample on
+            if (chunkIndex > 0)
+                finishPartition (chunkIndex - 1);
+
+            startPartition (chunkIndex);
+
+            ++chunkIndex;
+            chunkFill = 0;
+        }
+    }
+}
+
+void AsyncTailConvolver::startPartition (juce::int64 chunk)
+{
+    submittedChunk = -1;
+
+    // Still busy with a run that was abandoned: this partition is done inline at its deadline
+    if (! job.isIdle())
+        return;
+
+    jobChunkIndex = chunk;
+    jobTail       = tail;
+
+    if (pool->submit (job))
+        submittedChunk = chunk;
+}
+
+void AsyncTailConvolver::finishPartition (juce::int64 chunk)
+{
+    if (submittedChunk == chunk && pool->complete (job))
+    {
+        commitPartition (chunk, workerScratch);
+        return;
+    }
+
+    computePartition (chunk, *tail, inlineScratch, nullptr);
+    commitPartition (chunk, inlineScratch);
+}
+
+void AsyncTailConvolver::commitPartition (juce::int64 chunk, const Scratch& scratch)
+{
+    const auto linePos    = static_cast<size_t> (chunk % delayLineSize);
+    const int  slotOffset = static_cast<int> (chunk % kNumSlots) * kPartitionSize;
+
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        const auto& spectrum = scratch.spectra[static_cast<size_t> (ch)];
+        std::copy (spectrum.begin(), spectrum.end(), delayLine[static_cast<size_t> (ch)][linePos].begin());
+        segments.copyFrom (ch, slotOffset, scratch.output, ch, 0, kPartitionSize);
+    }
+}
+
+//==============================================================================
+void AsyncTailConvolver::computePartition (juce::int64 chunk, const Tail& t, Scratch& scratch,
+                                           const PartitionJob* runner)
+{
+    const int numPartitions = juce::jmin (t.numPartitions, maxPartitions);
+    const auto* current     = inputs.getArrayOfReadPointers();
+    const int currentSlot   = static_cast<int> (chunk % kNumSlots) * kPartitionSize;
+    const int previousSlot  = static_cast<int> ((chunk + kNumSlots - 1) % kNumSlots) * kPartitionSize;
+    auto* bins = reinterpret_cast<std::complex<float>*> (scratch.fftBuffer.data());
+
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        const auto& line = delayLine[static_cast<size_t> (ch)];
+        const auto& part = t.partitions[static_cast<size_t> (ch)];
+        auto& spectrum   = scratch.spectra[static_cast<size_t> (ch)];
+
+        // Forward transform of [previous chunk | this chunk]
+        std::fill (scratch.fftBuffer.begin(), scratch.fftBuffer.end(), 0.0f);
+        std::copy (current[ch] + previousSlot, current[ch] + previousSlot + kPartitionSize, scratch.fftBuffer.begin());
+        std::copy (current[ch] + currentSlot, current[ch] + currentSlot + kPartitionSize,
+                   scratch.fftBuffer.begin() + kPartitionSize);
+        scratch.fft.performRealOnlyForwardTransform (scratch.fftBuffer.data(), true);
+
+        std::copy (bins, bins + kNumBins, spectrum.begin());
+
+        // Multiply-accumulate every partition against its delayed input
+        // spectrum: this chunk's from the scratch, earlier ones from the history
+        std::fill (scratch.fftBuffer.begin(), scratch.fftBuffer.end(), 0.0f);
+
+        for (int k = 0; k < numPartitions; ++k)
+        {
+            if (runner != nullptr && runner->isAbandoned())
+                return;
+
+            const auto& x = k == 0 ? spectrum
+                                   : line[static_cast<size_t> ((chunk - k + delayLineSize) % delayLineSize)];
+            const auto& h = part[static_cast<size_t> (k)];
+
+            for (int b = 0; b < kNumBins; ++b)
+                bins[b] += x[static_cast<size_t> (b)] * h[static_cast<size_t> (b)];
+        }
+
+        scratch.fft.performRealOnlyInverseTransform (scratch.fftBuffer.data());
+
+        // Overlap-save: only the second half is valid output
+        scratch.output.copyFrom (ch, 0, scratch.fftBuffer.data() + kPartitionSize, kPartitionSize);
+    }
+}
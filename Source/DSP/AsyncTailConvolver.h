@@ -0,0 +1,128 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <complex>
+#include <optional>
+#include "ConvolutionWorkerPool.h"
+
+//==============================================================================
+/**
+    Convolves with the late part of an IR (everything after kHeadLength) on
+    the shared ConvolutionWorkerPool.  The head stays with the caller's own
+    zero-latency convolver.
+
+    The tail is split into uniform partitions of kPartitionSize.  Each time a
+    full partition of input has arrived it's handed to the pool, and its
+    result is first needed kPartitionSize samples later (because the tail
+    starts kHeadLength = 2 * kPartitionSize into the IR).  If no worker has
+    got to it by then, the audio thread runs the job itself; if a worker
+    has but is running late, the audio thread computes the partition with
+    its own scratch buffers and the worker's run is abandoned.
+
+    A run only reads the input and spectrum history and writes its own
+    scratch; the audio thread copies a finished run's result into the
+    history.  The history keeps kNumSlots chunks more than the tail needs,
+    so an abandoned run that is still reading has that many partitions'
+    grace before its slots are reused.  reset() never waits either: the
+    history is cleared once any abandoned run has stopped.
+*/
+class AsyncTailConvolver
+{
+public:
+    static constexpr int kPartitionSize = 2048;
+    static constexpr int kHeadLength    = 2 * kPartitionSize;
+    static constexpr int kMaxChannels   = 2;
+
+    /** Frequency-domain partitions of one IR tail, built off the audio thread. */
+    struct Tail
+    {
+        int numPartitions = 0;
+        // [channel][partition] -> kPartitionSize + 1 bins
+        std::array<std::vector<std::vector<std::complex<float>>>, kMaxChannels> partitions;
+    };
+
+    /** Splits off and transforms everything after kHeadLength.  Empty if ir is shorter. */
+    static Tail makeTail (const juce::AudioBuffer<float>& ir);
+
+    AsyncTailConvolver();
+    ~AsyncTailConvolver();
+
+    /** Allocates for tails of up to maxPartitions partitions, and joins the shared pool. */
+    void prepare (int numChannels, int maxPartitions);
+    void reset();
+
+    /** Frees the buffers and lets go of the pool (stopping its workers if nothing else holds it). */
+    void release();
+
+    /** Heap bytes of the prepared buffers; tails belong to whoever made them. */
+    size_t getMemoryBytes() const;
+
+    /** Swaps in a tail prepared by makeTail (nullptr = none).  No allocation. */
+    void setTail (const Tail* newTail);
+    bool isActive() const { return tail != nullptr; }
+
+    /** True when no worker is still reading a tail, so one replaced by setTail() can be freed. */
+    bool isIdle() const { return job.isIdle(); }
+
+    /** Feeds the dry input and adds the tail's contribution into output. */
+    void process (const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output);
+
+private:
+    static constexpr int kFFTOrder     = 12;                   // 2 * kPartitionSize
+    static constexpr int kFFTSize      = 1 << kFFTOrder;
+    static constexpr int kNumBins      = kFFTSize / 2 + 1;
+    static constexpr int kNumSlots     = 4;                    // input chunks and output segments in flight
+
+    /** Where one computation of a partition goes; the worker's run and the audio thread each have one. */
+    struct Scratch
+    {
+        juce::dsp::FFT fft { kFFTOrder };
+        std::vector<float> fftBuffer;
+        std::array<std::vector<std::complex<float>>, kMaxChannels> spectra;   // this chunk's input
+        juce::AudioBuffer<float> output;                                     // the tail's segment
+    };
+
+    /** One partition's worth of work, run by the pool. */
+    struct PartitionJob : public ConvolutionWorkerPool::Job
+    {
+        explicit PartitionJob (AsyncTailConvolver& o) : owner (o) {}
+        void run() override { owner.computePartition (owner.jobChunkIndex, *owner.jobTail, owner.workerScratch, this); }
+        AsyncTailConvolver& owner;
+    };
+
+    void computePartition (juce::int64 chunk, const Tail& t, Scratch& scratch, const PartitionJob* runner);
+    void commitPartition (juce::int64 chunk, const Scratch& scratch);
+    void finishPartition (juce::int64 chunk);
+    void startPartition (juce::int64 chunk);
+    void clearHistory();
+
+    // Only held between prepare() and release(), so the workers only run while tails do
+    std::optional<juce::SharedResourcePointer<ConvolutionWorkerPool>> poolHandle;
+    ConvolutionWorkerPool* pool = nullptr;
+    PartitionJob job { *this };
+
+    const Tail* tail = nullptr;
+    int channels = 2;
+
+    // Audio-thread side.  inputs holds the last kNumSlots chunks, the
+    // current one filling; segments the finished output of as many
+    juce::AudioBuffer<float> inputs, segments;
+    int     chunkFill  = 0;
+    juce::int64 chunkIndex = 0;
+    juce::int64 submittedChunk = -1;   // the chunk the pool has, if any
+    bool    clearPending = false;
+    Scratch inlineScratch;
+
+    // Handed to the job at submit, and only while it's idle
+    juce::int64 jobChunkIndex = 0;
+    const Tail* jobTail = nullptr;
+    Scratch workerScratch;
+
+    // Input spectra of the last maxPartitions + kNumSlots chunks, by chunk index
+    std::array<std::vector<std::vector<std::complex<float>>>, kMaxChannels> delayLine;
+    int delayLineSize = 0;
+    int maxPartitions = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (AsyncTailConvolver)
+};
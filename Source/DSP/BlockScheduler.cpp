@@ -0,0 +1,30 @@
+#include "BlockScheduler.h"
+#include "MemoryFootprint.h"
+
+//==============================================================================
+void BlockScheduler::prepare (int numChannels, int maxHostBlockSize, Mode newMode, int newBlockSize)
+{
+    mode         = newMode;
+    channels     = numChannels;
+    maxHostBlock = juce::jmax (1, maxHostBlockSize);
+    blockSize    = juce::jmax (1, newBlockSize);
+
+    for (auto& block : blocks)
+        block.setSize (numChannels, mode == Mode::buffered ? blockSize : 0);
+
+    reset();
+}
+
+void BlockScheduler::reset()
+{
+    for (auto& block : blocks)
+        block.clear();
+
+    current = 0;
+    filled  = 0;
+}
+
+size_t BlockScheduler::getMemoryBytes() const
+{
+    return MemoryFootprint::bytesOf (blocks);
+}
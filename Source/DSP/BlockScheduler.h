@@ -0,0 +1,108 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+/**
+    Decides what block sizes the chain sees, whatever the host sends.
+
+    Hosts split buffers at loop points and automation changes, so process()
+    can arrive with anything from 1 sample to more than the prepared size.
+    Every chain call has a fixed cost (flag checks, convolver bookkeeping,
+    resampler frames), which dominates at a handful of samples.
+
+      - host:     chunks of at most the host's prepared size, as delivered
+      - slice:    chunks of at most blockSize; zero latency, so small host
+                  buffers still reach the chain as they are
+      - buffered: always exactly blockSize.  Input is collected until a
+                  block is full and output is played a block behind, so the
+                  cost per sample stays flat for any host pattern, at the
+                  price of blockSize samples of latency
+
+    process() is allocation-free; both buffered blocks are sized in prepare().
+*/
+class BlockScheduler
+{
+public:
+    enum class Mode
+    {
+        host,
+        slice,
+        buffered
+    };
+
+    static constexpr int kDefaultBlockSize = 256;   // a multiple of RateConverter::kMaxFactor
+
+    void prepare (int numChannels, int maxHostBlockSize, Mode mode, int blockSize = kDefaultBlockSize);
+    void reset();
+
+    /** Heap bytes of the two buffered blocks (zero unless buffered). */
+    size_t getMemoryBytes() const;
+
+    Mode getMode() const { return mode; }
+
+    /** Largest block the callback is handed: what the chain should be prepared for. */
+    int getMaxBlockSize() const { return mode == Mode::host ? maxHostBlock : blockSize; }
+
+    /** blockSize when buffered, otherwise zero. */
+    int getLatencySamples() const { return mode == Mode::buffered ? blockSize : 0; }
+
+    /** Runs processBlock (juce::AudioBuffer<float>&) over buffer according to the mode. */
+    template <typename ProcessBlock>
+    void process (juce::AudioBuffer<float>& buffer, ProcessBlock&& processBlock)
+    {
+        const int numSamples  = buffer.getNumSamples();
+        const int numChannels = juce::jmin (buffer.getNumChannels(), channels);
+
+        if (mode != Mode::buffered)
+        {
+            const int maxChunk = getMaxBlockSize();
+
+            for (int start = 0; start < numSamples; start += maxChunk)
+            {
+                juce::AudioBuffer<float> chunk (buffer.getArrayOfWritePointers(), numChannels, start,
+                                                juce::jmin (maxChunk, numSamples - start));
+                processBlock (chunk);
+            }
+
+            return;
+        }
+
+        for (int pos = 0; pos < numSamples;)
+        {
+            auto& input  = blocks[static_cast<size_t> (current)];
+            auto& output = blocks[static_cast<size_t> (1 - current)];
+            const int count = juce::jmin (numSamples - pos, blockSize - filled);
+
+            // Host input into the filling block, then the block processed last time out
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                input.copyFrom (ch, filled, buffer, ch, pos, count);
+                buffer.copyFrom (ch, pos, output, ch, filled, count);
+            }
+
+            filled += count;
+            pos    += count;
+
+            if (filled == blockSize)
+            {
+                juce::AudioBuffer<float> block (input.getArrayOfWritePointers(), numChannels, blockSize);
+                processBlock (block);
+
+                current = 1 - current;
+                filled  = 0;
+            }
+        }
+    }
+
+private:
+    Mode mode = Mode::host;
+    int  channels     = 2;
+    int  maxHostBlock = 512;
+    int  blockSize    = kDefaultBlockSize;
+
+    // Buffered mode: one block filling with input while the other plays out
+    std::array<juce::AudioBuffer<float>, 2> blocks;
+    int current = 0;
+    int filled  = 0;
+};
@@ -0,0 +1,200 @@
+#include "CabinModel.h"
+#include "ImpulseResponse.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr float kSpeedOfSound    = 343.0f;   // m/s
+    constexpr float kEarOffset       = 0.08f;    // m either side of the head centre
+    constexpr float kMinDistance     = 0.2f;     // clamp for the 1/r gain
+    constexpr float kCrossoverHz     = 2500.0f;
+    constexpr float kShadowHz        = 2500.0f;  // far-ear head shadow
+    constexpr float kShadowGainDb    = -2.0f;
+
+    struct Point { float x, y; };
+
+    Point getHeadPosition (CabinModel::Seat seat)
+    {
+        switch (seat)
+        {
+            case CabinModel::Seat::passenger: return {  0.37f,  0.0f  };
+            case CabinModel::Seat::rear:      return {  0.0f,  -0.85f };
+            case CabinModel::Seat::driver:
+            default:                          return { -0.37f,  0.0f  };
+        }
+    }
+
+    void applyBandFilters (CabinModel::Band band, float* data, int numSamples, double sampleRate)
+    {
+        using Coefs = juce::dsp::IIR::Coefficients<float>;
+        std::vector<Coefs::Ptr> stages;
+
+        switch (band)
+        {
+            case CabinModel::Band::woofer:
+                stages = { Coefs::makeLowPass (sampleRate, kCrossoverHz, 0.707f),
+                           Coefs::makeLowPass (sampleRate, kCrossoverHz, 0.707f) };
+                break;
+
+            case CabinModel::Band::tweeter:
+                stages = { Coefs::makeHighPass (sampleRate, kCrossoverHz, 0.707f),
+                           Coefs::makeHighPass (sampleRate, kCrossoverHz, 0.707f) };
+                break;
+
+            case CabinModel::Band::fullRange:
+                stages = { Coefs::makeHighPass (sampleRate, 80.0f, 0.707f),
+                           Coefs::makeLowPass (sampleRate, 10000.0f, 0.707f) };
+                break;
+        }
+
+        for (auto& coefs : stages)
+        {
+            juce::dsp::IIR::Filter<float> filter (coefs);
+
+            for (int s = 0; s < numSamples; ++s)
+                data[s] = filter.processSample (data[s]);
+        }
+    }
+
+    /**
+        A cascade of first-order allpasses, different for every source: the
+        magnitude response of the cabin IR is kept but its phase is not, so
+        sources that share it no longer sum coherently into a comb.
+    */
+    void decorrelate (size_t sourceIndex, float* data, int numSamples)
+    {
+        constexpr int kStages = 4;
+        const float sign = sourceIndex % 2 == 0 ? 1.0f : -1.0f;
+
+        for (int stage = 0; stage < kStages; ++stage)
+        {
+            const float a = sign * (0.2f + 0.1f * static_cast<float> (sourceIndex / 2 + static_cast<size_t> (stage)));
+            float x1 = 0.0f, y1 = 0.0f;
+
+            for (int s = 0; s < numSamples; ++s)
+            {
+                const float y = -a * data[s] + x1 + a * y1;
+                x1 = data[s];
+                y1 = y;
+                data[s] = y;
+            }
+        }
+    }
+
+    float energyOf (const float* data, int numSamples)
+    {
+        float energy = 0.0f;
+
+        for (int s = 0; s < numSamples; ++s)
+            energy += data[s] * data[s];
+
+        return energy;
+    }
+}
+
+//==============================================================================
+const std::vector<CabinModel::Speaker>& CabinModel::getSedanSpeakers()
+{
+    static const std::vector<Speaker> speakers {
+        { "Front left door woofer",  -0.78f,  0.55f, 0, Band::woofer,     0.0f },
+        { "Front right door woofer",  0.78f,  0.55f, 1, Band::woofer,     0.0f },
+        { "Left dash tweeter",       -0.65f,  1.05f, 0, Band::tweeter,    0.0f },
+        { "Right dash tweeter",       0.65f,  1.05f, 1, Band::tweeter,    0.0f },
+        { "Rear deck left",          -0.55f, -1.35f, 0, Band::fullRange, -4.0f },   // fader biased to the front
+        { "Rear deck right",          0.55f, -1.35f, 1, Band::fullRange, -4.0f },
+    };
+
+    return speakers;
+}
+
+juce::AudioBuffer<float> CabinModel::buildTrueStereoIR (const std::vector<Speaker>& speakers, Seat seat,
+                                                        const juce::AudioBuffer<float>& cabinIR, float wetMix,
+                                                        double sampleRate)
+{
+    const int cabinLength = cabinIR.getNumChannels() > 0 ? cabinIR.getNumSamples() : 0;
+    const int length      = cabinLength + static_cast<int> (std::ceil (kMaxPathSeconds * sampleRate));
+    const int maxDelay    = static_cast<int> (sampleRate * kMaxPathSeconds * 0.5);
+    const float shadowCoef = std::exp (-juce::MathConstants<float>::twoPi * kShadowHz
+                                       / static_cast<float> (sampleRate));
+    const float shadowGain = juce::Decibels::decibelsToGain (kShadowGainDb);
+    const auto head = getHeadPosition (seat);
+
+    juce::AudioBuffer<float> result (ImpulseResponse::numTrueStereoPaths, length);
+    result.clear();
+
+    std::vector<float> path (static_cast<size_t> (length));
+    std::vector<float> wet (static_cast<size_t> (cabinLength));
+
+    for (size_t i = 0; i < speakers.size(); ++i)
+    {
+        const auto& speaker = speakers[i];
+        const int input = juce::jlimit (0, 1, speaker.inputChannel);
+
+        for (int ear = 0; ear < 2; ++ear)
+        {
+            const float earX     = head.x + (ear == 0 ? -kEarOffset : kEarOffset);
+            const float distance = std::hypot (speaker.x - earX, speaker.y - head.y);
+            const int   delay    = juce::jmin (maxDelay, juce::roundToInt (distance / kSpeedOfSound * sampleRate));
+            const float gain     = juce::Decibels::decibelsToGain (speaker.gainDb)
+                                 / juce::jmax (kMinDistance, distance);
+
+            // Dry impulse plus the cabin's response at this ear, arriving after the flight time
+            std::fill (path.begin(), path.end(), 0.0f);
+            path[static_cast<size_t> (delay)] = gain * (1.0f - wetMix);
+
+            if (cabinLength > 0)
+            {
+                const int cabinChannel = juce::jmin (ear, cabinIR.getNumChannels() - 1);
+                std::copy_n (cabinIR.getReadPointer (cabinChannel), cabinLength, wet.begin());
+                decorrelate (i, wet.data(), cabinLength);
+
+                for (int s = 0; s < cabinLength; ++s)
+                    path[static_cast<size_t> (delay + s)] += wet[static_cast<size_t> (s)] * gain * wetMix;
+            }
+
+            applyBandFilters (speaker.band, path.data(), length, sampleRate);
+
+            // The head shadows the ear facing away from the source
+            const bool farEar = (ear == 0) ? speaker.x > head.x + 0.1f : speaker.x < head.x - 0.1f;
+
+            if (farEar)
+            {
+                float state = 0.0f;
+
+                for (auto& sample : path)
+                {
+                    state  = sample * shadowGain * (1.0f - shadowCoef) + state * shadowCoef;
+                    sample = state;
+                }
+            }
+
+            result.addFrom (input * 2 + ear, 0, path.data(), length);
+        }
+    }
+
+    // A centred signal should reach each ear with the energy of one plain
+    // path, the dry impulse blended with the cabin IR at wetMix.  Measured
+    // on the summed IR, so band splits, shadowing and any summing of the
+    // sources are all accounted for
+    float targetEnergy = 0.0f, centredEnergy = 0.0f;
+    std::vector<float> centred (static_cast<size_t> (length));
+
+    for (int ear = 0; ear < 2; ++ear)
+    {
+        const float wetEnergy = cabinLength > 0
+                                  ? energyOf (cabinIR.getReadPointer (juce::jmin (ear, cabinIR.getNumChannels() - 1)), cabinLength)
+                                  : 0.0f;
+        targetEnergy += (1.0f - wetMix) * (1.0f - wetMix) + wetMix * wetMix * wetEnergy;
+
+        juce::FloatVectorOperations::add (centred.data(), result.getReadPointer (ear),
+                                          result.getReadPointer (2 + ear), length);
+        centredEnergy += energyOf (centred.data(), length);
+    }
+
+    if (centredEnergy > 0.0f && targetEnergy > 0.0f)
+        result.applyGain (std::sqrt (targetEnergy / centredEnergy));
+
+    ImpulseResponse::trim (result);
+    return result;
+}
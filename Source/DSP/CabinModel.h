@@ -0,0 +1,69 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+/**
+    Multi-speaker car cabin: a handful of speaker sources (door woofers, dash
+    tweeters, rear deck), each with its own crossover filter, distance delay,
+    distance gain and cabin IR to the ears of a chosen seat.
+
+    Every source is linear and time-invariant and is fed from one input
+    channel, so all sources sharing an input collapse into a single path to
+    each ear.  The whole cabin is therefore one true-stereo IR per seat
+    (ImpulseResponse::TrueStereoPath order), run by TrueStereoConvolver at the
+    cost of a single 2x2 convolution however many speakers there are.
+*/
+namespace CabinModel
+{
+    enum class Seat : juce::uint8
+    {
+        driver,
+        passenger,
+        rear
+    };
+
+    static constexpr int numSeats = 3;
+
+    /** Crossover band a source reproduces. */
+    enum class Band
+    {
+        woofer,      // LR4 low-pass at the crossover
+        tweeter,     // LR4 high-pass at the crossover
+        fullRange    // small rear-deck driver: band-limited both ends
+    };
+
+    struct Speaker
+    {
+        const char* name;
+        // Position in metres: x = right of the cabin centre line, y = forward of the front seat headrests
+        float x, y;
+        int   inputChannel;   // 0 = left, 1 = right
+        Band  band;
+        float gainDb;
+    };
+
+    /** The Sedan's six sources: door woofers, dash tweeters, rear deck. */
+    const std::vector<Speaker>& getSedanSpeakers();
+
+    /** Longest extra length (propagation delay + filter ring) a source path adds to the cabin IR. */
+    static constexpr double kMaxPathSeconds = 0.02;
+
+    /**
+        Sums every speaker's path to both ears of seat into a 4-channel
+        true-stereo IR.  Each path is the speaker's dry impulse blended with
+        cabinIR (the ear's channel) at wetMix, delayed and attenuated by
+        distance, band-filtered, and head-shadowed for the far ear.
+
+        There is one measured cabin IR, not one per speaker position, so each
+        source gets its own allpass-decorrelated copy of it: the reflections
+        keep the cabin's colour but don't comb-filter against each other the
+        way identical, merely delayed copies would.  The result is scaled so a
+        centred signal reaches each ear with the energy of one plain
+        dry-plus-cabin path, measured on the summed IR.
+    */
+    juce::AudioBuffer<float> buildTrueStereoIR (const std::vector<Speaker>& speakers, Seat seat,
+                                                const juce::AudioBuffer<float>& cabinIR, float wetMix,
+                                                double sampleRate);
+}
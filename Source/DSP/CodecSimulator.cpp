@@ -0,0 +1,346 @@
+#include "CodecSimulator.h"
+#include "DspKernels.h"
+#include "MemoryFootprint.h"
+#include <cmath>
+#include <iterator>
+
+//==============================================================================
+void CodecSimulator::prepare (double sr, int numChannels)
+{
+    sampleRate = sr;
+    channels   = juce::jmax (1, numChannels);
+
+    // A power of two near kHopSeconds, so the FFT is radix-2 at any rate
+    const int order = juce::jmax (5, juce::roundToInt (std::log2 (sampleRate * kHopSeconds)));
+    hopSize = 1 << order;
+
+    const int half = hopSize / 2;
+    fft = std::make_unique<juce::dsp::FFT> (order - 1);
+
+    analysisWindow.resize (static_cast<size_t> (2 * hopSize));
+    synthesisWindow.resize (static_cast<size_t> (2 * hopSize));
+
+    for (int n = 0; n < 2 * hopSize; ++n)
+    {
+        const auto w = static_cast<float> (std::sin (juce::MathConstants<double>::pi * (n + 0.5) / (2 * hopSize)));
+        analysisWindow[static_cast<size_t> (n)]  = w;
+        synthesisWindow[static_cast<size_t> (n)] = w * 2.0f / static_cast<float> (hopSize);
+    }
+
+    preTwiddles.resize (static_cast<size_t> (half));
+    postTwiddles.resize (static_cast<size_t> (half));
+
+    for (int k = 0; k < half; ++k)
+    {
+        preTwiddles[static_cast<size_t> (k)]  = std::polar (1.0f, static_cast<float> (-juce::MathConstants<double>::pi * (k + 0.25) / hopSize));
+        postTwiddles[static_cast<size_t> (k)] = std::polar (1.0f, static_cast<float> (-juce::MathConstants<double>::pi * k / hopSize));
+    }
+
+    fftIn.resize (static_cast<size_t> (half));
+    fftOut.resize (static_cast<size_t> (half));
+    windowed.resize (static_cast<size_t> (2 * hopSize));
+    folded.resize (static_cast<size_t> (hopSize));
+
+    input.setSize (channels, 2 * hopSize);
+    overlap.setSize (channels, hopSize);
+    output.setSize (channels, hopSize);
+    spectra.setSize (channels, hopSize);
+    bandLevels.assign (static_cast<size_t> (channels * kMaxBands), 0.0f);
+
+    setSettings (settings);
+    reset();
+}
+
+void CodecSimulator::reset()
+{
+    input.clear();
+    overlap.clear();
+    output.clear();
+    fill   = 0;
+    primed = false;
+}
+
+size_t CodecSimulator::getMemoryBytes() const
+{
+    return MemoryFootprint::bytesOf (input) + MemoryFootprint::bytesOf (overlap)
+         + MemoryFootprint::bytesOf (output) + MemoryFootprint::bytesOf (spectra)
+         + MemoryFootprint::bytesOf (analysisWindow) + MemoryFootprint::bytesOf (synthesisWindow)
+         + MemoryFootprint::bytesOf (preTwiddles) + MemoryFootprint::bytesOf (postTwiddles)
+         + MemoryFootprint::bytesOf (fftIn) + MemoryFootprint::bytesOf (fftOut)
+         + MemoryFootprint::bytesOf (windowed) + MemoryFootprint::bytesOf (folded)
+         + MemoryFootprint::bytesOf (bandLevels);
+}
+
+void CodecSimulator::setSettings (const Settings& newSettings)
+{
+    settings = newSettings;
+    buildBands();
+}
+
+float CodecSimulator::getBandwidthHz (Codec codec, float bitrateKbps)
+{
+    // Typical encoder low-pass settings; clamped outside the table
+    struct Point { float kbps, hz; };
+    static constexpr Point sbc[] = { { 128.0f, 11000.0f }, { 192.0f, 14000.0f }, { 328.0f, 20000.0f } };
+    static constexpr Point aac[] = { {  64.0f, 11000.0f }, { 128.0f, 16000.0f }, { 256.0f, 19500.0f } };
+
+    if (codec == Codec::none)
+        return 0.0f;
+
+    const auto& table = codec == Codec::sbc ? sbc : aac;
+
+    if (bitrateKbps <= table[0].kbps)
+        return table[0].hz;
+
+    for (size_t i = 1; i < 3; ++i)
+        if (bitrateKbps <= table[i].kbps)
+            return juce::jmap (bitrateKbps, table[i - 1].kbps, table[i].kbps, table[i - 1].hz, table[i].hz);
+
+    return table[2].hz;
+}
+
+void CodecSimulator::buildBands()
+{
+    const double binHz = sampleRate / (2.0 * hopSize);
+    cutoffBin = juce::jlimit (0, hopSize, static_cast<int> (getBandwidthHz (settings.codec, settings.bitrateKbps) / binHz));
+    numBands  = 0;
+
+    auto addBand = [this] (int start, int end, float weight)
+    {
+        end = juce::jmin (end, cutoffBin);
+
+        if (end > start && numBands < kMaxBands)
+            bands[static_cast<size_t> (numBands++)] = { start, end, weight };
+    };
+
+    if (settings.codec == Codec::sbc)
+    {
+        // Eight equal subbands over the whole spectrum; SBC's loudness
+        // allocation gives the lower ones more bits
+        for (int b = 0; b < 8; ++b)
+        {
+            const int start = b * hopSize / 8;
+            const int end   = (b + 1) * hopSize / 8;
+            addBand (start, end, (start + end) * 0.5 * binHz < 3000.0 ? 0.5f : 1.0f);
+        }
+    }
+    else if (settings.codec == Codec::aac)
+    {
+        // Widening with frequency, roughly critical bands; more noise is allowed up high
+        static constexpr float edges[] = { 0.0f, 200.0f, 400.0f, 600.0f, 800.0f, 1000.0f, 1250.0f, 1500.0f,
+                                           1750.0f, 2000.0f, 2500.0f, 3000.0f, 3500.0f, 4000.0f, 5000.0f,
+                                           6000.0f, 7000.0f, 8000.0f, 10000.0f, 12000.0f, 14000.0f,
+                                           16000.0f, 18000.0f, 20000.0f };
+        constexpr int numEdges = static_cast<int> (std::size (edges));
+
+        for (int e = 0; e < numEdges; ++e)
+        {
+            const int start = juce::roundToInt (edges[e] / binHz);
+            const int end   = e + 1 < numEdges ? juce::roundToInt (edges[e + 1] / binHz) : hopSize;
+            const float centreHz = static_cast<float> ((start + end) * 0.5 * binHz);
+
+            addBand (start, end, 1.0f + (centreHz / 6000.0f) * (centreHz / 6000.0f));
+        }
+    }
+
+    // The stream's bits per frame, less a header and a scale factor per band and channel
+    frameBits = juce::jmax (0.0f, static_cast<float> (settings.bitrateKbps * 1000.0 * hopSize / sampleRate)
+                                    - 32.0f - 6.0f * static_cast<float> (numBands * channels));
+}
+
+//==============================================================================
+void CodecSimulator::process (juce::AudioBuffer<float>& buffer)
+{
+    const int numSamples = buffer.getNumSamples();
+    const int chs        = juce::jmin (buffer.getNumChannels(), channels);
+
+    for (int done = 0; done < numSamples;)
+    {
+        const int count = juce::jmin (numSamples - done, hopSize - fill);
+
+        for (int ch = 0; ch < chs; ++ch)
+        {
+            auto* data = buffer.getWritePointer (ch, done);
+            juce::FloatVectorOperations::copy (input.getWritePointer (ch, hopSize + fill), data, count);
+            juce::FloatVectorOperations::copy (data, output.getReadPointer (ch, fill), count);
+        }
+
+        fill += count;
+        done += count;
+
+        if (fill == hopSize)
+        {
+            processFrame();
+            fill = 0;
+        }
+    }
+}
+
+void CodecSimulator::processFrame()
+{
+    if (settings.codec == Codec::none || cutoffBin == 0)
+    {
+        // The same delay, untouched
+        for (int ch = 0; ch < channels; ++ch)
+            output.copyFrom (ch, 0, input, ch, 0, hopSize);
+
+        overlap.clear();
+        primed = false;
+    }
+    else
+    {
+        for (int ch = 0; ch < channels; ++ch)
+            forwardTransform (input.getReadPointer (ch), spectra.getWritePointer (ch));
+
+        allocateAndQuantise();
+
+        for (int ch = 0; ch < channels; ++ch)
+        {
+            inverseTransform (spectra.getReadPointer (ch), windowed.data());
+
+            // The first frame after a switch on has no previous frame to cancel
+            // its first half's time-domain aliasing, so that hop plays the dry
+            // delay instead and the frame only primes the overlap for the next
+            if (primed)
+                juce::FloatVectorOperations::add (output.getWritePointer (ch), overlap.getReadPointer (ch),
+                                                  windowed.data(), hopSize);
+            else
+                output.copyFrom (ch, 0, input, ch, 0, hopSize);
+
+            overlap.copyFrom (ch, 0, windowed.data() + hopSize, hopSize);
+        }
+
+        primed = true;
+    }
+
+    for (int ch = 0; ch < channels; ++ch)
+        input.copyFrom (ch, 0, input, ch, hopSize, hopSize);
+}
+
+//==============================================================================
+// MDCT as a DCT-IV of the folded frame, and the DCT-IV as a complex FFT of
+// half its length between two twiddle passes
+void CodecSimulator::forwardTransform (const float* frame, float* spectrum)
+{
+    const int half      = hopSize / 2;
+    const auto& kernels = DspKernels::get();
+    const float* x      = windowed.data();
+
+    juce::FloatVectorOperations::multiply (windowed.data(), frame, analysisWindow.data(), 2 * hopSize);
+
+    for (int n = 0; n < half; ++n)
+    {
+        folded[static_cast<size_t> (n)]        = -x[3 * half - 1 - n] - x[3 * half + n];
+        folded[static_cast<size_t> (half + n)] =  x[n] - x[hopSize - 1 - n];
+    }
+
+    for (int k = 0; k < half; ++k)
+        fftIn[static_cast<size_t> (k)] = { folded[static_cast<size_t> (2 * k)],
+                                           folded[static_cast<size_t> (hopSize - 1 - 2 * k)] };
+
+    kernels.complexMultiply (reinterpret_cast<float*> (fftIn.data()), reinterpret_cast<const float*> (preTwiddles.data()), half);
+    fft->perform (fftIn.data(), fftOut.data(), false);
+    kernels.complexMultiply (reinterpret_cast<float*> (fftOut.data()), reinterpret_cast<const float*> (postTwiddles.data()), half);
+
+    for (int k = 0; k < half; ++k)
+    {
+        spectrum[2 * k]               =  fftOut[static_cast<size_t> (k)].real();
+        spectrum[hopSize - 1 - 2 * k] = -fftOut[static_cast<size_t> (k)].imag();
+    }
+}
+
+void CodecSimulator::inverseTransform (const float* spectrum, float* frame)
+{
+    // The DCT-IV is its own inverse (the 2 / M is in the synthesis window); then unfold
+    const int half      = hopSize / 2;
+    const auto& kernels = DspKernels::get();
+
+    for (int k = 0; k < half; ++k)
+        fftIn[static_cast<size_t> (k)] = { spectrum[2 * k], spectrum[hopSize - 1 - 2 * k] };
+
+    kernels.complexMultiply (reinterpret_cast<float*> (fftIn.data()), reinterpret_cast<const float*> (preTwiddles.data()), half);
+    fft->perform (fftIn.data(), fftOut.data(), false);
+    kernels.complexMultiply (reinterpret_cast<float*> (fftOut.data()), reinterpret_cast<const float*> (postTwiddles.data()), half);
+
+    for (int k = 0; k < half; ++k)
+    {
+        folded[static_cast<size_t> (2 * k)]               =  fftOut[static_cast<size_t> (k)].real();
+        folded[static_cast<size_t> (hopSize - 1 - 2 * k)] = -fftOut[static_cast<size_t> (k)].imag();
+    }
+
+    const float* u = folded.data();
+
+    for (int n = 0; n < half; ++n)
+    {
+        frame[n]            =  u[half + n];
+        frame[half + n]     = -u[hopSize - 1 - n];
+        frame[hopSize + n]  = -u[half - 1 - n];
+        frame[3 * half + n] = -u[n];
+    }
+
+    juce::FloatVectorOperations::multiply (frame, synthesisWindow.data(), 2 * hopSize);
+}
+
+//==============================================================================
+void CodecSimulator::allocateAndQuantise()
+{
+    const auto& kernels = DspKernels::get();
+    float maxLevel = -1000.0f;
+
+    // ---- 1. Band levels, and nothing above the encoder's bandwidth ----
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        auto* spectrum = spectra.getWritePointer (ch);
+        juce::FloatVectorOperations::clear (spectrum + cutoffBin, hopSize - cutoffBin);
+
+        for (int b = 0; b < numBands; ++b)
+        {
+            const auto& band = bands[static_cast<size_t> (b)];
+            float energy = 0.0f;
+
+            for (int i = band.start; i < band.end; ++i)
+                energy += spectrum[i] * spectrum[i];
+
+            const float level = std::log2 (energy / static_cast<float> (band.end - band.start) + 1.0e-20f)
+                                  - std::log2 (band.weight);
+            bandLevels[static_cast<size_t> (ch * kMaxBands + b)] = level;
+            maxLevel = juce::jmax (maxLevel, level);
+        }
+    }
+
+    // ---- 2. Water-filling: the noise level (log2, per bin at weight 1) the frame's bits buy ----
+    // Each bin of a band above the noise costs half a bit per doubling of its level over it.
+    // A fixed number of bisection steps, down to 16 bits a bin (~96 dB), keeps the cost fixed
+    float low = maxLevel - 32.0f, high = maxLevel + 1.0f;
+
+    for (int step = 0; step < 20; ++step)
+    {
+        const float noise = 0.5f * (low + high);
+        float bits = 0.0f;
+
+        for (int ch = 0; ch < channels; ++ch)
+            for (int b = 0; b < numBands; ++b)
+                bits += static_cast<float> (bands[static_cast<size_t> (b)].end - bands[static_cast<size_t> (b)].start)
+                          * juce::jmax (0.0f, 0.5f * (bandLevels[static_cast<size_t> (ch * kMaxBands + b)] - noise));
+
+        if (bits > frameBits)
+            low = noise;
+        else
+            high = noise;
+    }
+
+    // ---- 3. Uniform quantiser per band with the step for that noise (step^2 / 12) ----
+    // Bands under the noise level round to zero: the encoder had no bits for them
+    const float noisePower = std::exp2 (high);
+
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        auto* spectrum = spectra.getWritePointer (ch);
+
+        for (int b = 0; b < numBands; ++b)
+        {
+            const auto& band = bands[static_cast<size_t> (b)];
+            kernels.quantise (spectrum + band.start, std::sqrt (12.0f * band.weight * noisePower), band.end - band.start);
+        }
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <complex>
+
+//==============================================================================
+/**
+    Lossy perceptual codec artefacts without an encoder: what a Bluetooth
+    link (SBC) or a streaming service (AAC) does to the audio before the
+    device plays it.
+
+    The signal runs through an MDCT filterbank (sine window, about 5 ms
+    hops, computed with an FFT of a quarter of the window) and every frame's
+    spectrum is quantised the way an encoder's bit allocation would:
+
+      - the bins above the encoder's bitrate-dependent bandwidth are dropped;
+      - the rest are grouped into scale-factor bands, eight uniform ones for
+        SBC or widening, Bark-like ones for AAC;
+      - a water-filling allocation spreads the frame's bits (the bitrate less
+        side info) over the bands of every channel, and each band is
+        quantised with the step that allocation implies.
+
+    Bands the budget can't reach are zeroed, which gives the spectral holes
+    and "birdies" of a starved encoder.  A transient's quantisation noise
+    spreads over the whole window, which is the codec's pre-echo.
+
+    Cost is fixed per frame, whatever the signal: two transforms per
+    channel, a fixed number of allocation iterations and one quantising
+    pass.  The FIFO runs one hop behind, so a host block does at most one
+    frame per hop it spans.  Output is the input delayed by
+    getLatencySamples(), with Codec::none too, so presets with and without
+    a codec line up.  Switching on from Codec::none plays one more hop of
+    the dry delay while the first frame fills the overlap, so the codec
+    comes in on a whole overlap-add rather than with a click.
+*/
+class CodecSimulator
+{
+public:
+    enum class Codec
+    {
+        none,
+        sbc,
+        aac
+    };
+
+    struct Settings
+    {
+        Codec codec       = Codec::none;
+        float bitrateKbps = 328.0f;   // the whole stream, all channels
+    };
+
+    void prepare (double sampleRate, int numChannels);
+    void reset();
+
+    /** Heap bytes of the FIFOs, the spectra and the FFT's work buffers. */
+    size_t getMemoryBytes() const;
+
+    /** Allocation-free; takes effect at the next frame. */
+    void setSettings (const Settings& newSettings);
+
+    /** Two hops: one to fill a frame, one for the next frame's overlap-add. */
+    int getLatencySamples() const { return 2 * hopSize; }
+
+    void process (juce::AudioBuffer<float>& buffer);
+
+    /** The audio bandwidth an encoder keeps at a bitrate. */
+    static float getBandwidthHz (Codec codec, float bitrateKbps);
+
+    static constexpr double kHopSeconds = 0.0053;   // 256 samples at 44.1 / 48 kHz
+
+private:
+    void processFrame();
+    void forwardTransform (const float* frame, float* spectrum);
+    void inverseTransform (const float* spectrum, float* frame);
+    void allocateAndQuantise();
+    void buildBands();
+
+    Settings settings;
+    double sampleRate = 44100.0;
+    int channels      = 2;
+    int hopSize       = 256;
+    int fill          = 0;
+    bool primed       = false;   // overlap holds a coded frame's second half
+
+    // MDCT: window (analysis, and synthesis with the 2 / M scale), twiddles, FFT of hopSize / 2 points
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::vector<float> analysisWindow, synthesisWindow;
+    std::vector<std::complex<float>> preTwiddles, postTwiddles, fftIn, fftOut;
+    std::vector<float> windowed, folded;
+
+    // Per channel: the last two hops of input, the previous frame's second
+    // half, and the hop of output being played out
+    juce::AudioBuffer<float> input, overlap, output;
+    juce::AudioBuffer<float> spectra;
+
+    // Scale-factor bands for the current settings
+    struct Band
+    {
+        int   start  = 0;
+        int   end    = 0;
+        float weight = 1.0f;   // noise allowed relative to the others
+    };
+
+    static constexpr int kMaxBands = 32;
+    std::array<Band, kMaxBands> bands {};
+    int numBands = 0;
+    int cutoffBin = 0;
+    float frameBits = 0.0f;
+    std::vector<float> bandLevels;   // log2 (energy / weight), [channel * kMaxBands + band]
+};
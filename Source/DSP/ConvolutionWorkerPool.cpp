@@ -0,0 +1,208 @@
+#include "ConvolutionWorkerPool.h"
+
+//==============================================================================
+class ConvolutionWorkerPool::Worker : public juce::Thread
+{
+public:
+    Worker (ConvolutionWorkerPool& p, int i)
+        : juce::Thread ("Car Test convolution " + juce::String (i)), pool (p), index (i) {}
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            auto* job = pool.takeJob (index);
+
+            // Nothing queued: sleep until submit() has something
+            if (job == nullptr && ! pool.sleepUntilWoken (index, job))
+                continue;
+
+            if (job != nullptr)
+                pool.tryRun (*job);
+        }
+    }
+
+private:
+    ConvolutionWorkerPool& pool;
+    const int index;
+};
+
+//==============================================================================
+ConvolutionWorkerPool::ConvolutionWorkerPool()
+{
+    // Leave one core for the host's own audio / UI threads
+    const int numWorkers = juce::jmax (1, juce::SystemStats::getNumCpus() - 1);
+
+    for (int i = 0; i < numWorkers; ++i)
+        queues.push_back (std::make_unique<Queue>());
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        workers.push_back (std::make_unique<Worker> (*this, i));
+        workers.back()->startThread (juce::Thread::Priority::high);
+    }
+}
+
+ConvolutionWorkerPool::~ConvolutionWorkerPool()
+{
+    for (auto& w : workers)
+        w->signalThreadShouldExit();
+
+    wakeUp.release (static_cast<std::ptrdiff_t> (workers.size()));
+
+    for (auto& w : workers)
+        w->stopThread (1000);
+}
+
+//==============================================================================
+bool ConvolutionWorkerPool::submit (Job& job)
+{
+    // Only the submitter moves a job out of idle, so nothing can start it between these
+    if (! job.isIdle())
+        return false;
+
+    job.abandoned.store (false, std::memory_order_relaxed);
+    job.state.store (Job::queued, std::memory_order_release);
+
+    const auto numQueues = static_cast<unsigned int> (queues.size());
+    const auto start     = nextQueue.fetch_add (1, std::memory_order_relaxed);
+
+    for (unsigned int attempt = 0; attempt < numQueues; ++attempt)
+    {
+        auto& q = *queues[static_cast<size_t> ((start + attempt) % numQueues)];
+        bool queued = false;
+
+        {
+            const juce::SpinLock::ScopedTryLockType lock (q.lock);
+
+            if (lock.isLocked() && q.count < kQueueSize)
+            {
+                q.jobs[static_cast<size_t> ((q.head + q.count) % kQueueSize)] = &job;
+                ++q.count;
+                queued = true;
+            }
+        }
+
+        if (queued)
+        {
+            // Pairs with sleepUntilWoken(): either a sleeper is seen here, or it sees the job
+            std::atomic_thread_fence (std::memory_order_seq_cst);
+
+            if (sleepingWorkers.load() > 0)
+                wakeUp.release();
+
+            return true;
+        }
+    }
+
+    // Nowhere to put it: do the work now rather than miss the deadline
+    tryRun (job);
+    return true;
+}
+
+bool ConvolutionWorkerPool::complete (Job& job)
+{
+    if (tryRun (job))
+        return true;
+
+    const auto start  = juce::Time::getHighResolutionTicks();
+    const auto budget = juce::Time::secondsToHighResolutionTicks (kMaxWaitMicroseconds * 1.0e-6);
+
+    while (job.state.load (std::memory_order_acquire) == Job::running)
+    {
+        if (juce::Time::getHighResolutionTicks() - start > budget)
+        {
+            // A worker that's this late has probably been preempted; let it go
+            job.abandoned.store (true, std::memory_order_relaxed);
+            return false;
+        }
+
+        juce::Thread::yield();
+    }
+
+    return true;
+}
+
+void ConvolutionWorkerPool::abandon (Job& job)
+{
+    // Its queue entry, if any, goes stale and falls through tryRun()
+    int expected = Job::queued;
+    job.state.compare_exchange_strong (expected, Job::idle, std::memory_order_acq_rel);
+
+    if (job.state.load (std::memory_order_acquire) == Job::running)
+        job.abandoned.store (true, std::memory_order_relaxed);
+}
+
+void ConvolutionWorkerPool::cancel (Job& job)
+{
+    for (auto& q : queues)
+    {
+        const juce::SpinLock::ScopedLockType lock (q->lock);
+
+        int kept = 0;
+        for (int i = 0; i < q->count; ++i)
+        {
+            auto* queued = q->jobs[static_cast<size_t> ((q->head + i) % kQueueSize)];
+
+            if (queued != &job)
+                q->jobs[static_cast<size_t> ((q->head + kept++) % kQueueSize)] = queued;
+        }
+
+        q->count = kept;
+    }
+
+    int expected = Job::queued;
+    job.state.compare_exchange_strong (expected, Job::idle, std::memory_order_acq_rel);
+
+    while (job.state.load (std::memory_order_acquire) == Job::running)
+        juce::Thread::yield();
+}
+
+//==============================================================================
+ConvolutionWorkerPool::Job* ConvolutionWorkerPool::takeJob (int workerIndex)
+{
+    const int numQueues = static_cast<int> (queues.size());
+
+    // Own queue first, then steal from the others
+    for (int i = 0; i < numQueues; ++i)
+    {
+        auto& q = *queues[static_cast<size_t> ((workerIndex + i) % numQueues)];
+        const juce::SpinLock::ScopedLockType lock (q.lock);
+
+        if (q.count > 0)
+        {
+            auto* job = q.jobs[static_cast<size_t> (q.head)];
+            q.head = (q.head + 1) % kQueueSize;
+            --q.count;
+            return job;
+        }
+    }
+
+    return nullptr;
+}
+
+bool ConvolutionWorkerPool::sleepUntilWoken (int workerIndex, Job*& job)
+{
+    // Counted as asleep before the last look, so a job queued after it always wakes someone
+    sleepingWorkers.fetch_add (1);
+    job = takeJob (workerIndex);
+
+    if (job == nullptr)
+        wakeUp.acquire();
+
+    sleepingWorkers.fetch_sub (1);
+    return job != nullptr;
+}
+
+bool ConvolutionWorkerPool::tryRun (Job& job)
+{
+    // Whoever flips queued -> running owns the job; stale queue entries just fall through
+    int expected = Job::queued;
+
+    if (! job.state.compare_exchange_strong (expected, Job::running, std::memory_order_acq_rel))
+        return false;
+
+    job.run();
+    job.state.store (Job::idle, std::memory_order_release);
+    return true;
+}
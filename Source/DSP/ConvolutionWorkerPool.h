@@ -0,0 +1,107 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <semaphore>
+
+//==============================================================================
+/**
+    Process-wide pool of worker threads shared by every Car Test instance.
+
+    Hold one through a juce::SharedResourcePointer: the first holder starts
+    the workers, the last one to go away stops them.  AsyncTailConvolver only
+    holds one while it's prepared, so a session without async tails never
+    starts them.  Each worker owns a small queue; idle workers steal from the
+    others, so a few heavy instances spread across all cores instead of
+    piling onto one.
+
+    Jobs have a deadline owned by the submitter: complete() either claims a
+    job nobody has started yet and runs it on the calling thread, or waits a
+    bounded time for the worker that is already running it.  If that worker
+    is still at it then, its run is abandoned and the submitter does the
+    work itself.  The audio thread never waits on a job that is merely
+    queued, nor for longer than kMaxWaitMicroseconds on one that isn't.
+
+    Nothing the audio thread calls takes a lock it could block on:
+    submit() only try-locks the queues.  Workers with nothing to do sleep
+    until submit() wakes one, on a semaphore rather than a WaitableEvent:
+    releasing it is an atomic add and, only if a worker is asleep, a kernel
+    wake, where signalling the event would lock its mutex.
+*/
+class ConvolutionWorkerPool
+{
+public:
+    ConvolutionWorkerPool();
+    ~ConvolutionWorkerPool();
+
+    //==========================================================================
+    class Job
+    {
+    public:
+        virtual ~Job() = default;
+        virtual void run() = 0;
+
+        bool isIdle() const { return state.load (std::memory_order_acquire) == idle; }
+
+        /** True once the submitter has stopped waiting for this run; run() may return early. */
+        bool isAbandoned() const { return abandoned.load (std::memory_order_relaxed); }
+
+    private:
+        friend class ConvolutionWorkerPool;
+
+        enum State { idle, queued, running };
+        std::atomic<int> state { idle };
+        std::atomic<bool> abandoned { false };
+    };
+
+    /**
+        Queues a job.  If every queue is full, the job is run on the calling
+        thread.  False, and nothing queued, if an abandoned run of it is still
+        going.
+    */
+    bool submit (Job& job);
+
+    /**
+        Makes sure job has finished, running it here if no worker has picked
+        it up.  False if a worker is still running it after
+        kMaxWaitMicroseconds: that run is abandoned, and the caller has to
+        do the work some other way.
+    */
+    bool complete (Job& job);
+
+    /** Unqueues job without waiting; a run in progress is abandoned.  For the audio thread. */
+    void abandon (Job& job);
+
+    /** Removes job from every queue and waits for it if a worker is running it. */
+    void cancel (Job& job);
+
+    static constexpr int kMaxWaitMicroseconds = 250;
+
+    int getNumWorkers() const { return static_cast<int> (workers.size()); }
+
+private:
+    class Worker;
+
+    static constexpr int kQueueSize = 64;
+
+    struct Queue
+    {
+        juce::SpinLock lock;
+        std::array<Job*, kQueueSize> jobs {};
+        int head = 0, count = 0;
+    };
+
+    Job* takeJob (int workerIndex);
+    bool tryRun (Job& job);
+
+    /** A worker's wait for submit(); false if there was a job after all, which is then in job. */
+    bool sleepUntilWoken (int workerIndex, Job*& job);
+
+    std::vector<std::unique_ptr<Queue>>  queues;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<unsigned int> nextQueue { 0 };
+
+    std::counting_semaphore<> wakeUp { 0 };
+    std::atomic<int> sleepingWorkers { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (ConvolutionWorkerPool)
+};
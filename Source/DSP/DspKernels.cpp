@@ -0,0 +1,246 @@
+#include "DspKernels.h"
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <cmath>
+
+namespace DspKernels
+{
+    namespace GenericKernels { extern const Table table; }
+   #if CARTEST_X86_KERNELS
+    namespace Avx2Kernels    { extern const Table table; }
+    namespace Avx512Kernels  { extern const Table table; }
+   #endif
+
+namespace
+{
+    std::atomic<const Table*> activeTable { nullptr };
+    std::atomic<Isa>          activeIsa   { Isa::generic };
+
+    const Table* getBuiltTable (Isa isa)
+    {
+        switch (isa)
+        {
+            case Isa::generic: return &GenericKernels::table;
+           #if CARTEST_X86_KERNELS
+            case Isa::avx2:    return &Avx2Kernels::table;
+            case Isa::avx512:  return &Avx512Kernels::table;
+           #endif
+            default:           return nullptr;
+        }
+    }
+
+    Isa chooseIsa()
+    {
+        const auto requested = juce::SystemStats::getEnvironmentVariable ("CARTEST_ISA", {}).trim().toLowerCase();
+
+        for (auto isa : { Isa::generic, Isa::avx2, Isa::avx512 })
+        {
+            if (requested == getIsaName (isa))
+            {
+                if (isSupported (isa))
+                    return isa;
+
+                DBG ("CARTEST_ISA=" << requested << " isn't supported here; choosing automatically");
+            }
+        }
+
+        for (auto isa : { Isa::avx512, Isa::avx2 })
+            if (isSupported (isa))
+                return isa;
+
+        return Isa::generic;
+    }
+
+    void activate (Isa isa)
+    {
+        activeIsa.store (isa, std::memory_order_relaxed);
+        activeTable.store (getBuiltTable (isa), std::memory_order_release);
+    }
+}
+
+//==============================================================================
+const Table& get()
+{
+    if (auto* table = activeTable.load (std::memory_order_acquire))
+        return *table;
+
+    // Racing first calls all pick the same variant, so whichever store lands is fine
+    activate (chooseIsa());
+    return *activeTable.load (std::memory_order_acquire);
+}
+
+Isa getActiveIsa()
+{
+    get();
+    return activeIsa.load (std::memory_order_relaxed);
+}
+
+bool isSupported (Isa isa)
+{
+    if (getBuiltTable (isa) == nullptr)
+        return false;
+
+    switch (isa)
+    {
+        case Isa::avx2:
+            return juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3();
+
+        case Isa::avx512:
+            return juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3()
+                    && juce::SystemStats::hasAVX512F() && juce::SystemStats::hasAVX512VL()
+                    && juce::SystemStats::hasAVX512DQ();
+
+        case Isa::generic:
+        default:
+            return true;
+    }
+}
+
+const char* getIsaName (Isa isa)
+{
+    switch (isa)
+    {
+        case Isa::avx2:    return "avx2";
+        case Isa::avx512:  return "avx512";
+        case Isa::generic:
+        default:           return "generic";
+    }
+}
+
+const Table* getTable (Isa isa)
+{
+    return isSupported (isa) ? getBuiltTable (isa) : nullptr;
+}
+
+bool forceIsa (Isa isa)
+{
+    if (! isSupported (isa))
+        return false;
+
+    activate (isa);
+    return true;
+}
+
+//==============================================================================
+std::string verifyVariants()
+{
+    constexpr int numSamples = 1031;   // odd, so every vector loop has a remainder
+    constexpr int numStages  = 4;
+
+    const auto& reference = *getBuiltTable (Isa::generic);
+    juce::String failures;
+
+    // Relative to the reference's peak: FMA contraction is the only expected difference
+    auto compare = [&failures] (Isa isa, const char* kernel, const std::vector<float>& expected,
+                                const std::vector<float>& actual, float tolerance)
+    {
+        float peak = 1.0e-6f, worst = 0.0f;
+
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            peak  = juce::jmax (peak, std::abs (expected[i]));
+            worst = juce::jmax (worst, std::abs (expected[i] - actual[i]));
+        }
+
+        if (! (worst <= tolerance * peak))
+            failures << getIsaName (isa) << " " << kernel << ": error " << worst / peak
+                     << " relative to generic\n";
+    };
+
+    juce::Random random (0x5eed);
+    auto makeSignal = [&random] (float low, float high)
+    {
+        std::vector<float> v (static_cast<size_t> (numSamples));
+        for (auto& x : v)
+            x = juce::jmap (random.nextFloat(), low, high);
+        return v;
+    };
+
+    const auto a      = makeSignal (-1.0f, 1.0f);
+    const auto b      = makeSignal (-1.0f, 1.0f);
+    const auto mags   = makeSignal (0.0f, 2.0f);
+    const auto phases = makeSignal (0.0f, juce::MathConstants<float>::twoPi * 0.99999f);
+    const auto levels = makeSignal (0.0f, 1.5f);
+    const auto gainDb = makeSignal (-60.0f, 12.0f);
+
+    // A stiffening curve like SpeakerDriver's, driven well into the clamp at both ends
+    std::vector<float> curve (257 + 1);
+    for (size_t i = 0; i < 257; ++i)
+        curve[i] = std::tanh ((static_cast<float> (i) / 128.0f - 1.0f) * 4.0f);
+    curve[257] = curve[256];
+
+    // Close to the presets' cascade at 48 kHz: a 35 Hz high-pass, a low-pass and two peaks
+    const BiquadCoefficients stages[numStages] = {
+        { 0.99677f, -1.99354f, 0.99677f, -1.99353f, 0.99355f },
+        { 0.17508f,  0.35016f, 0.17508f, -0.51930f, 0.21963f },
+        { 1.00641f, -1.98163f, 0.97560f, -1.98163f, 0.98201f },
+        { 1.04190f, -1.53024f, 0.64520f, -1.53024f, 0.68710f }
+    };
+
+    for (auto isa : { Isa::avx2, Isa::avx512 })
+    {
+        const auto* table = getTable (isa);
+        if (table == nullptr)
+            continue;
+
+        auto run = [&] (const Table& t, int kernel)
+        {
+            auto x = a, y = b;
+            std::vector<float> out (static_cast<size_t> (numSamples * 2));
+
+            switch (kernel)
+            {
+                case 0:
+                {
+                    float* channels[] = { x.data(), y.data(), out.data() };
+                    std::copy (a.begin(), a.end(), out.begin());
+                    BiquadState states[3 * numStages] {};
+                    t.biquadCascade (channels, 3, numSamples, stages, numStages, states);
+                    break;
+                }
+                case 1:  t.addScaled (x.data(), b.data(), 0.37f, numSamples); break;
+                case 2:  t.multiplyAdd (x.data(), b.data(), mags.data(), numSamples); break;
+                case 3:  t.scale (x.data(), 1.19f, numSamples); break;
+                case 4:  t.blend (x.data(), b.data(), 0.3f, 0.7f, numSamples); break;
+                case 5:  t.stereoWidth (x.data(), y.data(), 0.6f, numSamples); break;
+                case 6:  t.polarToComplex (out.data(), mags.data(), phases.data(), numSamples); break;
+                case 7:
+                {
+                    float* channels[] = { x.data(), y.data() };
+                    PreciseBiquadCoefficients precise[numStages];
+                    PreciseBiquadState states[2 * numStages] {};
+
+                    for (int s = 0; s < numStages; ++s)
+                        precise[s] = { stages[s].b0, stages[s].b1, stages[s].b2, stages[s].a1, stages[s].a2 };
+
+                    t.biquadCascadePrecise (channels, 2, numSamples, precise, numStages, states);
+                    break;
+                }
+                case 8:  t.tableShaper (x.data(), numSamples, curve.data(), 256, 0.3f, 0.8f); break;
+                case 9:  t.complexMultiply (x.data(), b.data(), numSamples / 2); break;
+                case 10: t.quantise (x.data(), 0.0625f, numSamples); break;
+                case 11: x = levels; t.gainComputer (x.data(), numSamples, 20.0f, -10.0f, -0.9f, 4.0f); break;
+                case 12: x = gainDb; t.dbToGain (x.data(), numSamples); break;
+                default: break;
+            }
+
+            std::vector<float> all (x);
+            all.insert (all.end(), y.begin(), y.end());
+            all.insert (all.end(), out.begin(), out.end());
+            return all;
+        };
+
+        const char* names[] = { "biquadCascade", "addScaled", "multiplyAdd", "scale",
+                                "blend", "stereoWidth", "polarToComplex", "biquadCascadePrecise", "tableShaper",
+                                "complexMultiply", "quantise", "gainComputer", "dbToGain" };
+
+        // The 35 Hz high-pass's poles sit just inside the unit circle and magnify rounding
+        // differences ~100x (measured ~1e-4 between generic and avx2), hence its looser bound
+        for (int kernel = 0; kernel < 13; ++kernel)
+            compare (isa, names[kernel], run (reference, kernel), run (*table, kernel),
+                     kernel == 0 ? 1.0e-3f : 1.0e-5f);
+    }
+
+    return failures.toStdString();
+}
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+// No JUCE here: this is included by the per-ISA kernel translation units, and
+// an inline function they instantiate with AVX-512 flags could be the copy the
+// linker keeps for every caller.
+#include <string>
+
+//==============================================================================
+/**
+    The hot per-sample loops of EnvironmentProcessor, NoiseGenerator and
+    LinkedCompressor, compiled several times with different instruction sets
+    and chosen once at startup.
+
+    DspKernelsImpl.h holds the only implementation.  It is plain C++ written
+    so the compiler can vectorise it, and is compiled into:
+
+      - generic:  the build's baseline (SSE2 on x86-64, NEON on arm64)
+      - avx2:     AVX2 + FMA            (x86-64 builds only)
+      - avx512:   AVX-512 F / VL / DQ   (x86-64 builds only)
+
+    get() returns the best table the CPU supports, unless CARTEST_ISA
+    (generic / avx2 / avx512) is set in the environment or forceIsa() was
+    called.  Variants can differ by FMA rounding only; verifyVariants()
+    checks every supported one against generic.
+*/
+namespace DspKernels
+{
+    enum class Isa
+    {
+        generic,
+        avx2,
+        avx512
+    };
+
+    /** Normalised coefficients (a0 = 1), transposed direct form II. */
+    struct BiquadCoefficients
+    {
+        float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+    };
+
+    struct BiquadState
+    {
+        float z1 = 0.0f, z2 = 0.0f;
+    };
+
+    /** Double-precision coefficients and state, for the offline high-quality chain. */
+    struct PreciseBiquadCoefficients
+    {
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+    };
+
+    struct PreciseBiquadState
+    {
+        double z1 = 0.0, z2 = 0.0;
+    };
+
+    struct Table
+    {
+        /** Runs numStages biquads in series on each channel; states are [channel * numStages + stage].
+            The channels' filters are interleaved per stage so their dependency chains overlap. */
+        void (*biquadCascade) (float* const* channels, int numChannels, int numSamples,
+                               const BiquadCoefficients* coefficients, int numStages, BiquadState* states);
+
+        /** biquadCascade with double coefficients and accumulation; samples stay float. */
+        void (*biquadCascadePrecise) (float* const* channels, int numChannels, int numSamples,
+                                      const PreciseBiquadCoefficients* coefficients, int numStages,
+                                      PreciseBiquadState* states);
+
+        /** dst[i] += src[i] * gain */
+        void (*addScaled) (float* dst, const float* src, float gain, int numSamples);
+
+        /** dst[i] += a[i] * b[i] */
+        void (*multiplyAdd) (float* dst, const float* a, const float* b, int numSamples);
+
+        /** data[i] *= gain */
+        void (*scale) (float* data, float gain, int numSamples);
+
+        /** wet[i] = dry[i] * dryGain + wet[i] * wetGain */
+        void (*blend) (float* wet, const float* dry, float dryGain, float wetGain, int numSamples);
+
+        /** Mid / side width: side scaled by width, mid untouched. */
+        void (*stereoWidth) (float* left, float* right, float width, int numSamples);
+
+        /** Interleaved complex bins from magnitudes and phases in [0, 2 pi). */
+        void (*polarToComplex) (float* interleaved, const float* magnitudes, const float* phases, int numBins);
+
+        /** data[i] = f (data[i] * inputScale) * outputScale, f linearly interpolated from table:
+            tableSize + 1 points evenly spanning [-1, 1], then a copy of the last.  Clamps outside. */
+        void (*tableShaper) (float* data, int numSamples, const float* table, int tableSize,
+                             float inputScale, float outputScale);
+
+        /** data[i] *= factors[i], both interleaved complex. */
+        void (*complexMultiply) (float* data, const float* factors, int numComplex);
+
+        /** data[i] rounded to the nearest multiple of step (values beyond 2^22 steps pass through). */
+        void (*quantise) (float* data, float step, int numSamples);
+
+        /** data[i] from a detector level (>= 0) to a soft-knee compressor's gain change in dB:
+            levelScale * log10 (level) against thresholdDb, times slope (1 / ratio - 1) above
+            it, and a quadratic across the kneeDb around it.  Good to ~1e-5 dB. */
+        void (*gainComputer) (float* data, int numSamples, float levelScale, float thresholdDb,
+                              float slope, float kneeDb);
+
+        /** data[i] from decibels to linear gain, 10^(data[i] / 20).  Saturates at 2^-126 and 2^127. */
+        void (*dbToGain) (float* data, int numSamples);
+    };
+
+    /** The table in use.  Chosen on the first call; cheap afterwards. */
+    const Table& get();
+
+    Isa  getActiveIsa();
+    bool isSupported (Isa isa);
+    const char* getIsaName (Isa isa);
+
+    /** A specific variant, or nullptr if this build or CPU doesn't have it. */
+    const Table* getTable (Isa isa);
+
+    /** Testing override.  Call before any processing starts.  Returns false if isa isn't supported. */
+    bool forceIsa (Isa isa);
+
+    /** Runs every kernel of every supported variant against generic on random data.
+        Returns a line describing each mismatch, or an empty string if they all agree. */
+    std::string verifyVariants();
+}
@@ -0,0 +1,3 @@
+// Built with AVX2 + FMA (see CMakeLists.txt); only used when the CPU reports both.
+#define CARTEST_KERNEL_NAMESPACE Avx2Kernels
+#include "DspKernelsImpl.h"
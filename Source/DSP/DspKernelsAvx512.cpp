@@ -0,0 +1,3 @@
+// Built with AVX-512 F / VL / DQ (see CMakeLists.txt); only used when the CPU reports them.
+#define CARTEST_KERNEL_NAMESPACE Avx512Kernels
+#include "DspKernelsImpl.h"
@@ -0,0 +1,3 @@
+// The build's baseline instruction set: always compiled, always available.
+#define CARTEST_KERNEL_NAMESPACE GenericKernels
+#include "DspKernelsImpl.h"
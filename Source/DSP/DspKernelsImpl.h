@@ -0,0 +1,318 @@
+// Included once by each DspKernels<Isa>.cpp, with CARTEST_KERNEL_NAMESPACE
+// naming the variant.  No #pragma once, and nothing from outside this file
+// beyond DspKernels.h and <bit> (bit_cast is a compiler builtin, so there's no
+// out-of-line copy to share): each inclusion is a separate build of the same code.
+
+#include "DspKernels.h"
+#include <bit>
+#include <cstdint>
+
+#ifndef CARTEST_KERNEL_NAMESPACE
+ #error "Define CARTEST_KERNEL_NAMESPACE before including DspKernelsImpl.h"
+#endif
+
+namespace DspKernels
+{
+namespace CARTEST_KERNEL_NAMESPACE
+{
+namespace
+{
+    //==============================================================================
+    // Stage-major, two channels at a time: within a stage each channel is one
+    // serial dependency chain, so running a pair keeps two of them in flight.
+    void biquadPair (float* left, float* right, int numSamples, const BiquadCoefficients c,
+                     BiquadState& leftState, BiquadState& rightState)
+    {
+        float l1 = leftState.z1,  l2 = leftState.z2;
+        float r1 = rightState.z1, r2 = rightState.z2;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float xl = left[i];
+            const float xr = right[i];
+            const float yl = c.b0 * xl + l1;
+            const float yr = c.b0 * xr + r1;
+
+            l1 = c.b1 * xl - c.a1 * yl + l2;
+            r1 = c.b1 * xr - c.a1 * yr + r2;
+            l2 = c.b2 * xl - c.a2 * yl;
+            r2 = c.b2 * xr - c.a2 * yr;
+
+            left[i]  = yl;
+            right[i] = yr;
+        }
+
+        leftState  = { l1, l2 };
+        rightState = { r1, r2 };
+    }
+
+    void biquadSingle (float* data, int numSamples, const BiquadCoefficients c, BiquadState& state)
+    {
+        float z1 = state.z1, z2 = state.z2;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float x = data[i];
+            const float y = c.b0 * x + z1;
+
+            z1 = c.b1 * x - c.a1 * y + z2;
+            z2 = c.b2 * x - c.a2 * y;
+            data[i] = y;
+        }
+
+        state = { z1, z2 };
+    }
+
+    void biquadCascade (float* const* channels, int numChannels, int numSamples,
+                        const BiquadCoefficients* coefficients, int numStages, BiquadState* states)
+    {
+        for (int stage = 0; stage < numStages; ++stage)
+        {
+            int ch = 0;
+
+            for (; ch + 1 < numChannels; ch += 2)
+                biquadPair (channels[ch], channels[ch + 1], numSamples, coefficients[stage],
+                            states[ch * numStages + stage], states[(ch + 1) * numStages + stage]);
+
+            if (ch < numChannels)
+                biquadSingle (channels[ch], numSamples, coefficients[stage], states[ch * numStages + stage]);
+        }
+    }
+
+    // Sample-major: the signal stays in double between stages, so only the
+    // final result is rounded to float
+    void biquadCascadePrecise (float* const* channels, int numChannels, int numSamples,
+                               const PreciseBiquadCoefficients* coefficients, int numStages,
+                               PreciseBiquadState* states)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* data  = channels[ch];
+            auto* state = states + ch * numStages;
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                double x = data[i];
+
+                for (int stage = 0; stage < numStages; ++stage)
+                {
+                    const auto& c = coefficients[stage];
+                    auto& s = state[stage];
+                    const double y = c.b0 * x + s.z1;
+
+                    s.z1 = c.b1 * x - c.a1 * y + s.z2;
+                    s.z2 = c.b2 * x - c.a2 * y;
+                    x = y;
+                }
+
+                data[i] = static_cast<float> (x);
+            }
+        }
+    }
+
+    //==============================================================================
+    void addScaled (float* __restrict dst, const float* __restrict src, float gain, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+            dst[i] += src[i] * gain;
+    }
+
+    void multiplyAdd (float* __restrict dst, const float* __restrict a, const float* __restrict b, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+            dst[i] += a[i] * b[i];
+    }
+
+    void scale (float* data, float gain, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+            data[i] *= gain;
+    }
+
+    void blend (float* __restrict wet, const float* __restrict dry, float dryGain, float wetGain, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+            wet[i] = dry[i] * dryGain + wet[i] * wetGain;
+    }
+
+    void stereoWidth (float* __restrict left, float* __restrict right, float width, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float mid  = (left[i] + right[i]) * 0.5f;
+            const float side = (left[i] - right[i]) * 0.5f * width;
+
+            left[i]  = mid + side;
+            right[i] = mid - side;
+        }
+    }
+
+    //==============================================================================
+    // Branch-free sin / cos so the loop vectorises (std::sin / std::cos are
+    // library calls).  The phase is shifted to x in [-pi, pi) and folded onto
+    // y in [-pi/2, pi/2], where the Taylor series below are good to ~1e-7.
+    void polarToComplex (float* __restrict interleaved, const float* __restrict magnitudes,
+                         const float* __restrict phases, int numBins)
+    {
+        constexpr float pi     = 3.14159265358979f;
+        constexpr float halfPi = 1.57079632679490f;
+
+        for (int i = 0; i < numBins; ++i)
+        {
+            const float x    = phases[i] - pi;          // sin (phase) = -sin (x), cos (phase) = -cos (x)
+            const float sign = x < 0.0f ? -1.0f : 1.0f;
+            const float fold = x * sign > halfPi ? 1.0f : 0.0f;      // float selects: a bool here stops GCC vectorising
+            const float y    = x + fold * (sign * pi - 2.0f * x);   // sin (y) = sin (x), cos (y) = +-cos (x)
+            const float y2   = y * y;
+
+            const float s = y * (1.0f + y2 * (-1.0f / 6.0f + y2 * (1.0f / 120.0f + y2 * (-1.0f / 5040.0f
+                              + y2 * (1.0f / 362880.0f + y2 * (-1.0f / 39916800.0f))))));
+            const float c = 1.0f + y2 * (-0.5f + y2 * (1.0f / 24.0f + y2 * (-1.0f / 720.0f + y2 * (1.0f / 40320.0f
+                              + y2 * (-1.0f / 3628800.0f + y2 * (1.0f / 479001600.0f))))));
+
+            const float m = magnitudes[i];
+            interleaved[2 * i]     = m * (2.0f * fold - 1.0f) * c;
+            interleaved[2 * i + 1] = -m * s;
+        }
+    }
+
+    //==============================================================================
+    // Clamped with selects and truncated rather than floored (the position is
+    // never negative), so the loop vectorises with a gather for the lookups
+    void tableShaper (float* __restrict data, int numSamples, const float* __restrict table, int tableSize,
+                      float inputScale, float outputScale)
+    {
+        const float half   = 0.5f * static_cast<float> (tableSize);
+        const float scale  = inputScale * half;
+        const float maxPos = static_cast<float> (tableSize);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            float pos = data[i] * scale + half;
+            pos = pos < 0.0f ? 0.0f : pos;
+            pos = pos > maxPos ? maxPos : pos;
+
+            const int   index = static_cast<int> (pos);
+            const float frac  = pos - static_cast<float> (index);
+            const float a     = table[index];
+            const float b     = table[index + 1];
+
+            data[i] = (a + frac * (b - a)) * outputScale;
+        }
+    }
+
+    //==============================================================================
+    void complexMultiply (float* __restrict data, const float* __restrict factors, int numComplex)
+    {
+        for (int i = 0; i < numComplex; ++i)
+        {
+            const float re = data[2 * i],    im = data[2 * i + 1];
+            const float fr = factors[2 * i], fi = factors[2 * i + 1];
+
+            data[2 * i]     = re * fr - im * fi;
+            data[2 * i + 1] = re * fi + im * fr;
+        }
+    }
+
+    // Rounds by adding and subtracting 1.5 * 2^23, which leaves no fraction
+    // bits (ties to even), rather than std::round or an int conversion,
+    // neither of which vectorises; float selects keep the range check
+    // branch-free
+    void quantise (float* data, float step, int numSamples)
+    {
+        constexpr float limit = 4194304.0f;    // 2^22: the trick's range
+        constexpr float magic = 12582912.0f;   // 1.5 * 2^23
+        const float inverse = 1.0f / step;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float x       = data[i];
+            const float q       = x * inverse;
+            const float inRange = (q < limit ? 1.0f : 0.0f) * (q > -limit ? 1.0f : 0.0f);
+            const float rounded = (q * inRange + magic) - magic;
+
+            data[i] = x + inRange * (rounded * step - x);
+        }
+    }
+
+    //==============================================================================
+    // log2 from the float's exponent plus a series for its mantissa, folded onto
+    // [sqrt (1/2), sqrt (2)) so the atanh series converges fast.  The fold, abs
+    // and max (over, 0) are integer or arithmetic rather than float selects:
+    // GCC sinks the arms of those into branches and then won't vectorise.
+    // The 1e-9 added to the level keeps log10 (0) finite, as a floor would.
+    void gainComputer (float* data, int numSamples, float levelScale, float thresholdDb,
+                       float slope, float kneeDb)
+    {
+        const float log2Scale  = levelScale * 0.301029995663981f;    // log10 (2)
+        const float halfKnee   = kneeDb * 0.5f;
+        const float kneeLimit  = kneeDb > 0.0f ? halfKnee : -1.0f;  // -1: never inside the knee
+        const float kneeFactor = kneeDb > 0.0f ? slope / (2.0f * kneeDb) : 0.0f;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto  bits     = std::bit_cast<std::int32_t> (data[i] + 1.0e-9f);
+            const auto  mantissa = bits & 0x007fffff;
+            const auto  fold     = mantissa > 0x003504f3 ? 1 : 0;    // above sqrt (2)
+            const float m        = std::bit_cast<float> (mantissa | (0x3f800000 - (fold << 23)));
+            const float e        = static_cast<float> ((bits >> 23) - 127 + fold);
+            const float z        = (m - 1.0f) / (m + 1.0f);
+            const float z2       = z * z;
+            const float lnM      = 2.0f * z * (1.0f + z2 * (1.0f / 3.0f + z2 * (1.0f / 5.0f + z2 * (1.0f / 7.0f))));
+
+            const float over    = log2Scale * (e + lnM * 1.44269504088896f) - thresholdDb;
+            const float absOver = std::bit_cast<float> (std::bit_cast<std::int32_t> (over) & 0x7fffffff);
+            const float hard    = slope * 0.5f * (over + absOver);
+            const float k       = over + halfKnee;
+            const float soft    = kneeFactor * k * k;
+            const float inKnee  = absOver <= kneeLimit ? 1.0f : 0.0f;
+
+            data[i] = hard + inKnee * (soft - hard);
+        }
+    }
+
+    // 2^t as 2^round (t) * 2^f, |f| <= 1/2: the integer part goes straight into
+    // the exponent bits (read back from the rounding trick's sum, and clamped
+    // as an integer for the same reason as above), the rest is a Taylor series
+    void dbToGain (float* data, int numSamples)
+    {
+        constexpr float magic = 12582912.0f;   // 1.5 * 2^23
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float t       = data[i] * 0.166096404744368f;   // log2 (10) / 20
+            const float shifted = t + magic;
+            const float f       = (t - (shifted - magic)) * 0.693147180559945f;
+            const float p       = 1.0f + f * (1.0f + f * (0.5f + f * (1.0f / 6.0f + f * (1.0f / 24.0f
+                                    + f * (1.0f / 120.0f + f * (1.0f / 720.0f))))));
+
+            auto exponent = std::bit_cast<std::int32_t> (shifted) - 0x4b400000;
+            exponent = exponent < -126 ? -126 : exponent;
+            exponent = exponent > 127 ? 127 : exponent;
+
+            data[i] = p * std::bit_cast<float> ((exponent + 127) << 23);
+        }
+    }
+}
+
+//==============================================================================
+extern const Table table;
+
+const Table table
+{
+    biquadCascade,
+    biquadCascadePrecise,
+    addScaled,
+    multiplyAdd,
+    scale,
+    blend,
+    stereoWidth,
+    polarToComplex,
+    tableShaper,
+    complexMultiply,
+    quantise,
+    gainComputer,
+    dbToGain
+};
+}
+}
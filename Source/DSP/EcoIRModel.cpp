@@ -0,0 +1,225 @@
+#include "EcoIRModel.h"
+#include <cmath>
+
+namespace
+{
+    using IIRCoefs = juce::dsp::IIR::Coefficients<float>;
+
+    struct FitBand
+    {
+        double freq     = 0.0;
+        double targetDb = 0.0;
+    };
+
+    double sectionDb (const IIRCoefs& c, double freq, double sampleRate)
+    {
+        return juce::Decibels::gainToDecibels (c.getMagnitudeForFrequency (freq, sampleRate), -120.0);
+    }
+}
+
+//==============================================================================
+bool EcoIRModel::fit (const juce::AudioBuffer<float>& ir, double sampleRate, int numSectionsToUse)
+{
+    numSections     = 0;
+    outputGain      = 1.0f;
+    spectralErrorDb = 0.0f;
+    reset();
+
+    if (ir.getNumSamples() == 0 || ir.getNumChannels() == 0 || sampleRate <= 0.0)
+        return false;
+
+    // ---- Averaged power spectrum of the IR ----
+    const int fftOrder = juce::jlimit (10, 15, juce::roundToInt (std::ceil (std::log2 (ir.getNumSamples()))));
+    const int fftSize  = 1 << fftOrder;
+
+    juce::dsp::FFT fft (fftOrder);
+    std::vector<float> work (static_cast<size_t> (fftSize * 2));
+    std::vector<double> power (static_cast<size_t> (fftSize / 2 + 1), 0.0);
+
+    const int copyLength = juce::jmin (fftSize, ir.getNumSamples());
+
+    for (int ch = 0; ch < ir.getNumChannels(); ++ch)
+    {
+        std::fill (work.begin(), work.end(), 0.0f);
+        std::copy (ir.getReadPointer (ch), ir.getReadPointer (ch) + copyLength, work.begin());
+        fft.performFrequencyOnlyForwardTransform (work.data());
+
+        for (size_t bin = 0; bin < power.size(); ++bin)
+            power[bin] += static_cast<double> (work[bin]) * work[bin] / ir.getNumChannels();
+    }
+
+    // ---- Smooth into 1/6-octave bands ----
+    const double binHz  = sampleRate / fftSize;
+    const double topHz  = juce::jmin (18000.0, sampleRate * 0.45);
+    const double step   = std::pow (2.0, 1.0 / 6.0);
+    const double halfBw = std::pow (2.0, 1.0 / 12.0);
+
+    std::vector<FitBand> bands;
+
+    for (double f = 30.0; f <= topHz; f *= step)
+    {
+        const int lo = juce::jmax (1, static_cast<int> (std::floor (f / halfBw / binHz)));
+        const int hi = juce::jmin (static_cast<int> (power.size()) - 1,
+                                   juce::jmax (lo, static_cast<int> (std::ceil (f * halfBw / binHz))));
+
+        double sum = 0.0;
+        for (int bin = lo; bin <= hi; ++bin)
+            sum += power[static_cast<size_t> (bin)];
+
+        const double mean = sum / (hi - lo + 1);
+        bands.push_back ({ f, 10.0 * std::log10 (juce::jmax (mean, 1.0e-12)) });
+    }
+
+    if (bands.empty())
+        return false;
+
+    // ---- Greedy placement of peaking sections ----
+    const int maxSections = juce::jlimit (1, kMaxSections, numSectionsToUse);
+    std::vector<IIRCoefs::Ptr> fitted;
+    std::vector<double> sectionFreq, sectionQ, sectionGainDb;
+    std::vector<double> error (bands.size());
+    double gainDb = 0.0;
+
+    auto updateError = [&]
+    {
+        // Overall gain absorbs the mean offset, sections model the shape
+        double meanResidual = 0.0;
+
+        for (size_t i = 0; i < bands.size(); ++i)
+        {
+            double model = 0.0;
+            for (auto& c : fitted)
+                model += sectionDb (*c, bands[i].freq, sampleRate);
+
+            error[i] = bands[i].targetDb - model;
+            meanResidual += error[i];
+        }
+
+        gainDb = meanResidual / static_cast<double> (bands.size());
+
+        for (auto& e : error)
+            e -= gainDb;
+    };
+
+    auto makeSection = [&] (double freq, double q, double dB)
+    {
+        return IIRCoefs::makePeakFilter (sampleRate, static_cast<float> (freq), static_cast<float> (q),
+                                         juce::Decibels::decibelsToGain (static_cast<float> (dB)));
+    };
+
+    updateError();
+
+    while (static_cast<int> (fitted.size()) < maxSections)
+    {
+        size_t worst = 0;
+        for (size_t i = 1; i < error.size(); ++i)
+            if (std::abs (error[i]) > std::abs (error[worst]))
+                worst = i;
+
+        const double peak = error[worst];
+        if (std::abs (peak) < 0.25)
+            break;
+
+        // Width: neighbouring bands that still carry at least half the error
+        size_t lo = worst, hi = worst;
+        while (lo > 0 && error[lo - 1] * peak > 0.0 && std::abs (error[lo - 1]) >= std::abs (peak) * 0.5)
+            --lo;
+        while (hi + 1 < error.size() && error[hi + 1] * peak > 0.0 && std::abs (error[hi + 1]) >= std::abs (peak) * 0.5)
+            ++hi;
+
+        const double octaves = juce::jmax (1.0 / 6.0, std::log2 (bands[hi].freq / bands[lo].freq) + 1.0 / 6.0);
+        const double bwRatio = std::pow (2.0, octaves);
+        const double q       = juce::jlimit (0.3, 12.0, std::sqrt (bwRatio) / (bwRatio - 1.0));
+        const double dB      = juce::jlimit (-18.0, 18.0, peak);
+
+        fitted.push_back (makeSection (bands[worst].freq, q, dB));
+        sectionFreq.push_back (bands[worst].freq);
+        sectionQ.push_back (q);
+        sectionGainDb.push_back (dB);
+
+        updateError();
+    }
+
+    // ---- Refine section gains (coordinate descent at each centre) ----
+    for (int pass = 0; pass < 3; ++pass)
+    {
+        for (size_t k = 0; k < fitted.size(); ++k)
+        {
+            size_t centre = 0;
+            for (size_t i = 1; i < bands.size(); ++i)
+                if (std::abs (bands[i].freq - sectionFreq[k]) < std::abs (bands[centre].freq - sectionFreq[k]))
+                    centre = i;
+
+            sectionGainDb[k] = juce::jlimit (-18.0, 18.0, sectionGainDb[k] + error[centre]);
+            fitted[k] = makeSection (sectionFreq[k], sectionQ[k], sectionGainDb[k]);
+            updateError();
+        }
+    }
+
+    // ---- Report accuracy ----
+    double sumSquares = 0.0;
+    for (auto e : error)
+        sumSquares += e * e;
+
+    spectralErrorDb = static_cast<float> (std::sqrt (sumSquares / static_cast<double> (error.size())));
+    outputGain      = juce::Decibels::decibelsToGain (static_cast<float> (gainDb));
+
+    // ---- Flatten into plain coefficients for the audio thread ----
+    numSections = static_cast<int> (fitted.size());
+
+    for (int k = 0; k < numSections; ++k)
+    {
+        const auto& c = fitted[static_cast<size_t> (k)]->coefficients;
+        auto& s = sections[static_cast<size_t> (k)];
+        s.b0 = c[0]; s.b1 = c[1]; s.b2 = c[2]; s.a1 = c[3]; s.a2 = c[4];
+    }
+
+    // A model with no sections is still a valid (flat) approximation
+    if (numSections == 0)
+    {
+        numSections = 1;
+        sections[0] = {};
+    }
+
+    return true;
+}
+
+void EcoIRModel::reset()
+{
+    for (auto& ch : z1) ch.fill (0.0f);
+    for (auto& ch : z2) ch.fill (0.0f);
+}
+
+//==============================================================================
+void EcoIRModel::process (juce::AudioBuffer<float>& buffer, float wetMix)
+{
+    const int channels   = juce::jmin (buffer.getNumChannels(), kMaxChannels);
+    const int numSamples = buffer.getNumSamples();
+
+    const float dryGain = 1.0f - wetMix;
+    const float wetGain = wetMix * outputGain;
+
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        auto* data = buffer.getWritePointer (ch);
+        auto& s1   = z1[static_cast<size_t> (ch)];
+        auto& s2   = z2[static_cast<size_t> (ch)];
+
+        for (int s = 0; s < numSamples; ++s)
+        {
+            const float x = data[s];
+            float y = x;
+
+            for (int k = 0; k < numSections; ++k)
+            {
+                const auto& c = sections[static_cast<size_t> (k)];
+                const float out = c.b0 * y + s1[static_cast<size_t> (k)];
+                s1[static_cast<size_t> (k)] = c.b1 * y - c.a1 * out + s2[static_cast<size_t> (k)];
+                s2[static_cast<size_t> (k)] = c.b2 * y - c.a2 * out;
+                y = out;
+            }
+
+            data[s] = x * dryGain + y * wetGain;
+        }
+    }
+}
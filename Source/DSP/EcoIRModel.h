@@ -0,0 +1,53 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+/**
+    Low-CPU stand-in for a convolution IR: a short cascade of peaking biquads
+    fitted to the IR's smoothed magnitude response.
+
+    Fitting happens once per IR and sample rate (off the audio thread).  It
+    works greedily on 1/6-octave bands: each new section is placed where the
+    remaining error is largest, then all section gains are refined.  The
+    remaining RMS error in dB is kept so callers can show what eco mode costs
+    in accuracy.
+
+    Only the magnitude is modelled, not the IR's decay, which is fine for the
+    small wet mixes the built-in presets use.
+*/
+class EcoIRModel
+{
+public:
+    static constexpr int kMaxSections = 12;
+    static constexpr int kMaxChannels = 2;
+
+    /** Fits the model to ir.  Returns false (and leaves the model empty) if ir is silent. */
+    bool fit (const juce::AudioBuffer<float>& ir, double sampleRate, int numSectionsToUse = 8);
+
+    bool  isValid() const            { return numSections > 0; }
+    int   getNumSections() const     { return numSections; }
+
+    /** RMS difference (dB) between the model and the IR over the fitted bands. */
+    float getSpectralErrorDb() const { return spectralErrorDb; }
+
+    void reset();
+
+    /** Replaces buffer with dry * (1 - wetMix) + model(buffer) * wetMix. */
+    void process (juce::AudioBuffer<float>& buffer, float wetMix);
+
+private:
+    struct Section
+    {
+        float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+    };
+
+    std::array<Section, kMaxSections> sections;
+    int   numSections     = 0;
+    float outputGain      = 1.0f;
+    float spectralErrorDb = 0.0f;
+
+    // Transposed direct form II state, per channel per section
+    std::array<std::array<float, kMaxSections>, kMaxChannels> z1 {}, z2 {};
+};
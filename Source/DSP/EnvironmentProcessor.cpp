@@ -1,309 +1,2163 @@
 #include "EnvironmentProcessor.h"
 #include <cmath>
+#include <map>
+#include <semaphore>
+
+//==============================================================================
+class EnvironmentProcessor::UpdateThread : private juce::Thread
+{
+public:
+    UpdateThread() : juce::Thread ("Car Test updates")
+    {
+        startThread();
+    }
+
+    ~UpdateThread() override
+    {
+        signalThreadShouldExit();
+        wakeUp.release();
+        stopThread (1000);
+    }
+
+    void add (EnvironmentProcessor& instance)
+    {
+        const juce::ScopedLock sl (instancesLock);
+        instances.add (&instance);
+    }
+
+    /** Once this returns, instance isn't being serviced and won't be again. */
+    void remove (EnvironmentProcessor& instance)
+    {
+        const juce::ScopedLock sl (instancesLock);
+        instances.removeFirstMatchingValue (&instance);
+    }
+
+    /**
+        Audio thread.  Releases the semaphore only if it isn't already
+        released: an atomic add and a futex wake, where signalling a
+        WaitableEvent would lock its mutex.
+    */
+    void wake() noexcept
+    {
+        if (! pending.exchange (true))
+            wakeUp.release();
+    }
+
+private:
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            wakeUp.acquire();
+            pending.store (false);
+
+            const juce::ScopedLock sl (instancesLock);
+
+            for (auto* instance : instances)
+                instance->serviceUpdates();
+        }
+    }
+
+    juce::CriticalSection instancesLock;
+    juce::Array<EnvironmentProcessor*> instances;
+    std::counting_semaphore<> wakeUp { 0 };
+    std::atomic<bool> pending { false };
+
+    JUCE_DECLARE_NON_COPYABLE (UpdateThread)
+};
+
+//==============================================================================
+namespace
+{
+    /**
+        ConvolutionMode::automatic's measurements, shared by every instance
+        in the process, so a session of many instances times each preset's
+        IR once per rate and block size rather than once per load.
+    */
+    struct ConvolutionTimingCache
+    {
+        juce::CriticalSection lock;
+        std::map<juce::String, bool> fusedIsCheaper;
+    };
+
+    ConvolutionTimingCache& getConvolutionTimingCache()
+    {
+        static ConvolutionTimingCache cache;
+        return cache;
+    }
+}
 
 //==============================================================================
 EnvironmentProcessor::EnvironmentProcessor()
 {
-    presets = getBuiltInPresets();
+    convolutionModes = std::vector<std::atomic<ConvolutionMode>> (presets.size());
+    fusedIsCheaper.assign (presets.size(), 0);
+    presetDataReady = std::vector<std::atomic<bool>> (presets.size());
+    irHandoffs = std::vector<IRHandoff> (presets.size());
+    hasUserIR = std::vector<std::atomic<bool>> (presets.size());
+    pendingUserIRs.resize (presets.size());
+    userIRs.resize (presets.size());
+    publishPathSettings();
+
+    updateThread->add (*this);
+}
+
+EnvironmentProcessor::~EnvironmentProcessor()
+{
+    // The update thread may be servicing this instance right now
+    updateThread->remove (*this);
+    cancelPresetDataJob();
+}
+
+void EnvironmentProcessor::prepare (const juce::dsp::ProcessSpec& spec)
+{
+    // No engines made or jobs started for a half-prepared chain
+    const juce::ScopedLock updateSl (updateLock);
+
+    // The background job reads sampleRate, so it has to stop first
+    cancelPresetDataJob();
+
+    // ...and the user IRs.  A replaced mapping is unmapped here unless another instance holds it
+    userIRs = pendingUserIRs;
+
+    for (size_t i = 0; i < userIRs.size(); ++i)
+        hasUserIR[i].store (userIRs[i] != nullptr);
+
+    // The filter states live inline in hot, sized for kMaxChannels
+    numChannels = juce::jmin (static_cast<int> (spec.numChannels), kMaxChannels);
+
+    // From here on, "host block" means the largest the scheduler hands the chain
+    scheduler.prepare (numChannels, static_cast<int> (spec.maximumBlockSize), blockScheduling);
+    hostBlockSize = scheduler.getMaxBlockSize();
+
+    // Reduced internal rate: the lowest one every preset's low-pass still fits under
+    // (never offline, where the chain runs oversampled instead)
+    int factor = 1;
+
+    if (reducedRate && ! hot.highQuality)
+    {
+        factor = RateConverter::kMaxFactor;
+
+        for (size_t i = 1; i < presets.size(); ++i)
+            factor = juce::jmin (factor, RateConverter::getFactorForBandwidth (spec.sampleRate,
+                                                                              presets[i].lowPassFreq));
+    }
+
+    rateConverter.prepare (numChannels, hostBlockSize, factor);
+    internalBuffer.setSize (numChannels, rateConverter.getMaxInternalBlockSize());
+
+    // Offline high quality: 2x oversampled, so the bilinear transform doesn't
+    // cramp the low-passes and top peaks, and the compressor doesn't alias
+    oversampler.reset();
+    int oversampling = 1;
+
+    if (hot.highQuality)
+    {
+        oversampler = std::make_unique<juce::dsp::Oversampling<float>> (
+            static_cast<size_t> (numChannels), 1, juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple,
+            true, true);
+        oversampler->initProcessing (static_cast<size_t> (hostBlockSize));
+        oversampledChannels.assign (static_cast<size_t> (numChannels), nullptr);
+        oversampling = static_cast<int> (oversampler->getOversamplingFactor());
+    }
+
+    // Everything below runs at the internal rate
+    sampleRate      = spec.sampleRate / factor * oversampling;
+    samplesPerBlock = factor > 1 ? rateConverter.getMaxInternalBlockSize() : hostBlockSize * oversampling;
+
+    // Offline, a larger-partition engine for throughput; both are zero-latency.
+    // Only made the first time a bounce needs it
+    if (hot.highQuality && offlineConvolver == nullptr)
+        offlineConvolver = std::make_unique<juce::dsp::Convolution> (
+            juce::dsp::Convolution::NonUniform { kOfflineHeadSize });
+
+    convolver = hot.highQuality ? offlineConvolver.get() : &liveConvolver;
+
+    juce::dsp::ProcessSpec internalSpec { sampleRate, static_cast<juce::uint32> (samplesPerBlock),
+                                          static_cast<juce::uint32> (numChannels) };
+
+    // Pick the kernel variant now: the first get() reads the environment and allocates
+    DspKernels::get();
+
+    std::fill (hot.filterStates.begin(), hot.filterStates.end(), DspKernels::BiquadState {});
+    std::fill (preciseFilterStates.begin(), preciseFilterStates.end(), DspKernels::PreciseBiquadState {});
+
+    // Convolution engine
+    convolver->prepare (internalSpec);
+    morphPosition.reset (sampleRate, kMorphRampSeconds);
+
+    // The morph's engines are made again, for this spec, by the next morph
+    morphEnginesReady.store (false);
+    morphConvolver.reset();
+    morphTrueStereo.reset();
+
+    // Reflection LP filter
+    std::fill (hot.reflectionLPStates.begin(), hot.reflectionLPStates.end(), DspKernels::BiquadState {});
+
+    // Early reflections delay buffer: ~15ms of taps behind a whole block, which
+    // is written before the taps read it
+    hot.delayBufferSize = static_cast<int> (sampleRate * 0.015) + samplesPerBlock;
+    delayBuffer.setSize (numChannels, hot.delayBufferSize);
+    delayBuffer.clear();
+    hot.delayWritePos = 0;
+
+    // Scratch space for the dry copy and reflections, so process() never allocates
+    scratchBuffer.setSize (numChannels, samplesPerBlock);
+    reflectionScratch.setSize (numChannels, samplesPerBlock);
+    morphScratch.setSize (numChannels, samplesPerBlock);
+
+    float maxLookaheadMs = 0.0f;
+    for (const auto& preset : presets)
+        if (preset.compress)
+            maxLookaheadMs = juce::jmax (maxLookaheadMs, preset.compLookaheadMs);
+
+    // Whole host samples even when oversampled, so the reported latency is exact
+    lookaheadSamples = juce::roundToInt (maxLookaheadMs * 0.001 * sampleRate / oversampling) * oversampling;
+    compressor.prepare (sampleRate, samplesPerBlock, numChannels,
+                        static_cast<float> (lookaheadSamples * 1000.0 / sampleRate));
+    driver.prepare (sampleRate, samplesPerBlock, numChannels);
+
+    // The codec's filterbank delays every preset once any of them can use it,
+    // like the lookahead.  Its hop is a power of two, so whole host samples too
+    bool anyCodec = codecPath == CodecPath::streaming;
+    for (size_t i = 1; i < presets.size(); ++i)
+        anyCodec = anyCodec || (codecPath == CodecPath::device && presets[i].codec != CodecSimulator::Codec::none);
+
+    codec.prepare (sampleRate, numChannels);
+    codecLatencySamples = anyCodec ? codec.getLatencySamples() : 0;
+
+    hot.chainLatencySamples = (lookaheadSamples + codecLatencySamples) * factor / oversampling
+                               + rateConverter.getLatencySamples()
+                               + (oversampler != nullptr ? juce::roundToInt (oversampler->getLatencyInSamples()) : 0);
+    hot.latencySamples      = hot.chainLatencySamples + scheduler.getLatencySamples();
+
+    bypassDelayLine.setSize (numChannels, juce::jmax (1, hot.chainLatencySamples));
+    bypassDelayLine.clear();
+    hot.bypassDelayPos = 0;
+
+    // Only pay for the derived IR data when something is going to use it.
+    // Offline the job decodes the whole IRs too; the loader's copy plays until then
+    publishPathSettings();
+
+    if (needsPresetData())
+        startPresetDataJob();
+
+    prepared = true;
+    rebuildFilters();
+}
+
+void EnvironmentProcessor::reset()
+{
+    std::fill (hot.filterStates.begin(), hot.filterStates.end(), DspKernels::BiquadState {});
+    std::fill (preciseFilterStates.begin(), preciseFilterStates.end(), DspKernels::PreciseBiquadState {});
+
+    convolver->reset();
+    if (morphEnginesReady.load (std::memory_order_acquire))
+    {
+        morphConvolver->reset();
+        if (morphTrueStereo != nullptr)
+            morphTrueStereo->reset();
+    }
+    if (tailConvolverReady.load (std::memory_order_acquire))
+        tailConvolver.reset();
+    if (trueStereoReady.load (std::memory_order_acquire))
+        trueStereoConvolver.reset();
+    for (size_t i = 0; i < ecoModels.size(); ++i)
+        if (isPresetDataReady (i))
+            ecoModels[i].reset();
+    std::fill (hot.reflectionLPStates.begin(), hot.reflectionLPStates.end(), DspKernels::BiquadState {});
+    delayBuffer.clear();
+    hot.delayWritePos = 0;
+    compressor.reset();
+    driver.reset();
+    codec.reset();
+    rateConverter.reset();
+    if (oversampler != nullptr)
+        oversampler->reset();
+    scheduler.reset();
+    bypassDelayLine.clear();
+    hot.bypassDelayPos = 0;
+}
+
+void EnvironmentProcessor::setPreset (int idx)
+{
+    if (idx < 0 || idx >= static_cast<int> (presets.size()))
+        idx = 0;
+
+    if (idx != hot.currentPresetIndex)
+    {
+        // Stale resampler / bypass delay state would replay on the way in or out of bypass
+        if (hot.currentPresetIndex == 0)
+            rateConverter.reset();
+        else if (idx == 0)
+            bypassDelayLine.clear();
+
+        hot.currentPresetIndex = idx;
+        publishPathSettings();
+        rebuildFilters();
+    }
+}
+
+void EnvironmentProcessor::setConvolutionMode (int presetIndex, ConvolutionMode mode)
+{
+    if (presetIndex < 0 || presetIndex >= static_cast<int> (convolutionModes.size()))
+        return;
+
+    if (convolutionModes[static_cast<size_t> (presetIndex)].load() != mode)
+    {
+        convolutionModes[static_cast<size_t> (presetIndex)].store (mode);
+
+        if (presetIndex == hot.currentPresetIndex)
+            rebuildFilters();
+    }
+}
+
+EnvironmentProcessor::ConvolutionMode EnvironmentProcessor::getConvolutionMode (int presetIndex) const
+{
+    if (presetIndex < 0 || presetIndex >= static_cast<int> (convolutionModes.size()))
+        return ConvolutionMode::separate;
+
+    return convolutionModes[static_cast<size_t> (presetIndex)].load();
+}
+
+bool EnvironmentProcessor::isConvolutionReady() const
+{
+    return ! hot.waitingForPresetData
+        && ! hot.waitingForIRHandoff
+        && ! hot.waitingForTailConvolver
+        && (! hot.convolverActive || convolver->getCurrentIRSize() > 0);
+}
+
+void EnvironmentProcessor::setQuality (Quality newQuality)
+{
+    if (newQuality != quality)
+    {
+        quality = newQuality;
+        publishPathSettings();
+        rebuildFilters();
+    }
+}
+
+float EnvironmentProcessor::getEcoSpectralErrorDb (int presetIndex) const
+{
+    // The job may still be fitting it (or not have sized the models yet)
+    const auto slot = static_cast<size_t> (presetIndex);
+    const juce::ScopedLock sl (presetDataReadLock);
+
+    if (presetIndex < 0 || ! isPresetDataReady (slot) || slot >= ecoModels.size() || ! ecoModels[slot].isValid())
+        return -1.0f;
+
+    return ecoModels[slot].getSpectralErrorDb();
+}
+
+void EnvironmentProcessor::setAsyncTails (bool shouldUseWorkers)
+{
+    if (shouldUseWorkers != asyncTails)
+    {
+        asyncTails = shouldUseWorkers;
+        publishPathSettings();
+        rebuildFilters();
+    }
+}
+
+void EnvironmentProcessor::setSeat (CabinModel::Seat newSeat)
+{
+    if (newSeat != seat)
+    {
+        seat = newSeat;
+        publishPathSettings();
+
+        if (presets[static_cast<size_t> (hot.currentPresetIndex)].cabinModel)
+            rebuildFilters();
+    }
+}
+
+bool EnvironmentProcessor::setUserIR (int presetIndex, IRLibrary::MappedIRPtr ir)
+{
+    if (! juce::isPositiveAndBelow (presetIndex, static_cast<int> (presets.size())))
+        return true;
+
+    const auto slot = static_cast<size_t> (presetIndex);
+
+    const juce::ScopedLock updateSl (updateLock);
+
+    if (pendingUserIRs[slot] == ir)
+        return true;
+
+    pendingUserIRs[slot] = ir;
+
+    // Not prepared yet: prepare() takes it
+    if (! prepared)
+        return true;
+
+    if (! presetDataJobStarted.load())
+    {
+        // Nothing reads the preset data yet, so the job that builds it will pick this up
+        userIRs[slot] = ir;
+        hasUserIR[slot].store (ir != nullptr);
+
+        if (ir != nullptr)
+            startPresetDataJob();
+
+        return true;
+    }
+
+    // The job sized the convolvers for the IRs it started with; a longer one needs a prepare()
+    const auto needed = getPartitionsNeeded (slot, ir != nullptr ? IRSource { ir->getData(), ir->getSize() }
+                                                                 : IRSource { presets[slot].irResourceName,
+                                                                              presets[slot].irResourceSize });
+
+    if (needed.tail > tailPartitionCapacity.load() || needed.trueStereo > trueStereoPartitionCapacity.load())
+        return false;
+
+    bool startJob = false;
+
+    {
+        const juce::ScopedLock sl (userIRQueueLock);
+        queuedUserIRs.push_back ({ slot, std::move (ir) });
+        startJob = ! presetDataJobQueued;
+        presetDataJobQueued = true;
+    }
+
+    if (! startJob)
+        return true;
+
+    // A job that has just found the queue empty may not have left the pool yet.  If it
+    // hasn't soon, stop it; if even that doesn't take, the IR waits for the next prepare()
+    if (! backgroundPool->waitForJobToFinish (&presetDataJob, kJobRestartTimeoutMs)
+         && ! backgroundPool->removeJob (&presetDataJob, true, kJobRestartTimeoutMs))
+    {
+        const juce::ScopedLock sl (userIRQueueLock);
+        queuedUserIRs.clear();
+        presetDataJobQueued = false;
+        return false;
+    }
+
+    backgroundPool->addJob (&presetDataJob, false);
+    return true;
+}
+
+IRLibrary::MappedIRPtr EnvironmentProcessor::getUserIR (int presetIndex) const
+{
+    if (! juce::isPositiveAndBelow (presetIndex, static_cast<int> (presets.size())))
+        return nullptr;
+
+    return pendingUserIRs[static_cast<size_t> (presetIndex)];
+}
+
+EnvironmentProcessor::IRSource EnvironmentProcessor::getIRSource (size_t presetSlot) const
+{
+    if (const auto& userIR = userIRs[presetSlot])
+        return { userIR->getData(), userIR->getSize() };
+
+    return { presets[presetSlot].irResourceName, presets[presetSlot].irResourceSize };
+}
+
+//==============================================================================
+MemoryFootprint EnvironmentProcessor::getMemoryFootprint() const
+{
+    MemoryFootprint footprint;
+
+    const int blockSize = samplesPerBlock;
+    footprint[MemoryFootprint::convolution] =
+        estimateConvolutionBytes (convolver->getCurrentIRSize(), blockSize, numChannels,
+                                  convolver == offlineConvolver.get() ? kOfflineHeadSize : 0);
+
+    if (morphEnginesReady.load (std::memory_order_acquire))
+    {
+        footprint[MemoryFootprint::convolution] +=
+            estimateConvolutionBytes (morphConvolver->getCurrentIRSize(), blockSize, numChannels,
+                                      hot.highQuality ? kOfflineHeadSize : 0);
+
+        if (morphTrueStereo != nullptr)
+            footprint[MemoryFootprint::convolution] += morphTrueStereo->getMemoryBytes();
+    }
+
+    if (tailConvolverReady.load (std::memory_order_acquire))
+        footprint[MemoryFootprint::convolution] += tailConvolver.getMemoryBytes();
+    if (trueStereoReady.load (std::memory_order_acquire))
+        footprint[MemoryFootprint::convolution] += trueStereoConvolver.getMemoryBytes();
+
+    footprint[MemoryFootprint::delayLines] = MemoryFootprint::bytesOf (delayBuffer)
+                                           + MemoryFootprint::bytesOf (bypassDelayLine)
+                                           + compressor.getMemoryBytes()
+                                           + codec.getMemoryBytes()
+                                           + rateConverter.getMemoryBytes()
+                                           + scheduler.getMemoryBytes();
+
+    // Only slots the job has finished with; the rest may be mid-write
+    const juce::ScopedLock sl (presetDataReadLock);
+
+    for (size_t i = 0; i < presetDataReady.size(); ++i)
+    {
+        if (! isPresetDataReady (i))
+            continue;
+
+        auto& bytes = footprint[MemoryFootprint::presetData];
+        bytes += MemoryFootprint::bytesOf (presetIRs[i]) + MemoryFootprint::bytesOf (fusedIRs[i])
+               + MemoryFootprint::bytesOf (presetTails[i].partitions)
+               + MemoryFootprint::bytesOf (fusedTails[i].partitions)
+               + MemoryFootprint::bytesOf (trueStereoIRs[i].partitions)
+               + MemoryFootprint::bytesOf (fusedTrueStereoIRs[i].partitions);
+
+        for (const auto& cabinIR : cabinIRs[i])
+            bytes += MemoryFootprint::bytesOf (cabinIR.partitions);
+
+        // The handoff's copy, sized from its source: the buffer itself may be changing hands
+        const auto path = irHandoffs[i].wanted.load();
+
+        if (needsIRHandoff (path))
+        {
+            const auto& source = getHandoffSource (i, path);
+            const int length   = path == IRPath::head || path == IRPath::fusedHead
+                                   ? juce::jmin (source.getNumSamples(), AsyncTailConvolver::kHeadLength)
+                                   : source.getNumSamples();
+            bytes += static_cast<size_t> (source.getNumChannels() * length) * sizeof (float);
+        }
+    }
+
+    footprint[MemoryFootprint::scratch] = MemoryFootprint::bytesOf (scratchBuffer)
+                                        + MemoryFootprint::bytesOf (reflectionScratch)
+                                        + MemoryFootprint::bytesOf (morphScratch)
+                                        + MemoryFootprint::bytesOf (internalBuffer)
+                                        + driver.getMemoryBytes();
+
+    // Oversampling's up-sampled block, per stage
+    if (oversampler != nullptr)
+        footprint[MemoryFootprint::scratch] += static_cast<size_t> (blockSize * numChannels) * sizeof (float);
+
+    return footprint;
+}
+
+bool EnvironmentProcessor::isBuildingPresetData() const
+{
+    return backgroundPool->contains (&presetDataJob);
+}
+
+size_t EnvironmentProcessor::estimateConvolutionBytes (int irLength, int blockSize, int numChannels, int headSize)
+{
+    if (irLength <= 0)
+        return 0;
+
+    if (headSize > 0 && irLength > headSize)
+        return estimateConvolutionBytes (headSize, blockSize, numChannels)
+             + estimateConvolutionBytes (irLength - headSize, headSize, numChannels);
+
+    // juce::dsp::ConvolutionEngine: FFT of twice the block (four times for small
+    // blocks, with three times the input history), complex spectra of fftSize * 2 floats
+    const auto block     = static_cast<size_t> (juce::nextPowerOfTwo (juce::jmax (1, blockSize)));
+    const auto fftSize   = block > 128 ? 2 * block : 4 * block;
+    const auto segments  = static_cast<size_t> (irLength) / (fftSize - block) + 1;
+    const auto inputSegs = block > 128 ? segments : 3 * segments;
+    const auto perEngine = ((segments + inputSegs) * fftSize * 2 + 6 * fftSize) * sizeof (float);
+
+    return perEngine * static_cast<size_t> (juce::jlimit (1, 2, numChannels)) * 2;
+}
+
+//==============================================================================
+bool EnvironmentProcessor::needsIRHandoff (IRPath path)
+{
+    return path == IRPath::full || path == IRPath::head || path == IRPath::fused || path == IRPath::fusedHead;
+}
+
+const juce::AudioBuffer<float>& EnvironmentProcessor::getHandoffSource (size_t presetSlot, IRPath path) const
+{
+    return path == IRPath::fused || path == IRPath::fusedHead ? fusedIRs[presetSlot] : presetIRs[presetSlot];
+}
+
+void EnvironmentProcessor::fillIRHandoff (size_t presetSlot, IRPath path)
+{
+    auto& handoff = irHandoffs[presetSlot];
+    handoff.wanted.store (path);
+
+    if (! needsIRHandoff (path))
+        return;
+
+    // Head only: the tail convolver picks up from kHeadLength onwards
+    const auto& source = getHandoffSource (presetSlot, path);
+    const int length   = path == IRPath::head || path == IRPath::fusedHead
+                           ? juce::jmin (source.getNumSamples(), AsyncTailConvolver::kHeadLength)
+                           : source.getNumSamples();
+
+    if (length == 0)
+        return;
+
+    handoff.ir.setSize (source.getNumChannels(), length);
+
+    for (int ch = 0; ch < source.getNumChannels(); ++ch)
+        handoff.ir.copyFrom (ch, 0, source, ch, 0, length);
+
+    handoff.path = path;
+    handoff.ready.store (true, std::memory_order_release);
+}
+
+bool EnvironmentProcessor::loadFromIRHandoff (size_t presetSlot, IRPath path,
+                                              juce::dsp::Convolution& target, bool& targetActive)
+{
+    auto& handoff = irHandoffs[presetSlot];
+    handoff.wanted.store (path);
+
+    if (! handoff.ready.load (std::memory_order_acquire))
+    {
+        // Being made, or taken last time and not made again yet
+        hot.waitingForIRHandoff = true;
+        requestUpdate();
+        return false;
+    }
+
+    if (handoff.path != path)
+    {
+        // Made for another path (the mode changed): back to the update thread for this one
+        handoff.ready.store (false, std::memory_order_release);
+        hot.waitingForIRHandoff = true;
+        requestUpdate();
+        return false;
+    }
+
+    // The loader takes the buffer through its queue as it is, so nothing is copied here
+    target.loadImpulseResponse (std::move (handoff.ir), sampleRate,
+                                juce::dsp::Convolution::Stereo::yes,
+                                juce::dsp::Convolution::Trim::no,
+                                juce::dsp::Convolution::Normalise::no);
+    targetActive = true;
+
+    // A fresh one for the next time this preset is selected
+    handoff.ready.store (false, std::memory_order_release);
+    requestUpdate();
+    return true;
+}
+
+void EnvironmentProcessor::loadIR (const char* data, int dataSize, juce::dsp::Convolution& target, bool& targetActive)
+{
+    // Offline the IR keeps its whole tail, which the loader would trim: that
+    // decode is the job's (IRPath::full), and this trimmed copy stands in until it's built
+    if (data == nullptr || dataSize == 0)
+    {
+        targetActive = false;
+        return;
+    }
+
+    target.loadImpulseResponse (data, static_cast<size_t> (dataSize),
+                                juce::dsp::Convolution::Stereo::yes,
+                                juce::dsp::Convolution::Trim::yes,
+                                0);  // 0 = use full IR length
+    targetActive = true;
+}
+
+//==============================================================================
+bool EnvironmentProcessor::usesTrueStereo (const EnvironmentPreset& preset, Quality withQuality) const
+{
+    return preset.irTrueStereo && numChannels >= 2 && withQuality != Quality::eco;
+}
+
+bool EnvironmentProcessor::usesCabinModel (const EnvironmentPreset& preset, Quality withQuality) const
+{
+    return preset.cabinModel && numChannels >= 2 && withQuality != Quality::eco;
+}
+
+bool EnvironmentProcessor::needsPresetData() const
+{
+    if (quality == Quality::eco || asyncTails || hot.highQuality)
+        return true;
+
+    // Library IRs (and offline, every IR) are only ever decoded by the job
+    for (const auto& userIR : userIRs)
+        if (userIR != nullptr)
+            return true;
+
+    const auto& current = presets[static_cast<size_t> (hot.currentPresetIndex)];
+
+    if (usesTrueStereo (current, quality) || usesCabinModel (current, quality))
+        return true;
+
+    return std::any_of (convolutionModes.begin(), convolutionModes.end(),
+                        [] (const std::atomic<ConvolutionMode>& mode) { return mode.load() != ConvolutionMode::separate; });
+}
+
+void EnvironmentProcessor::requestUpdate() noexcept
+{
+    updateRequested.store (true);
+    updateThread->wake();
+}
+
+void EnvironmentProcessor::serviceUpdates()
+{
+    if (! updateRequested.exchange (false))
+        return;
+
+    const juce::ScopedLock updateSl (updateLock);
+
+    // Requested from the audio thread the first time a mode needed the data...
+    if (! presetDataJobStarted.load())
+        startPresetDataJob();
+
+    // ...or the first morph since prepare() needed its second set of engines...
+    if (morphEnginesRequested.exchange (false) && ! morphEnginesReady.load())
+        createMorphEngines();
+
+    // ...or async tails were switched on after the job had started without them...
+    if (tailConvolverRequested.exchange (false))
+        prepareTailConvolver();
+
+    // ...and whenever it has taken an IR handoff, or found one made for another path.
+    // Slots the job hasn't finished are still its own
+    const juce::ScopedLock sl (presetDataReadLock);
+
+    for (size_t i = 0; i < irHandoffs.size(); ++i)
+        if (isPresetDataReady (i) && ! irHandoffs[i].ready.load (std::memory_order_acquire))
+            fillIRHandoff (i, irHandoffs[i].wanted.load());
+}
+
+void EnvironmentProcessor::startPresetDataJob()
+{
+    // Callers have cancelled any previous job (prepare) or never started one
+    fusedIRs.clear();
+    fusedIRs.resize (presets.size());
+    ecoModels.clear();
+    ecoModels.resize (presets.size());
+    presetIRs.clear();
+    presetIRs.resize (presets.size());
+    presetTails.clear();
+    presetTails.resize (presets.size());
+    fusedTails.clear();
+    fusedTails.resize (presets.size());
+    trueStereoIRs.clear();
+    trueStereoIRs.resize (presets.size());
+    fusedTrueStereoIRs.clear();
+    fusedTrueStereoIRs.resize (presets.size());
+    cabinIRs.clear();
+    cabinIRs.resize (presets.size());
+    std::fill (fusedIsCheaper.begin(), fusedIsCheaper.end(), 0);
+
+    {
+        const juce::ScopedLock sl (userIRQueueLock);
+        presetDataJobQueued = true;
+    }
+
+    presetDataBuilt = false;
+    partitionsSized.store (false);
+    tailPartitionCapacity.store (0);
+    trueStereoPartitionCapacity.store (0);
+    presetDataJobStarted = true;
+    backgroundPool->addJob (&presetDataJob, false);
+}
+
+void EnvironmentProcessor::cancelPresetDataJob()
+{
+    backgroundPool->removeJob (&presetDataJob, true, -1);
+
+    {
+        const juce::ScopedLock sl (userIRQueueLock);
+        queuedUserIRs.clear();
+        presetDataJobQueued = false;
+    }
+
+    for (auto& ready : presetDataReady)
+        ready.store (false, std::memory_order_release);
+
+    for (auto& handoff : irHandoffs)
+    {
+        handoff.ready.store (false, std::memory_order_release);
+        handoff.wanted.store (IRPath::plain);
+        handoff.ir.setSize (0, 0);
+    }
+
+    // Only true once a job has run, i.e. never while audio is using the convolver.
+    // The tail convolver lets go of the worker pool until async tails are next used
+    if (tailConvolverReady.exchange (false))
+        tailConvolver.release();
+    if (trueStereoReady.exchange (false))
+        trueStereoConvolver.setIR (nullptr);
+
+    presetDataJobStarted = false;
+    hot.waitingForPresetData    = false;
+    hot.waitingForIRHandoff     = false;
+    hot.waitingForTailConvolver = false;
+}
+
+bool EnvironmentProcessor::isPresetDataReady (size_t presetSlot) const
+{
+    return presetSlot < presetDataReady.size()
+        && presetDataReady[presetSlot].load (std::memory_order_acquire);
+}
+
+juce::ThreadPoolJob::JobStatus EnvironmentProcessor::PresetDataJob::runJob()
+{
+    // The audio thread's selections as they are now; it may change them while this runs
+    const auto settings = owner.pathSettings.load();
+
+    if (! owner.presetDataBuilt)
+    {
+        if (! buildAll (settings))
+            return jobHasFinished;
+
+        owner.presetDataBuilt = true;
+    }
+
+    // Then any user IRs swapped in since, one preset at a time
+    while (! shouldExit())
+    {
+        size_t slot = 0;
+        IRLibrary::MappedIRPtr ir;
+
+        {
+            const juce::ScopedLock sl (owner.userIRQueueLock);
+
+            if (owner.queuedUserIRs.empty())
+            {
+                owner.presetDataJobQueued = false;   // the next setUserIR() adds the job again
+                return jobHasFinished;
+            }
+
+            slot = owner.queuedUserIRs.front().first;
+            ir   = std::move (owner.queuedUserIRs.front().second);
+            owner.queuedUserIRs.erase (owner.queuedUserIRs.begin());
+        }
+
+        if (! owner.releasePresetData (slot, *this))
+            break;
+
+        owner.userIRs[slot] = std::move (ir);
+        owner.hasUserIR[slot].store (owner.userIRs[slot] != nullptr);
+        owner.buildPresetData (slot);
+        owner.fillIRHandoff (slot, owner.choosePathFromData (slot, settings));
+        owner.presetDataReady[slot].store (true, std::memory_order_release);
+    }
+
+    return jobHasFinished;
+}
+
+bool EnvironmentProcessor::PresetDataJob::buildAll (const PathSettings& settings)
+{
+    // Size the tail convolver from the file headers; nothing else touches it until ready
+    int maxPartitions = 0;
+    int maxTrueStereoPartitions = 0;
+
+    for (size_t i = 0; i < owner.presets.size(); ++i)
+    {
+        const auto needed = owner.getPartitionsNeeded (i, owner.getIRSource (i));
+        maxPartitions           = juce::jmax (maxPartitions, needed.tail);
+        maxTrueStereoPartitions = juce::jmax (maxTrueStereoPartitions, needed.trueStereo);
+    }
+
+    owner.tailPartitionCapacity.store (maxPartitions);
+    owner.trueStereoPartitionCapacity.store (maxTrueStereoPartitions);
+    owner.partitionsSized.store (true);
+
+    // The tail convolver starts the shared worker pool, so only for async tails
+    if (settings.asyncTails)
+        owner.prepareTailConvolver();
+
+    owner.trueStereoConvolver.prepare (TrueStereoConvolver::getPartitionSizeForBlockSize (owner.samplesPerBlock),
+                                       maxTrueStereoPartitions);
+    owner.trueStereoReady.store (true, std::memory_order_release);
+
+    // The preset that's playing first, then the rest in order
+    const auto first = static_cast<size_t> (settings.presetIndex);
+    std::vector<size_t> order { first };
+
+    for (size_t i = 1; i < owner.presets.size(); ++i)
+        if (i != first)
+            order.push_back (i);
+
+    for (auto i : order)
+    {
+        if (shouldExit())
+            return false;
+
+        if (i == 0)
+            continue;
+
+        owner.buildPresetData (i);
+
+        // The buffer the audio thread will most likely want first, so it doesn't wait for the update thread
+        owner.fillIRHandoff (i, owner.choosePathFromData (i, settings));
+        owner.presetDataReady[i].store (true, std::memory_order_release);
+    }
+
+    return true;
+}
+
+EnvironmentProcessor::PartitionCounts EnvironmentProcessor::getPartitionsNeeded (size_t presetSlot,
+                                                                                 IRSource source) const
+{
+    const auto& preset = presets[presetSlot];
+    const int eqTail   = static_cast<int> (sampleRate * kFusedEqTailSeconds);
+    const int trueStereoPartition = TrueStereoConvolver::getPartitionSizeForBlockSize (samplesPerBlock);
+    const int irLength = ImpulseResponse::getLengthAtRate (source.data, source.size, sampleRate);
+    const int length   = irLength + eqTail - AsyncTailConvolver::kHeadLength;
+
+    PartitionCounts needed;
+
+    if (length > 0)
+        needed.tail = length / AsyncTailConvolver::kPartitionSize + 2;
+
+    if (irLength > 0 && preset.irTrueStereo)
+    {
+        const int crossDelay = static_cast<int> (std::ceil (preset.irCrossFeedDelayMs * 0.001 * sampleRate));
+        needed.trueStereo = juce::jmax (needed.trueStereo, (irLength + eqTail + crossDelay) / trueStereoPartition + 1);
+    }
+
+    if (irLength > 0 && preset.cabinModel)
+    {
+        const int pathLength = static_cast<int> (std::ceil (CabinModel::kMaxPathSeconds * sampleRate));
+        needed.trueStereo = juce::jmax (needed.trueStereo, (irLength + pathLength) / trueStereoPartition + 1);
+    }
+
+    return needed;
+}
+
+void EnvironmentProcessor::prepareTailConvolver()
+{
+    // The job or the update thread, whichever gets here first once the partitions are counted
+    const juce::ScopedLock sl (tailConvolverLock);
+
+    if (tailConvolverReady.load() || ! partitionsSized.load())
+        return;
+
+    tailConvolver.prepare (numChannels, tailPartitionCapacity.load());
+    tailConvolverReady.store (true, std::memory_order_release);
+}
+
+bool EnvironmentProcessor::releasePresetData (size_t presetSlot, const juce::ThreadPoolJob& job)
+{
+    // Nothing new starts reading the slot from here on...
+    presetDataReady[presetSlot].store (false);
+
+    // ...a reader off the audio thread that saw it ready has finished...
+    {
+        const juce::ScopedLock sl (presetDataReadLock);
+    }
+
+    // ...and the audio thread has moved off it (its next block, while it's running),
+    // with no tail worker still reading the old partitions
+    while (presetSlotInUse.load() == static_cast<int> (presetSlot)
+            || morphSlotInUse.load() == static_cast<int> (presetSlot)
+            || ! tailConvolver.isIdle())
+    {
+        if (job.shouldExit())
+            return false;
+
+        juce::Thread::sleep (1);
+    }
+
+    // Its handoff is the job's again too
+    irHandoffs[presetSlot].ready.store (false, std::memory_order_release);
+    return true;
+}
+
+void EnvironmentProcessor::buildPresetData (size_t i)
+{
+    // A rebuild for a new user IR starts from nothing, in case this one doesn't decode
+    presetIRs[i]          = {};
+    fusedIRs[i]           = {};
+    ecoModels[i]          = {};
+    presetTails[i]        = {};
+    fusedTails[i]         = {};
+    trueStereoIRs[i]      = {};
+    fusedTrueStereoIRs[i] = {};
+    cabinIRs[i]           = {};
+    fusedIsCheaper[i]     = 0;
+
+    // Same decode / resample / trim / normalise the convolver applies in separate mode.
+    // A user IR's pages are read from its mapping here, off the audio thread
+    const auto& preset = presets[i];
+    const auto  source = getIRSource (i);
+    auto ir = ImpulseResponse::loadForSampleRate (source.data, source.size, sampleRate, ! hot.highQuality);
+
+    if (ir.getNumSamples() == 0)
+        return;
+
+    if (preset.irTrueStereo || ir.getNumChannels() == ImpulseResponse::numTrueStereoPaths)
+    {
+        const auto trueStereo = ImpulseResponse::makeTrueStereo (ir, sampleRate, preset.irCrossFeedDb,
+                                                                 preset.irCrossFeedDelayMs,
+                                                                 preset.irCrossFeedLowPassHz);
+        const int partitionSize = TrueStereoConvolver::getPartitionSizeForBlockSize (samplesPerBlock);
+
+        trueStereoIRs[i]      = TrueStereoConvolver::makeIR (trueStereo, partitionSize);
+        fusedTrueStereoIRs[i] = TrueStereoConvolver::makeIR (buildFusedIR (preset, trueStereo), partitionSize);
+    }
+
+    // Everything else works on the direct paths of a 4-channel IR
+    if (ir.getNumChannels() == ImpulseResponse::numTrueStereoPaths)
+    {
+        juce::AudioBuffer<float> direct (2, ir.getNumSamples());
+        direct.copyFrom (0, 0, ir, ImpulseResponse::leftToLeft,   0, ir.getNumSamples());
+        direct.copyFrom (1, 0, ir, ImpulseResponse::rightToRight, 0, ir.getNumSamples());
+        ir = std::move (direct);
+    }
+
+    if (preset.cabinModel)
+    {
+        const int partitionSize = TrueStereoConvolver::getPartitionSizeForBlockSize (samplesPerBlock);
+
+        for (int s = 0; s < CabinModel::numSeats; ++s)
+            cabinIRs[i][static_cast<size_t> (s)] = TrueStereoConvolver::makeIR (
+                CabinModel::buildTrueStereoIR (CabinModel::getSedanSpeakers(), static_cast<CabinModel::Seat> (s),
+                                               ir, preset.irWetMix, sampleRate),
+                partitionSize);
+    }
+
+    fusedIRs[i] = buildFusedIR (preset, ir);
+    ecoModels[i].fit (ir, sampleRate);
+    presetTails[i] = AsyncTailConvolver::makeTail (ir);
+    fusedTails[i]  = AsyncTailConvolver::makeTail (fusedIRs[i]);
+
+    fusedIsCheaper[i] = isFusedCheaper (i, ir) ? 1 : 0;
+    presetIRs[i] = std::move (ir);
+}
+
+bool EnvironmentProcessor::isFusedCheaper (size_t presetSlot, const juce::AudioBuffer<float>& ir) const
+{
+    // For ConvolutionMode::automatic: whichever is cheaper on this machine, at this rate and
+    // block size.  Measured by the first instance that builds this IR for them, then shared
+    const auto& userIR = userIRs[presetSlot];
+    const auto key = juce::String (static_cast<int> (presetSlot)) + "/"
+                   + (userIR != nullptr ? userIR->getName() + "/" + juce::String (userIR->getSize()) : juce::String ("built-in"))
+                   + "/" + juce::String (sampleRate) + "/" + juce::String (samplesPerBlock)
+                   + "/" + juce::String (numChannels) + (hot.highQuality ? "/offline" : "");
+
+    auto& cache = getConvolutionTimingCache();
+
+    {
+        const juce::ScopedLock sl (cache.lock);
+        const auto cached = cache.fusedIsCheaper.find (key);
+
+        if (cached != cache.fusedIsCheaper.end())
+            return cached->second;
+    }
+
+    const auto& preset           = presets[presetSlot];
+    const double separateSeconds = timeConvolutionPath (ir, preset, true);
+    const double fusedSeconds    = timeConvolutionPath (fusedIRs[presetSlot], preset, false);
+
+    // An IR that didn't load in time (or a cancelled job) isn't a measurement worth keeping
+    if (fusedSeconds <= 0.0 || separateSeconds <= 0.0)
+        return false;
+
+    const bool cheaper = fusedSeconds < separateSeconds;
+    const juce::ScopedLock sl (cache.lock);
+    cache.fusedIsCheaper[key] = cheaper;
+    return cheaper;
+}
+
+double EnvironmentProcessor::timeConvolutionPath (const juce::AudioBuffer<float>& ir, const EnvironmentPreset& preset,
+                                                  bool withFilters) const
+{
+    // The same engine, spec and kernels the audio thread would run, on the job's thread.
+    // Returns the fastest of a few runs' seconds per block, or 0 if the IR didn't load
+    juce::dsp::Convolution convolution { juce::dsp::Convolution::NonUniform { hot.highQuality ? kOfflineHeadSize : 0 } };
+    convolution.prepare ({ sampleRate, static_cast<juce::uint32> (samplesPerBlock), static_cast<juce::uint32> (numChannels) });
+
+    juce::AudioBuffer<float> copy (ir);
+    convolution.loadImpulseResponse (std::move (copy), sampleRate,
+                                     juce::dsp::Convolution::Stereo::yes,
+                                     juce::dsp::Convolution::Trim::no,
+                                     juce::dsp::Convolution::Normalise::no);
+
+    std::array<FilterDesign, kMaxFilters> designs;
+    const int numFilters = withFilters ? makeFilterDesigns (preset, designs) : 0;
+    std::array<DspKernels::BiquadCoefficients, kMaxFilters> coefs {};
+    std::array<DspKernels::PreciseBiquadCoefficients, kMaxFilters> preciseCoefs {};
+    std::array<DspKernels::BiquadState, kMaxChannels * kMaxFilters> states {};
+    std::array<DspKernels::PreciseBiquadState, kMaxChannels * kMaxFilters> preciseStates {};
+
+    for (int f = 0; f < numFilters; ++f)
+    {
+        preciseCoefs[static_cast<size_t> (f)] = designBiquad (designs[static_cast<size_t> (f)]);
+        coefs[static_cast<size_t> (f)]        = toFloat (preciseCoefs[static_cast<size_t> (f)]);
+    }
+
+    juce::AudioBuffer<float> block (numChannels, samplesPerBlock), dry (numChannels, samplesPerBlock);
+    juce::Random random (1);
+    const auto& kernels = DspKernels::get();
+
+    auto processBlock = [&]
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int s = 0; s < samplesPerBlock; ++s)
+                block.setSample (ch, s, random.nextFloat() - 0.5f);
+
+        const auto start = juce::Time::getHighResolutionTicks();
+
+        if (withFilters)
+        {
+            if (hot.highQuality)
+                kernels.biquadCascadePrecise (block.getArrayOfWritePointers(), numChannels, samplesPerBlock,
+                                              preciseCoefs.data(), numFilters, preciseStates.data());
+            else
+                kernels.biquadCascade (block.getArrayOfWritePointers(), numChannels, samplesPerBlock,
+                                       coefs.data(), numFilters, states.data());
+
+            dry.makeCopyOf (block, true);
+        }
+
+        juce::dsp::AudioBlock<float> audioBlock (block);
+        juce::dsp::ProcessContextReplacing<float> context (audioBlock);
+        convolution.process (context);
+
+        if (withFilters)
+            for (int ch = 0; ch < numChannels; ++ch)
+                kernels.blend (block.getWritePointer (ch), dry.getReadPointer (ch),
+                               1.0f - preset.irWetMix, preset.irWetMix, samplesPerBlock);
+
+        return juce::Time::getHighResolutionTicks() - start;
+    };
+
+    // The loader installs the IR from its own thread, then crossfades into it
+    const auto deadline = juce::Time::getMillisecondCounter() + static_cast<juce::uint32> (kBenchmarkLoadTimeoutMs);
+
+    while (convolution.getCurrentIRSize() == 0)
+    {
+        if (juce::Time::getMillisecondCounter() >= deadline || presetDataJob.shouldExit())
+            return 0.0;
+
+        processBlock();
+        juce::Thread::sleep (1);
+    }
+
+    for (int warm = 0; warm < static_cast<int> (sampleRate * 0.1) / samplesPerBlock + 1; ++warm)
+        processBlock();
+
+    juce::int64 fastest = std::numeric_limits<juce::int64>::max();
+
+    for (int run = 0; run < kBenchmarkRuns; ++run)
+    {
+        juce::int64 ticks = 0;
+
+        for (int b = 0; b < kBenchmarkBlocks; ++b)
+            ticks += processBlock();
+
+        fastest = juce::jmin (fastest, ticks);
+    }
+
+    return juce::Time::highResolutionTicksToSeconds (fastest) / kBenchmarkBlocks;
+}
+
+juce::AudioBuffer<float> EnvironmentProcessor::buildFusedIR (const EnvironmentPreset& preset,
+                                                             const juce::AudioBuffer<float>& ir) const
+{
+    // The live cascade's own designs, so the fused and separate paths differ only by rounding
+    std::array<FilterDesign, kMaxFilters> designs;
+    std::array<DspKernels::PreciseBiquadCoefficients, kMaxFilters> coefs {};
+    const int numFilters = makeFilterDesigns (preset, designs);
+
+    for (int i = 0; i < numFilters; ++i)
+        coefs[static_cast<size_t> (i)] = designBiquad (designs[static_cast<size_t> (i)]);
+
+    const int irLength = ir.getNumSamples();
+    const int length   = irLength + static_cast<int> (sampleRate * kFusedEqTailSeconds);
+    const float dryGain = 1.0f - preset.irWetMix;
+    const float wetGain = preset.irWetMix;
+
+    // Stereo, or true stereo where only the direct paths carry the dry signal
+    const bool trueStereo = ir.getNumChannels() == ImpulseResponse::numTrueStereoPaths;
+    const int  numPaths   = trueStereo ? ImpulseResponse::numTrueStereoPaths : 2;
+
+    juce::AudioBuffer<float> fused (numPaths, length);
+    fused.clear();
+
+    for (int ch = 0; ch < numPaths; ++ch)
+    {
+        auto* out       = fused.getWritePointer (ch);
+        const auto* wet = ir.getReadPointer (juce::jmin (ch, ir.getNumChannels() - 1));
+        const bool direct = ! trueStereo
+                             || ch == ImpulseResponse::leftToLeft || ch == ImpulseResponse::rightToRight;
+
+        // Blend: unit impulse for the dry path plus the scaled IR for the wet path
+        out[0] = direct ? dryGain : 0.0f;
+        for (int s = 0; s < irLength; ++s)
+            out[s] += wet[s] * wetGain;
+
+        // Running the blended IR through the EQ convolves the two responses
+        std::array<DspKernels::PreciseBiquadState, kMaxFilters> states {};
+        float* const path[] = { out };
+        DspKernels::get().biquadCascadePrecise (path, 1, length, coefs.data(), numFilters, states.data());
+    }
+
+    // Drop the part of the EQ tail that has decayed into silence (offline, only the leading silence)
+    ImpulseResponse::trim (fused, ! hot.highQuality);
+    return fused;
+}
+
+//==============================================================================
+void EnvironmentProcessor::rebuildFilters()
+{
+    // Reset all filters (a morph keeps its state: its stages only ever glide)
+    if (! hot.morphActive)
+    {
+        std::fill (hot.filterStates.begin(), hot.filterStates.end(), DspKernels::BiquadState {});
+        std::fill (preciseFilterStates.begin(), preciseFilterStates.end(), DspKernels::PreciseBiquadState {});
+    }
+
+    hot.activeFilterCount       = 0;
+    hot.compressorActive        = false;
+    hot.driverActive            = false;
+    hot.codecActive             = false;
+    hot.convolverActive         = false;
+    hot.fusedActive             = false;
+    hot.activeEcoModel          = nullptr;
+    if (tailConvolverReady.load (std::memory_order_acquire))
+        tailConvolver.setTail (nullptr);
+    hot.trueStereoActive        = false;
+    hot.cabinActive             = false;
+    if (trueStereoReady.load (std::memory_order_acquire))
+        trueStereoConvolver.setIR (nullptr);
+    hot.earlyReflectionsActive  = false;
+    hot.irWetMix                = 0.0f;
+    hot.stereoWidth             = 1.0f;
+    hot.numReflectionTaps       = 0;
+    hot.reflectionLevel         = 1.0f;
+    hot.morphConvolverActive    = false;
+    hot.waitingForIRHandoff     = false;
+    hot.waitingForTailConvolver = false;
+    hot.irPath                  = IRPath::plain;
+    hot.morphTrueStereoActive   = false;
+    hot.morphCabinActive        = false;
+    hot.waitingForMorphEngines  = false;
+    if (morphEnginesReady.load (std::memory_order_acquire) && morphTrueStereo != nullptr)
+        morphTrueStereo->setIR (nullptr);
+    presetSlotInUse.store (-1);
+    morphSlotInUse.store (-1);
+
+    if (hot.morphActive)
+    {
+        // Each end's own IR on the separate path, blended by applyMorph()
+        hot.waitingForPresetData = false;
+        rebuildMorph();
+        return;
+    }
+
+    const auto& preset = presets[static_cast<size_t> (hot.currentPresetIndex)];
+
+    if (hot.currentPresetIndex == 0)
+    {
+        // Bypass – no processing
+        hot.outputGain = 1.0f;
+        return;
+    }
+
+    // ---- IIR Filters + Convolution IR ----
+    // Claimed before looking, so a rebuild of the preset's data either sees
+    // the claim or is seen to have started (see releasePresetData())
+    const auto presetSlot = static_cast<size_t> (hot.currentPresetIndex);
+    presetSlotInUse.store (hot.currentPresetIndex);
+    const bool dataReady  = presetDataReady[presetSlot].load();
+    hot.presetDataSeen    = dataReady;
+
+    // Anything beyond the plain path needs the background-built preset data
+    hot.waitingForPresetData = ! dataReady
+                            && (quality == Quality::eco || asyncTails || hot.highQuality || hasUserIR[presetSlot].load()
+                                 || usesTrueStereo (preset, quality) || usesCabinModel (preset, quality)
+                                 || convolutionModes[presetSlot].load() != ConvolutionMode::separate);
+
+    if (hot.waitingForPresetData && ! presetDataJobStarted.load())
+        requestUpdate();
+
+    // Async tails switched on since the job started: the preset plays without them until
+    // the tail convolver has been made, as that joins the worker pool
+    hot.waitingForTailConvolver = dataReady && asyncTails && ! tailConvolverReady.load (std::memory_order_acquire)
+                                   && (presetTails[presetSlot].numPartitions > 0
+                                        || fusedTails[presetSlot].numPartitions > 0);
+
+    if (hot.waitingForTailConvolver)
+    {
+        tailConvolverRequested.store (true);
+        requestUpdate();
+    }
+
+    // A handed-off buffer that isn't there yet leaves the separate path standing in
+    const auto path = dataReady ? choosePathFromData (presetSlot, getPathSettings()) : IRPath::plain;
+    hot.irPath = path;
+
+    if (path == IRPath::plain)
+        presetSlotInUse.store (-1);
+
+    if (path == IRPath::fusedTrueStereo
+         || ((path == IRPath::fused || path == IRPath::fusedHead)
+              && loadFromIRHandoff (presetSlot, path, *convolver, hot.convolverActive)))
+    {
+        // EQ and wet/dry blend are already baked into the FIR
+        if (path == IRPath::fusedTrueStereo)
+        {
+            trueStereoConvolver.setIR (&fusedTrueStereoIRs[presetSlot]);
+            hot.trueStereoActive = true;
+        }
+        else if (path == IRPath::fusedHead)
+        {
+            tailConvolver.setTail (&fusedTails[presetSlot]);
+        }
+
+        hot.fusedActive     = true;
+        hot.irWetMix        = 1.0f;
+    }
+    else
+    {
+        std::array<FilterDesign, kMaxFilters> designs;
+        const int numFilters = makeFilterDesigns (preset, designs);
+
+        for (int i = 0; i < numFilters; ++i)
+            setFilterStage (i, designs[static_cast<size_t> (i)]);
+
+        hot.activeFilterCount = numFilters;
+
+        if (path == IRPath::eco)
+        {
+            hot.activeEcoModel = &ecoModels[presetSlot];
+            hot.activeEcoModel->reset();
+        }
+        else if (path == IRPath::cabin)
+        {
+            // The cabin IRs carry their own wet/dry blend, so the EQ stays on the IIR path
+            trueStereoConvolver.setIR (&cabinIRs[presetSlot][static_cast<size_t> (seat)]);
+            hot.trueStereoActive = true;
+            hot.cabinActive      = true;
+        }
+        else if (path == IRPath::trueStereo)
+        {
+            trueStereoConvolver.setIR (&trueStereoIRs[presetSlot]);
+            hot.trueStereoActive = true;
+        }
+        else if ((path == IRPath::head || path == IRPath::full)
+                  && loadFromIRHandoff (presetSlot, path, *convolver, hot.convolverActive))
+        {
+            // A user IR is decoded from its library file by the job, and handed over whole
+            if (path == IRPath::head)
+                tailConvolver.setTail (&presetTails[presetSlot]);
+        }
+        else
+        {
+            loadIR (preset.irResourceName, preset.irResourceSize, *convolver, hot.convolverActive);
+        }
+
+        hot.irWetMix = preset.irWetMix;
+    }
+
+    // ---- Early Reflections (car cabin only; the cabin model has its own) ----
+    if (preset.earlyReflections && ! hot.cabinActive)
+        setUpEarlyReflections();
+
+    // ---- Stereo Width ----
+    hot.stereoWidth = preset.stereoWidth;
+
+    // ---- Output gain ----
+    hot.outputGain = juce::Decibels::decibelsToGain (preset.outputGainDb);
+
+    // ---- Compressor ----
+    // With any lookahead in the preset set, every preset runs through the
+    // compressor's delay line (at unity gain if it doesn't compress)
+    if (preset.compress || lookaheadSamples > 0)
+    {
+        hot.compressorActive = true;
+        compressor.setSettings (makeCompressorSettings (preset));
+    }
+
+    // ---- Speaker driver ----
+    if (preset.driverModel)
+    {
+        hot.driverActive = true;
+        driver.setSettings (makeDriverSettings (preset));
+    }
+
+    // ---- Codec ----
+    // Every preset, coded or not, so the filterbank's delay never changes
+    if (codecLatencySamples > 0)
+    {
+        hot.codecActive = true;
+        codec.setSettings (makeCodecSettings (preset));
+    }
+}
+
+bool EnvironmentProcessor::presetPathChanged (size_t presetSlot)
+{
+    // Claimed first, as in rebuildFilters(), so the slot can't be rebuilt while it's looked at
+    presetSlotInUse.store (static_cast<int> (presetSlot));
+
+    const bool dataReady = presetDataReady[presetSlot].load();
+    const auto path      = dataReady ? choosePathFromData (presetSlot, getPathSettings()) : IRPath::plain;
+
+    if (path != hot.irPath)
+        return true;
+
+    // Built (or being rebuilt) without changing what runs, e.g. a plain preset
+    hot.presetDataSeen       = dataReady;
+    hot.waitingForPresetData = hot.waitingForPresetData && ! dataReady;
+
+    if (path == IRPath::plain)
+        presetSlotInUse.store (-1);
+
+    return false;
+}
+
+EnvironmentProcessor::PathSettings EnvironmentProcessor::getPathSettings() const noexcept
+{
+    return { static_cast<juce::int8> (hot.currentPresetIndex), quality, seat, asyncTails };
+}
+
+EnvironmentProcessor::IRPath EnvironmentProcessor::choosePathFromData (size_t presetSlot,
+                                                                       const PathSettings& settings) const
+{
+    const auto& preset = presets[presetSlot];
+
+    if (settings.quality == Quality::eco && ! hot.highQuality && ecoModels[presetSlot].isValid())
+        return IRPath::eco;
+
+    if (usesCabinModel (preset, settings.quality)
+         && cabinIRs[presetSlot][static_cast<size_t> (settings.seat)].numPartitions > 0)
+        return IRPath::cabin;
+
+    const bool trueStereo = usesTrueStereo (preset, settings.quality);
+
+    if (usesFusedIR (presetSlot) && fusedIRs[presetSlot].getNumSamples() > 0)
+    {
+        if (trueStereo && fusedTrueStereoIRs[presetSlot].numPartitions > 0)
+            return IRPath::fusedTrueStereo;
+
+        return settings.asyncTails && tailConvolverReady.load (std::memory_order_acquire)
+                 && fusedTails[presetSlot].numPartitions > 0
+                 ? IRPath::fusedHead : IRPath::fused;
+    }
+
+    if (trueStereo && trueStereoIRs[presetSlot].numPartitions > 0)
+        return IRPath::trueStereo;
+
+    if (settings.asyncTails && tailConvolverReady.load (std::memory_order_acquire)
+         && presetTails[presetSlot].numPartitions > 0)
+        return IRPath::head;
+
+    if ((userIRs[presetSlot] != nullptr || hot.highQuality) && presetIRs[presetSlot].getNumSamples() > 0)
+        return IRPath::full;
+
+    return IRPath::plain;
+}
+
+EnvironmentProcessor::IRPath EnvironmentProcessor::choosePathForMorph (size_t presetSlot) const
+{
+    // A fused preset has the same response on the separate path, where its EQ can glide;
+    // eco runs its IR, as the morph already pays for two convolutions
+    const auto& preset = presets[presetSlot];
+
+    if (usesCabinModel (preset, quality) && cabinIRs[presetSlot][static_cast<size_t> (seat)].numPartitions > 0)
+        return IRPath::cabin;
+
+    if (usesTrueStereo (preset, quality) && trueStereoIRs[presetSlot].numPartitions > 0)
+        return IRPath::trueStereo;
+
+    return getStereoPathForMorph (presetSlot);
 }
 
-void EnvironmentProcessor::prepare (const juce::dsp::ProcessSpec& spec)
+EnvironmentProcessor::IRPath EnvironmentProcessor::getStereoPathForMorph (size_t presetSlot) const
+{
+    // The direct paths of a true-stereo or cabin preset's IR, if it has to run on a stereo engine
+    return (userIRs[presetSlot] != nullptr || hot.highQuality) && presetIRs[presetSlot].getNumSamples() > 0
+             ? IRPath::full : IRPath::plain;
+}
+
+bool EnvironmentProcessor::usesFusedIR (size_t presetSlot) const
 {
-    sampleRate      = spec.sampleRate;
-    samplesPerBlock = static_cast<int> (spec.maximumBlockSize);
-    numChannels     = static_cast<int> (spec.numChannels);
+    const auto mode = convolutionModes[presetSlot].load();
+    return mode == ConvolutionMode::fused || (mode == ConvolutionMode::automatic && fusedIsCheaper[presetSlot] != 0);
+}
 
-    for (auto& f : filters)
-        f.prepare (spec);
+void EnvironmentProcessor::setUpEarlyReflections()
+{
+    hot.earlyReflectionsActive = true;
 
-    // Convolution engine
-    convolver.prepare (spec);
+    // Delay taps simulating car cabin reflections:
+    // windshield, dashboard, side windows, rear window, headliner
+    struct TapSpec { float delayMs; float gain; };
+    const TapSpec tapSpecs[kMaxReflections] = {
+        { 1.2f, 0.35f },   // windshield (closest, strongest)
+        { 2.1f, 0.25f },   // dashboard
+        { 3.0f, 0.18f },   // left side window
+        { 4.3f, 0.12f },   // right side window
+        { 5.5f, 0.08f },   // rear window (farthest, weakest)
+    };
 
-    // Reflection LP filter
-    reflectionLPFilter.prepare (spec);
+    hot.numReflectionTaps = kMaxReflections;
+    for (int i = 0; i < kMaxReflections; ++i)
+    {
+        hot.reflectionTaps[static_cast<size_t> (i)].delaySamples =
+            static_cast<int> (tapSpecs[i].delayMs * 0.001f * static_cast<float> (sampleRate));
+        hot.reflectionTaps[static_cast<size_t> (i)].gain = tapSpecs[i].gain;
+    }
+
+    // LP filter on reflections to simulate high-frequency absorption
+    hot.reflectionLPCoefs = toFloat (designBiquad ({ FilterDesign::Type::lowPass, 6000.0f, 0.707f, 0.0f }));
+    std::fill (hot.reflectionLPStates.begin(), hot.reflectionLPStates.end(), DspKernels::BiquadState {});
 
-    // Early reflections delay buffer — enough for ~15ms at any sample rate
-    delayBufferSize = static_cast<int> (sampleRate * 0.015);
-    delayBuffer.setSize (numChannels, delayBufferSize);
     delayBuffer.clear();
-    delayWritePos = 0;
+    hot.delayWritePos = 0;
+}
 
-    outputGain.prepare (spec);
-    compressor.prepare (spec);
+LinkedCompressor::Settings EnvironmentProcessor::makeCompressorSettings (const EnvironmentPreset& preset) const
+{
+    LinkedCompressor::Settings settings;
+    settings.lookaheadMs = static_cast<float> (lookaheadSamples * 1000.0 / sampleRate);
 
-    rebuildFilters();
+    if (preset.compress)
+    {
+        settings.thresholdDb = preset.compThreshDb;
+        settings.ratio       = preset.compRatio;
+        settings.kneeDb      = preset.compKneeDb;
+        settings.attackMs    = preset.compAttackMs;
+        settings.releaseMs   = preset.compReleaseMs;
+        settings.rmsDetector = preset.compRmsDetector;
+    }
+
+    return settings;
 }
 
-void EnvironmentProcessor::reset()
+SpeakerDriver::Settings EnvironmentProcessor::makeDriverSettings (const EnvironmentPreset& preset)
 {
-    for (auto& f : filters)
-        f.reset();
+    return { preset.driverResonanceHz, preset.driverLimitDb, preset.driverAsymmetry };
+}
 
-    convolver.reset();
-    reflectionLPFilter.reset();
-    delayBuffer.clear();
-    delayWritePos = 0;
-    outputGain.reset();
-    compressor.reset();
+CodecSimulator::Settings EnvironmentProcessor::makeCodecSettings (const EnvironmentPreset& preset) const
+{
+    if (codecPath == CodecPath::streaming)
+        return { CodecSimulator::Codec::aac, 128.0f };
+
+    if (codecPath == CodecPath::device)
+        return { preset.codec, preset.codecBitrateKbps };
+
+    return {};
 }
 
-void EnvironmentProcessor::setPreset (int idx)
+//==============================================================================
+void EnvironmentProcessor::setMorph (int targetIndex, float amount)
 {
-    if (idx < 0 || idx >= static_cast<int> (presets.size()))
-        idx = 0;
+    if (targetIndex < 0 || targetIndex >= static_cast<int> (presets.size()))
+        targetIndex = hot.currentPresetIndex;
 
-    if (idx != currentPresetIndex)
+    const bool wantsMorph = targetIndex != hot.currentPresetIndex && amount > 0.0f;
+
+    // Engaging (or re-targeting) starts from the selected preset and glides out
+    if (wantsMorph && (! hot.morphActive || targetIndex != morphTargetIndex))
     {
-        currentPresetIndex = idx;
+        if (hot.currentPresetIndex == 0 && ! hot.morphActive)
+            rateConverter.reset();   // the chain hasn't run since bypass was selected
+
+        morphTargetIndex = targetIndex;
+        hot.morphActive  = true;
+        morphPosition.setCurrentAndTargetValue (0.0f);
         rebuildFilters();
     }
+
+    morphPosition.setTargetValue (wantsMorph ? juce::jmin (amount, 1.0f) : 0.0f);
 }
 
-//==============================================================================
-void EnvironmentProcessor::loadIR (const char* data, int dataSize)
+int EnvironmentProcessor::makeFilterDesigns (const EnvironmentPreset& preset,
+                                             std::array<FilterDesign, kMaxFilters>& designs)
 {
-    if (data == nullptr || dataSize == 0)
+    // HP -> LP -> peaks, as parameters for designBiquad()
+    int count = 0;
+    designs[static_cast<size_t> (count++)] = { FilterDesign::Type::highPass, preset.highPassFreq, 0.707f, 0.0f };
+    designs[static_cast<size_t> (count++)] = { FilterDesign::Type::lowPass,  preset.lowPassFreq,  0.707f, 0.0f };
+
+    for (const auto& band : preset.bands)
     {
-        convolverActive = false;
-        return;
+        if (count >= kMaxFilters)
+            break;
+
+        designs[static_cast<size_t> (count++)] = { FilterDesign::Type::peak, band.freq, band.q, band.gainDb };
     }
 
-    convolver.loadImpulseResponse (data, static_cast<size_t> (dataSize),
-                                   juce::dsp::Convolution::Stereo::yes,
-                                   juce::dsp::Convolution::Trim::yes,
-                                   0);  // 0 = use full IR length
-    convolverActive = true;
+    return count;
 }
 
-//==============================================================================
-void EnvironmentProcessor::rebuildFilters()
+DspKernels::PreciseBiquadCoefficients EnvironmentProcessor::designBiquad (const FilterDesign& design) const
+{
+    if (design.type == FilterDesign::Type::unity)
+        return {};
+
+    // The RBJ forms juce::dsp::IIR::Coefficients uses, without its heap allocation
+    const double freq = juce::jlimit (10.0, sampleRate * 0.45, static_cast<double> (design.freq));
+    const double q    = static_cast<double> (design.q);
+
+    if (design.type == FilterDesign::Type::peak)
+    {
+        const double a     = std::sqrt (juce::Decibels::decibelsToGain (static_cast<double> (design.gainDb)));
+        const double omega = juce::MathConstants<double>::twoPi * freq / sampleRate;
+        const double alpha = std::sin (omega) / (2.0 * q);
+        const double c2    = -2.0 * std::cos (omega);
+        const double a0    = 1.0 + alpha / a;
+
+        return { (1.0 + alpha * a) / a0, c2 / a0, (1.0 - alpha * a) / a0, c2 / a0, (1.0 - alpha / a) / a0 };
+    }
+
+    const double n    = 1.0 / std::tan (juce::MathConstants<double>::pi * freq / sampleRate);
+    const double n2   = n * n;
+    const double invQ = 1.0 / q;
+    const double c1   = 1.0 / (1.0 + invQ * n + n2);
+    const double a1   = c1 * 2.0 * (1.0 - n2);
+    const double a2   = c1 * (1.0 - invQ * n + n2);
+
+    if (design.type == FilterDesign::Type::highPass)
+        return { c1 * n2, -2.0 * c1 * n2, c1 * n2, a1, a2 };
+
+    return { c1, 2.0 * c1, c1, a1, a2 };
+}
+
+DspKernels::BiquadCoefficients EnvironmentProcessor::toFloat (const DspKernels::PreciseBiquadCoefficients& coefs)
+{
+    return { static_cast<float> (coefs.b0), static_cast<float> (coefs.b1), static_cast<float> (coefs.b2),
+             static_cast<float> (coefs.a1), static_cast<float> (coefs.a2) };
+}
+
+void EnvironmentProcessor::setFilterStage (int index, const FilterDesign& design)
 {
-    // Reset all filters
-    for (auto& f : filters)
-        f.reset();
+    setFilterStage (index, designBiquad (design));
+}
+
+void EnvironmentProcessor::setFilterStage (int index, const DspKernels::PreciseBiquadCoefficients& coefs)
+{
+    // Both precisions, so a stage is ready whichever cascade runs
+    preciseFilterCoefs[static_cast<size_t> (index)] = coefs;
+    hot.filterCoefs[static_cast<size_t> (index)]    = toFloat (coefs);
+}
 
-    activeFilterCount       = 0;
-    compressorActive        = false;
-    convolverActive         = false;
-    earlyReflectionsActive  = false;
-    irWetMix                = 0.0f;
-    stereoWidth             = 1.0f;
-    numReflectionTaps       = 0;
+void EnvironmentProcessor::rebuildMorph()
+{
+    const auto& from = presets[static_cast<size_t> (hot.currentPresetIndex)];
+    const auto& to   = presets[static_cast<size_t> (morphTargetIndex)];
 
-    const auto& preset = presets[static_cast<size_t> (currentPresetIndex)];
+    // EQ: stage for stage.  Where one side has fewer stages a flat peak stands in
+    // for a band, and pass-through for the high- / low-pass; Bypass has none, so
+    // its end is exactly flat rather than its preset's 20 Hz / 20 kHz edges
+    const int numFrom = hot.currentPresetIndex == 0 ? 0 : makeFilterDesigns (from, morphFrom);
+    const int numTo   = morphTargetIndex == 0 ? 0 : makeFilterDesigns (to, morphTo);
+    hot.activeFilterCount = juce::jmax (numFrom, numTo);
 
-    if (currentPresetIndex == 0)
+    auto standIn = [] (const FilterDesign& other) -> FilterDesign
     {
-        // Bypass – no processing
-        outputGain.setGainDecibels (0.0f);
-        return;
+        return { other.type == FilterDesign::Type::peak ? FilterDesign::Type::peak : FilterDesign::Type::unity,
+                 other.freq, other.q, 0.0f };
+    };
+
+    for (int i = numFrom; i < hot.activeFilterCount; ++i)
+        morphFrom[static_cast<size_t> (i)] = standIn (morphTo[static_cast<size_t> (i)]);
+
+    for (int i = numTo; i < hot.activeFilterCount; ++i)
+        morphTo[static_cast<size_t> (i)] = standIn (morphFrom[static_cast<size_t> (i)]);
+
+    // IRs: each end's as it runs on its own, side by side and crossfaded.  The
+    // selected preset keeps the main engines; the target gets the morph's own,
+    // made on the update thread the first time they're needed.  Both ends are
+    // claimed before their data is looked at, as in rebuildFilters()
+    const auto fromSlot = static_cast<size_t> (hot.currentPresetIndex);
+    const auto toSlot   = static_cast<size_t> (morphTargetIndex);
+    presetSlotInUse.store (hot.currentPresetIndex);
+    morphSlotInUse.store (morphTargetIndex);
+    hot.presetDataSeen = presetDataReady[fromSlot].load();
+    hot.morphDataSeen  = presetDataReady[toSlot].load();
+
+    const bool enginesReady    = morphEnginesReady.load (std::memory_order_acquire);
+    hot.waitingForMorphEngines = ! enginesReady;
+
+    if (! enginesReady)
+    {
+        morphEnginesRequested.store (true);
+        requestUpdate();
     }
 
-    // ---- IIR Filters ----
+    const auto fromPath = hot.presetDataSeen ? choosePathForMorph (fromSlot) : IRPath::plain;
+    auto toPath         = hot.morphDataSeen ? choosePathForMorph (toSlot) : IRPath::plain;
+
+    if ((toPath == IRPath::cabin || toPath == IRPath::trueStereo) && (! enginesReady || morphTrueStereo == nullptr))
+        toPath = getStereoPathForMorph (toSlot);
+
+    loadMorphEnd (fromSlot, fromPath, convolver, hot.convolverActive,
+                  &trueStereoConvolver, hot.trueStereoActive, hot.cabinActive);
+
+    if (enginesReady)
+        loadMorphEnd (toSlot, toPath, morphConvolver.get(), hot.morphConvolverActive,
+                      morphTrueStereo.get(), hot.morphTrueStereoActive, hot.morphCabinActive);
+
+    if (fromPath == IRPath::plain)
+        presetSlotInUse.store (-1);
+    if (toPath == IRPath::plain || ! enginesReady)
+        morphSlotInUse.store (-1);
+
+    if (from.earlyReflections || to.earlyReflections)
+        setUpEarlyReflections();
+
+    hot.compressorActive = from.compress || to.compress || lookaheadSamples > 0;
+    hot.driverActive     = from.driverModel || to.driverModel;
+    hot.codecActive      = codecLatencySamples > 0;
+
+    applyMorph (morphPosition.getCurrentValue());
+}
+
+void EnvironmentProcessor::loadMorphEnd (size_t presetSlot, IRPath path,
+                                         juce::dsp::Convolution* stereo, bool& stereoActive,
+                                         TrueStereoConvolver* trueStereo, bool& trueStereoActive, bool& cabinActive)
+{
+    const auto& preset = presets[presetSlot];
 
-    // High-pass
-    if (activeFilterCount < kMaxFilters)
+    if (path == IRPath::cabin)
+    {
+        trueStereo->setIR (&cabinIRs[presetSlot][static_cast<size_t> (seat)]);
+        trueStereoActive = true;
+        cabinActive      = true;
+    }
+    else if (path == IRPath::trueStereo)
+    {
+        trueStereo->setIR (&trueStereoIRs[presetSlot]);
+        trueStereoActive = true;
+    }
+    else if (path != IRPath::full || ! loadFromIRHandoff (presetSlot, path, *stereo, stereoActive))
     {
-        *filters[static_cast<size_t> (activeFilterCount)].state =
-            *IIRCoefs::makeHighPass (sampleRate, preset.highPassFreq, 0.707f);
-        activeFilterCount++;
+        // The built-in IR stands in until a user IR's (or offline, the full) buffer arrives
+        loadIR (preset.irResourceName, preset.irResourceSize, *stereo, stereoActive);
     }
+}
 
-    // Low-pass
-    if (activeFilterCount < kMaxFilters)
+void EnvironmentProcessor::createMorphEngines()
+{
+    // Same engine as the selected preset's; the true-stereo one only once the
+    // job has sized trueStereoConvolver, and for the same IRs
+    morphConvolver = hot.highQuality
+                       ? std::make_unique<juce::dsp::Convolution> (juce::dsp::Convolution::NonUniform { kOfflineHeadSize })
+                       : std::make_unique<juce::dsp::Convolution>();
+    morphConvolver->prepare ({ sampleRate, static_cast<juce::uint32> (samplesPerBlock),
+                               static_cast<juce::uint32> (numChannels) });
+
+    if (trueStereoReady.load (std::memory_order_acquire) && trueStereoPartitionCapacity.load() > 0)
     {
-        *filters[static_cast<size_t> (activeFilterCount)].state =
-            *IIRCoefs::makeLowPass (sampleRate, preset.lowPassFreq, 0.707f);
-        activeFilterCount++;
+        morphTrueStereo = std::make_unique<TrueStereoConvolver>();
+        morphTrueStereo->prepare (TrueStereoConvolver::getPartitionSizeForBlockSize (samplesPerBlock),
+                                  trueStereoPartitionCapacity.load());
     }
 
-    // Peak EQ bands
-    for (const auto& band : preset.bands)
+    morphEnginesReady.store (true, std::memory_order_release);
+}
+
+void EnvironmentProcessor::applyMorph (float position)
+{
+    const auto& from = presets[static_cast<size_t> (hot.currentPresetIndex)];
+    const auto& to   = presets[static_cast<size_t> (morphTargetIndex)];
+
+    auto lerp = [position] (float a, float b) { return a + (b - a) * position; };
+    auto glide = [position] (float a, float b) { return a * std::pow (b / a, position); };   // for Hz, Q, ms
+
+    // Interpolating the design keeps every intermediate filter a stable biquad.
+    // A pass-through end has no design to glide, so its stage crossfades the
+    // coefficients instead: the stable (a1, a2) region is a triangle, and so
+    // convex, so that stays stable too
+    for (int i = 0; i < hot.activeFilterCount; ++i)
     {
-        if (activeFilterCount >= kMaxFilters)
-            break;
+        const auto& a = morphFrom[static_cast<size_t> (i)];
+        const auto& b = morphTo[static_cast<size_t> (i)];
+
+        if (a.type == b.type)
+        {
+            setFilterStage (i, { a.type, glide (a.freq, b.freq), glide (a.q, b.q), lerp (a.gainDb, b.gainDb) });
+            continue;
+        }
 
-        *filters[static_cast<size_t> (activeFilterCount)].state =
-            *IIRCoefs::makePeakFilter (sampleRate, band.freq, band.q,
-                                       juce::Decibels::decibelsToGain (band.gainDb));
-        activeFilterCount++;
+        const auto ca = designBiquad (a);
+        const auto cb = designBiquad (b);
+        const double t = position;
+
+        setFilterStage (i, { ca.b0 + (cb.b0 - ca.b0) * t, ca.b1 + (cb.b1 - ca.b1) * t, ca.b2 + (cb.b2 - ca.b2) * t,
+                             ca.a1 + (cb.a1 - ca.a1) * t, ca.a2 + (cb.a2 - ca.a2) * t });
     }
 
-    // ---- Convolution IR ----
-    loadIR (preset.irResourceName, preset.irResourceSize);
-    irWetMix = preset.irWetMix;
+    // A cabin IR has its own blend baked in, so that end contributes no dry signal.
+    // The dry path carries whatever the two wet ones don't
+    const bool fromActive = hot.convolverActive || hot.trueStereoActive;
+    const bool toActive   = hot.morphConvolverActive || hot.morphTrueStereoActive;
+    hot.morphWetFrom    = fromActive ? (1.0f - position) * (hot.cabinActive ? 1.0f : from.irWetMix) : 0.0f;
+    hot.morphWetTo      = toActive ? position * (hot.morphCabinActive ? 1.0f : to.irWetMix) : 0.0f;
+    hot.reflectionLevel = lerp (from.earlyReflections && ! hot.cabinActive ? 1.0f : 0.0f,
+                                to.earlyReflections && ! hot.morphCabinActive ? 1.0f : 0.0f);
+    hot.stereoWidth     = lerp (from.stereoWidth, to.stereoWidth);
+    hot.outputGain      = juce::Decibels::decibelsToGain (lerp (from.outputGainDb, to.outputGainDb));
 
-    // ---- Early Reflections (car cabin only) ----
-    if (preset.earlyReflections)
+    if (hot.compressorActive)
     {
-        earlyReflectionsActive = true;
+        // A preset that doesn't compress is ratio 1 with the other's ballistics;
+        // the ratio glides as its slope so the curve moves evenly
+        auto a = makeCompressorSettings (from);
+        auto b = makeCompressorSettings (to);
 
-        // Delay taps simulating car cabin reflections:
-        // windshield, dashboard, side windows, rear window, headliner
-        struct TapSpec { float delayMs; float gain; };
-        const TapSpec tapSpecs[kMaxReflections] = {
-            { 1.2f, 0.35f },   // windshield (closest, strongest)
-            { 2.1f, 0.25f },   // dashboard
-            { 3.0f, 0.18f },   // left side window
-            { 4.3f, 0.12f },   // right side window
-            { 5.5f, 0.08f },   // rear window (farthest, weakest)
-        };
+        if (! from.compress)
+            a = { b.thresholdDb, 1.0f, b.kneeDb, b.attackMs, b.releaseMs, b.lookaheadMs, b.rmsDetector };
+        if (! to.compress)
+            b = { a.thresholdDb, 1.0f, a.kneeDb, a.attackMs, a.releaseMs, a.lookaheadMs, a.rmsDetector };
 
-        numReflectionTaps = kMaxReflections;
-        for (int i = 0; i < kMaxReflections; ++i)
-        {
-            reflectionTaps[static_cast<size_t> (i)].delaySamples =
-                static_cast<int> (tapSpecs[i].delayMs * 0.001f * static_cast<float> (sampleRate));
-            reflectionTaps[static_cast<size_t> (i)].gain = tapSpecs[i].gain;
-        }
+        const float slope = lerp (1.0f / a.ratio - 1.0f, 1.0f / b.ratio - 1.0f);
+
+        LinkedCompressor::Settings settings = a;
+        settings.thresholdDb = lerp (a.thresholdDb, b.thresholdDb);
+        settings.ratio       = 1.0f / (1.0f + slope);
+        settings.kneeDb      = lerp (a.kneeDb, b.kneeDb);
+        settings.attackMs    = glide (a.attackMs, b.attackMs);
+        settings.releaseMs   = glide (a.releaseMs, b.releaseMs);
+        settings.rmsDetector = position < 0.5f ? a.rmsDetector : b.rmsDetector;
+        compressor.setSettings (settings);
+    }
+
+    if (hot.driverActive)
+    {
+        // A preset without a driver model is the other's driver with its limit
+        // far out of reach; the curve's shape switches halfway, like the detector
+        constexpr float unreachableDb = 40.0f;
+        auto a = makeDriverSettings (from);
+        auto b = makeDriverSettings (to);
 
-        // LP filter on reflections to simulate high-frequency absorption
-        *reflectionLPFilter.state =
-            *IIRCoefs::makeLowPass (sampleRate, 6000.0f, 0.707f);
-        reflectionLPFilter.reset();
+        if (! from.driverModel)
+            a = { b.resonanceHz, unreachableDb, b.asymmetry };
+        if (! to.driverModel)
+            b = { a.resonanceHz, unreachableDb, a.asymmetry };
 
-        delayBuffer.clear();
-        delayWritePos = 0;
+        driver.setSettings ({ glide (a.resonanceHz, b.resonanceHz), lerp (a.limitDb, b.limitDb),
+                              position < 0.5f ? a.asymmetry : b.asymmetry });
     }
 
-    // ---- Stereo Width ----
-    stereoWidth = preset.stereoWidth;
+    // A codec can't be half on: it switches halfway, its bandwidth and bands with it
+    if (hot.codecActive)
+        codec.setSettings (makeCodecSettings (position < 0.5f ? from : to));
 
-    // ---- Output gain ----
-    outputGain.setGainDecibels (preset.outputGainDb);
+    hot.appliedMorph = position;
+}
 
-    // ---- Compressor ----
-    if (preset.compress)
+void EnvironmentProcessor::processMorphConvolution (juce::AudioBuffer<float>& buffer)
+{
+    const int numSamples = buffer.getNumSamples();
+    const int channels   = buffer.getNumChannels();
+    const auto& kernels  = DspKernels::get();
+
+    const bool fromActive = hot.convolverActive || hot.trueStereoActive;
+    const bool toActive   = hot.morphConvolverActive || hot.morphTrueStereoActive;
+
+    if (! fromActive && ! toActive)
+        return;
+
+    // Both ends run the whole time, so neither loses its history while its weight is zero
+    juce::AudioBuffer<float> dryBuffer (scratchBuffer.getArrayOfWritePointers(), channels, numSamples);
+    juce::AudioBuffer<float> toBuffer (morphScratch.getArrayOfWritePointers(), channels, numSamples);
+
+    for (int ch = 0; ch < channels; ++ch)
     {
-        compressorActive = true;
-        compressor.setThreshold (preset.compThreshDb);
-        compressor.setRatio (preset.compRatio);
-        compressor.setAttack (10.0f);
-        compressor.setRelease (100.0f);
+        dryBuffer.copyFrom (ch, 0, buffer, ch, 0, numSamples);
+        toBuffer.copyFrom (ch, 0, buffer, ch, 0, numSamples);
     }
+
+    const float dryGain = 1.0f - hot.morphWetFrom - hot.morphWetTo;
+
+    if (hot.trueStereoActive)
+    {
+        trueStereoConvolver.process (buffer);
+    }
+    else if (hot.convolverActive)
+    {
+        juce::dsp::AudioBlock<float> block (buffer);
+        juce::dsp::ProcessContextReplacing<float> context (block);
+        convolver->process (context);
+    }
+
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        if (fromActive)
+            kernels.blend (buffer.getWritePointer (ch), dryBuffer.getReadPointer (ch), dryGain, hot.morphWetFrom, numSamples);
+        else
+            kernels.scale (buffer.getWritePointer (ch), dryGain, numSamples);
+    }
+
+    if (hot.morphTrueStereoActive)
+    {
+        morphTrueStereo->process (toBuffer);
+    }
+    else if (hot.morphConvolverActive)
+    {
+        juce::dsp::AudioBlock<float> block (toBuffer);
+        juce::dsp::ProcessContextReplacing<float> context (block);
+        morphConvolver->process (context);
+    }
+
+    if (toActive)
+        for (int ch = 0; ch < channels; ++ch)
+            kernels.addScaled (buffer.getWritePointer (ch), toBuffer.getReadPointer (ch), hot.morphWetTo, numSamples);
 }
 
 //==============================================================================
 void EnvironmentProcessor::process (juce::AudioBuffer<float>& buffer)
 {
-    if (currentPresetIndex == 0)
-        return; // bypass
+    // A morph that has glided back to zero hands over to the preset's own path
+    if (hot.morphActive && morphPosition.getTargetValue() <= 0.0f && ! morphPosition.isSmoothing())
+    {
+        hot.morphActive = false;
+
+        if (hot.currentPresetIndex == 0)
+            bypassDelayLine.clear();
+
+        rebuildFilters();
+    }
+
+    if (hot.currentPresetIndex == 0 && hot.latencySamples == 0 && ! hot.morphActive)
+        return;
+
+    // Switch to the fused / eco / async path as soon as the background job has built it,
+    // and the update thread the buffer for it; and off it while a new user IR is built
+    const auto currentSlot = static_cast<size_t> (hot.currentPresetIndex);
+
+    if (hot.morphActive)
+    {
+        // Likewise for either end of a morph, and once its engines have been made
+        const auto targetSlot = static_cast<size_t> (morphTargetIndex);
+
+        if (isPresetDataReady (currentSlot) != hot.presetDataSeen || isPresetDataReady (targetSlot) != hot.morphDataSeen
+             || (hot.waitingForIRHandoff && (irHandoffs[currentSlot].ready.load (std::memory_order_acquire)
+                                              || irHandoffs[targetSlot].ready.load (std::memory_order_acquire)))
+             || (hot.waitingForMorphEngines && morphEnginesReady.load (std::memory_order_acquire)))
+            rebuildFilters();
+    }
+    else if (hot.currentPresetIndex != 0
+              && ((isPresetDataReady (currentSlot) != hot.presetDataSeen && presetPathChanged (currentSlot))
+                   || (hot.waitingForIRHandoff && irHandoffs[currentSlot].ready.load (std::memory_order_acquire))
+                   || (hot.waitingForTailConvolver && tailConvolverReady.load (std::memory_order_acquire))))
+    {
+        rebuildFilters();
+    }
+
+    // Hosts may hand us more than the prepared block size, or a few samples at a
+    // time; the scheduler turns that into blocks of at most hostBlockSize, which
+    // the convolver's internal buffers and our scratch space are sized for
+    scheduler.process (buffer, [this] (juce::AudioBuffer<float>& block) { processScheduledBlock (block); });
+}
+
+void EnvironmentProcessor::processScheduledBlock (juce::AudioBuffer<float>& block)
+{
+    if (hot.currentPresetIndex == 0 && ! hot.morphActive)
+    {
+        processBypassDelay (block);
+        return;
+    }
+
+    if (oversampler != nullptr)
+    {
+        juce::dsp::AudioBlock<float> hostBlock (block);
+        auto upBlock = oversampler->processSamplesUp (hostBlock);
+
+        for (size_t ch = 0; ch < oversampledChannels.size(); ++ch)
+            oversampledChannels[ch] = ch < upBlock.getNumChannels() ? upBlock.getChannelPointer (ch) : nullptr;
+
+        juce::AudioBuffer<float> up (oversampledChannels.data(), block.getNumChannels(),
+                                     static_cast<int> (upBlock.getNumSamples()));
+        processChunk (up);
+
+        oversampler->processSamplesDown (hostBlock);
+    }
+    else if (rateConverter.getFactor() > 1)
+    {
+        const int channels       = block.getNumChannels();
+        const int internalLength = rateConverter.downsample (block, internalBuffer);
+        juce::AudioBuffer<float> internal (internalBuffer.getArrayOfWritePointers(), channels, internalLength);
+
+        if (internalLength > 0)
+            processChunk (internal);
+
+        rateConverter.upsample (internalBuffer, internalLength, block);
+    }
+    else
+    {
+        processChunk (block);
+    }
+}
+
+void EnvironmentProcessor::processBypassDelay (juce::AudioBuffer<float>& buffer)
+{
+    if (hot.chainLatencySamples == 0)
+        return;
+
+    const int numSamples = buffer.getNumSamples();
+    const int channels   = juce::jmin (buffer.getNumChannels(), bypassDelayLine.getNumChannels());
+    int pos = hot.bypassDelayPos;
+
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        auto* data = buffer.getWritePointer (ch);
+        auto* line = bypassDelayLine.getWritePointer (ch);
+        pos = hot.bypassDelayPos;
+
+        for (int s = 0; s < numSamples; ++s)
+        {
+            const float delayed = line[pos];
+            line[pos] = data[s];
+            data[s] = delayed;
 
+            if (++pos == hot.chainLatencySamples)
+                pos = 0;
+        }
+    }
+
+    hot.bypassDelayPos = pos;
+}
+
+void EnvironmentProcessor::processChunk (juce::AudioBuffer<float>& buffer)
+{
     const int numSamples = buffer.getNumSamples();
     const int channels   = buffer.getNumChannels();
+    const auto& kernels  = DspKernels::get();
+
+    // ---- 0. Morph: the whole chain follows the smoothed position once per control block ----
+    if (hot.morphActive)
+    {
+        if (morphPosition.isSmoothing() && numSamples > kMorphControlSamples)
+        {
+            for (int start = 0; start < numSamples; start += kMorphControlSamples)
+            {
+                juce::AudioBuffer<float> part (buffer.getArrayOfWritePointers(), channels, start,
+                                               juce::jmin (kMorphControlSamples, numSamples - start));
+                processChunk (part);
+            }
+
+            return;
+        }
+
+        const float position = morphPosition.skip (numSamples);
+
+        if (position != hot.appliedMorph)
+            applyMorph (position);
+    }
 
-    // ---- 1. IIR Filters (HP -> LP -> Peak EQ) ----
+    // ---- 1. Codec (on the way to the device: BT speaker, or streaming) ----
+    if (hot.codecActive)
+        codec.process (buffer);
+
+    // ---- 2. IIR Filters (HP -> LP -> Peak EQ) ----
+    if (hot.activeFilterCount > 0)
+    {
+        if (hot.highQuality)
+            kernels.biquadCascadePrecise (buffer.getArrayOfWritePointers(), channels, numSamples,
+                                          preciseFilterCoefs.data(), hot.activeFilterCount, preciseFilterStates.data());
+        else
+            kernels.biquadCascade (buffer.getArrayOfWritePointers(), channels, numSamples,
+                                   hot.filterCoefs.data(), hot.activeFilterCount, hot.filterStates.data());
+    }
+
+    // ---- 3. Convolution IR (wet/dry blend) ----
+    if (hot.morphActive)
+    {
+        // Both ends' IRs, crossfaded with the morph
+        processMorphConvolution (buffer);
+    }
+    else if (hot.fusedActive && hot.trueStereoActive)
+    {
+        // Four-path FIR with the EQ and the blend baked in
+        trueStereoConvolver.process (buffer);
+    }
+    else if (hot.cabinActive)
     {
+        // Every speaker's path to the seat, with the blend baked in
+        trueStereoConvolver.process (buffer);
+    }
+    else if (hot.fusedActive)
+    {
+        // Single FIR already contains the EQ and the blend
+        juce::AudioBuffer<float> dryBuffer (scratchBuffer.getArrayOfWritePointers(), channels, numSamples);
+        if (tailConvolver.isActive())
+            for (int ch = 0; ch < channels; ++ch)
+                dryBuffer.copyFrom (ch, 0, buffer, ch, 0, numSamples);
+
         juce::dsp::AudioBlock<float> block (buffer);
         juce::dsp::ProcessContextReplacing<float> context (block);
+        convolver->process (context);
 
-        for (int i = 0; i < activeFilterCount; ++i)
-            filters[static_cast<size_t> (i)].process (context);
+        tailConvolver.process (dryBuffer, buffer);
     }
-
-    // ---- 2. Convolution IR (wet/dry blend) ----
-    if (convolverActive && irWetMix > 0.0f)
+    else if (hot.activeEcoModel != nullptr && hot.irWetMix > 0.0f)
+    {
+        // Eco: fitted IIR model blended in place of the convolution
+        hot.activeEcoModel->process (buffer, hot.irWetMix);
+    }
+    else if ((hot.convolverActive || hot.trueStereoActive) && hot.irWetMix > 0.0f)
     {
         // Save the dry (post-EQ) signal
-        juce::AudioBuffer<float> dryBuffer (channels, numSamples);
+        juce::AudioBuffer<float> dryBuffer (scratchBuffer.getArrayOfWritePointers(), channels, numSamples);
         for (int ch = 0; ch < channels; ++ch)
             dryBuffer.copyFrom (ch, 0, buffer, ch, 0, numSamples);
 
         // Process through convolution (replaces buffer with wet signal)
+        if (hot.trueStereoActive)
+        {
+            trueStereoConvolver.process (buffer);
+        }
+        else
         {
             juce::dsp::AudioBlock<float> block (buffer);
             juce::dsp::ProcessContextReplacing<float> context (block);
-            convolver.process (context);
+            convolver->process (context);
+
+            // Late partitions, computed on the shared worker pool
+            tailConvolver.process (dryBuffer, buffer);
         }
 
         // Blend: output = dry * (1 - wet) + convolved * wet
-        const float dryGain = 1.0f - irWetMix;
-        const float wetGain = irWetMix;
-
         for (int ch = 0; ch < channels; ++ch)
-        {
-            auto* out     = buffer.getWritePointer (ch);
-            const auto* dry = dryBuffer.getReadPointer (ch);
-
-            for (int s = 0; s < numSamples; ++s)
-                out[s] = dry[s] * dryGain + out[s] * wetGain;
-        }
+            kernels.blend (buffer.getWritePointer (ch), dryBuffer.getReadPointer (ch),
+                           1.0f - hot.irWetMix, hot.irWetMix, numSamples);
     }
 
-    // ---- 3. Early Reflections (car cabin only) ----
-    if (earlyReflectionsActive && numReflectionTaps > 0)
+    // ---- 4. Early Reflections (car cabin only) ----
+    if (hot.earlyReflectionsActive && hot.numReflectionTaps > 0)
     {
-        // Create a temp buffer to accumulate reflections
-        juce::AudioBuffer<float> reflectionBuf (channels, numSamples);
+        // Accumulate reflections in preallocated scratch space
+        juce::AudioBuffer<float> reflectionBuf (reflectionScratch.getArrayOfWritePointers(), channels, numSamples);
         reflectionBuf.clear();
 
-        for (int s = 0; s < numSamples; ++s)
+        // The whole block goes into the delay line first, so each tap is at
+        // most two contiguous runs of it (either side of the wrap)
+        for (int ch = 0; ch < channels; ++ch)
         {
-            for (int ch = 0; ch < channels; ++ch)
+            const int firstPart = juce::jmin (numSamples, hot.delayBufferSize - hot.delayWritePos);
+            delayBuffer.copyFrom (ch, hot.delayWritePos, buffer, ch, 0, firstPart);
+            delayBuffer.copyFrom (ch, 0, buffer, ch, firstPart, numSamples - firstPart);
+
+            auto* reflected = reflectionBuf.getWritePointer (ch);
+            const auto* line = delayBuffer.getReadPointer (ch);
+
+            for (int t = 0; t < hot.numReflectionTaps; ++t)
             {
-                // Write current sample to delay buffer
-                delayBuffer.setSample (ch, delayWritePos, buffer.getSample (ch, s));
-
-                // Sum tapped reflections
-                float reflected = 0.0f;
-                for (int t = 0; t < numReflectionTaps; ++t)
-                {
-                    int readPos = delayWritePos - reflectionTaps[static_cast<size_t> (t)].delaySamples;
-                    if (readPos < 0)
-                        readPos += delayBufferSize;
-
-                    reflected += delayBuffer.getSample (ch, readPos)
-                                 * reflectionTaps[static_cast<size_t> (t)].gain;
-                }
-
-                reflectionBuf.setSample (ch, s, reflected);
-            }
+                const auto& tap = hot.reflectionTaps[static_cast<size_t> (t)];
+                int readPos = hot.delayWritePos - tap.delaySamples;
+                if (readPos < 0)
+                    readPos += hot.delayBufferSize;
 
-            delayWritePos = (delayWritePos + 1) % delayBufferSize;
+                const int firstRun = juce::jmin (numSamples, hot.delayBufferSize - readPos);
+                kernels.addScaled (reflected, line + readPos, tap.gain, firstRun);
+                kernels.addScaled (reflected + firstRun, line, tap.gain, numSamples - firstRun);
+            }
         }
 
+        hot.delayWritePos = (hot.delayWritePos + numSamples) % hot.delayBufferSize;
+
         // LP filter the reflections to simulate absorption
-        {
-            juce::dsp::AudioBlock<float> refBlock (reflectionBuf);
-            juce::dsp::ProcessContextReplacing<float> refContext (refBlock);
-            reflectionLPFilter.process (refContext);
-        }
+        kernels.biquadCascade (reflectionBuf.getArrayOfWritePointers(), channels, numSamples,
+                               &hot.reflectionLPCoefs, 1, hot.reflectionLPStates.data());
 
         // Add reflections to signal
         for (int ch = 0; ch < channels; ++ch)
-            buffer.addFrom (ch, 0, reflectionBuf, ch, 0, numSamples);
+            kernels.addScaled (buffer.getWritePointer (ch), reflectionBuf.getReadPointer (ch), hot.reflectionLevel, numSamples);
     }
 
-    // ---- 4. Stereo Width (mid-side processing) ----
-    if (stereoWidth < 1.0f && channels >= 2)
-    {
-        auto* left  = buffer.getWritePointer (0);
-        auto* right = buffer.getWritePointer (1);
-
-        for (int s = 0; s < numSamples; ++s)
-        {
-            const float mid  = (left[s] + right[s]) * 0.5f;
-            const float side = (left[s] - right[s]) * 0.5f;
+    // ---- 5. Stereo Width (mid-side processing) ----
+    if (hot.stereoWidth < 1.0f && channels >= 2)
+        kernels.stereoWidth (buffer.getWritePointer (0), buffer.getWritePointer (1), hot.stereoWidth, numSamples);
 
-            const float scaledSide = side * stereoWidth;
+    // ---- 6. Compressor / limiter (Phone, BT speaker) ----
+    if (hot.compressorActive)
+        compressor.process (buffer);
 
-            left[s]  = mid + scaledSide;
-            right[s] = mid - scaledSide;
-        }
-    }
-
-    // ---- 5. Compressor (BT speaker) ----
-    if (compressorActive)
-    {
-        juce::dsp::AudioBlock<float> block (buffer);
-        juce::dsp::ProcessContextReplacing<float> context (block);
-        compressor.process (context);
-    }
+    // ---- 7. Speaker driver excursion (Phone, Laptop, BT speaker) ----
+    if (hot.driverActive)
+        driver.process (buffer);
 
-    // ---- 6. Output gain trim ----
-    {
-        juce::dsp::AudioBlock<float> block (buffer);
-        juce::dsp::ProcessContextReplacing<float> context (block);
-        outputGain.process (context);
-    }
+    // ---- 8. Output gain trim ----
+    if (hot.outputGain != 1.0f)
+        for (int ch = 0; ch < channels; ++ch)
+            kernels.scale (buffer.getWritePointer (ch), hot.outputGain, numSamples);
 }
@@ -3,6 +3,19 @@
 #include <juce_dsp/juce_dsp.h>
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <BinaryData.h>
+#include "ImpulseResponse.h"
+#include "EcoIRModel.h"
+#include "AsyncTailConvolver.h"
+#include "TrueStereoConvolver.h"
+#include "CabinModel.h"
+#include "RateConverter.h"
+#include "BlockScheduler.h"
+#include "LinkedCompressor.h"
+#include "SpeakerDriver.h"
+#include "CodecSimulator.h"
+#include "IRLibrary.h"
+#include "DspKernels.h"
+#include "MemoryFootprint.h"
 
 //==============================================================================
 /**
@@ -31,17 +44,48 @@ struct EnvironmentPreset
     // Wet/dry blend for convolution (0.0 = fully dry, 1.0 = fully wet)
     float irWetMix        = 0.0f;
 
+    // True-stereo (2x2) convolution.  A 4-channel IR is used as-is; otherwise
+    // the cross paths (L->R, R->L) are derived from the opposite direct path
+    bool  irTrueStereo          = false;
+    float irCrossFeedDb         = -12.0f;
+    float irCrossFeedDelayMs    = 0.3f;
+    float irCrossFeedLowPassHz  = 4000.0f;
+
     // Stereo width via mid-side (0.0 = mono, 1.0 = full stereo)
     float stereoWidth     = 1.0f;
 
     // Early reflections (car cabin simulation)
     bool earlyReflections = false;
 
-    // Whether to apply simple dynamics compression
+    // Multi-speaker cabin (CabinModel) heard from a selectable seat.  Once
+    // built, it replaces the IR blend and the early reflection taps
+    bool cabinModel       = false;
+
+    // Whether to apply stereo-linked dynamics compression / limiting
     bool  compress       = false;
-    // Compression threshold (dB) and ratio
+    // Compression threshold (dB), ratio and soft knee width (dB)
     float compThreshDb   = 0.0f;
     float compRatio      = 1.0f;
+    float compKneeDb     = 0.0f;
+    // Ballistics (ms); lookahead adds latency, reported by the processor
+    float compAttackMs   = 10.0f;
+    float compReleaseMs  = 100.0f;
+    float compLookaheadMs = 0.0f;
+    // RMS detector (program-dependent, like speaker DSP) instead of peak
+    bool  compRmsDetector = false;
+
+    // Small-driver nonlinearity (SpeakerDriver), after the amp's dynamics:
+    // the band below the resonance compresses and distorts as its level
+    // approaches driverLimitDb (dBFS), outward travel first by driverAsymmetry
+    bool  driverModel       = false;
+    float driverResonanceHz = 800.0f;
+    float driverLimitDb     = 0.0f;
+    float driverAsymmetry   = 0.0f;
+
+    // The lossy link the audio reaches the device over (CodecSimulator), used
+    // when the processor's codec path is "device"; bitrate is the whole stream
+    CodecSimulator::Codec codec = CodecSimulator::Codec::none;
+    float codecBitrateKbps      = 328.0f;
 };
 
 //==============================================================================
@@ -56,7 +100,7 @@ struct EnvironmentPreset
     EQ bands do the heavy lifting for frequency shaping.
     Convolution IRs are blended in subtly for realistic speaker/room coloring.
 */
-inline std::vector<EnvironmentPreset> getBuiltInPresets()
+inline std::vector<EnvironmentPreset> makeBuiltInPresets()
 {
     std::vector<EnvironmentPreset> presets;
 
@@ -87,6 +131,7 @@ inline std::vector<EnvironmentPreset> getBuiltInPresets()
         p.irWetMix         = 0.10f;      // very subtle cabin coloring
         p.stereoWidth      = 0.6f;
         p.earlyReflections = true;
+        p.cabinModel       = true;       // door / dash / rear deck speakers to the chosen seat
         presets.push_back (p);
     }
 
@@ -106,6 +151,16 @@ inline std::vector<EnvironmentPreset> getBuiltInPresets()
         p.irResourceSize   = BinaryData::phone_ir_wavSize;
         p.irWetMix         = 0.08f;      // hint of speaker coloring
         p.stereoWidth      = 0.0f;
+        p.compress         = true;       // fast protection limiter on the amp
+        p.compThreshDb     = -10.0f;
+        p.compRatio        = 10.0f;
+        p.compKneeDb       = 4.0f;
+        p.compAttackMs     = 1.0f;
+        p.compReleaseMs    = 60.0f;
+        p.driverModel      = true;       // 11 mm micro-speaker: runs out of travel first
+        p.driverResonanceHz = 900.0f;
+        p.driverLimitDb    = -16.0f;
+        p.driverAsymmetry  = 0.25f;
         presets.push_back (p);
     }
 
@@ -125,6 +180,10 @@ inline std::vector<EnvironmentPreset> getBuiltInPresets()
         p.irResourceSize   = BinaryData::laptop_ir_wavSize;
         p.irWetMix         = 0.08f;      // hint of speaker coloring
         p.stereoWidth      = 0.4f;
+        p.driverModel      = true;       // no limiter in front of the drivers
+        p.driverResonanceHz = 650.0f;
+        p.driverLimitDb    = -12.0f;
+        p.driverAsymmetry  = 0.15f;
         presets.push_back (p);
     }
 
@@ -143,27 +202,50 @@ inline std::vector<EnvironmentPreset> getBuiltInPresets()
         p.irResourceName   = BinaryData::bt_speaker_ir_wav;
         p.irResourceSize   = BinaryData::bt_speaker_ir_wavSize;
         p.irWetMix         = 0.10f;      // subtle speaker coloring
+        p.irTrueStereo     = true;       // both drivers share one enclosure
+        p.irCrossFeedDb    = -3.0f;
+        p.irCrossFeedDelayMs   = 0.1f;
+        p.irCrossFeedLowPassHz = 8000.0f;
         p.stereoWidth      = 0.0f;
         p.compress         = true;
         p.compThreshDb     = -12.0f;
         p.compRatio        = 4.0f;
+        p.compKneeDb       = 6.0f;
+        p.compAttackMs     = 10.0f;
+        p.compReleaseMs    = 100.0f;
+        p.compRmsDetector  = true;
+        p.driverModel      = true;       // the bass boost eats the woofer's excursion
+        p.driverResonanceHz = 110.0f;
+        p.driverLimitDb    = -10.0f;
+        p.driverAsymmetry  = 0.1f;
+        p.codec            = CodecSimulator::Codec::sbc;   // A2DP's mandatory codec, at its high-quality bitpool
+        p.codecBitrateKbps = 328.0f;
         presets.push_back (p);
     }
 
     return presets;
 }
 
+/** The built-in preset table, built once per process and shared by every instance. */
+inline const std::vector<EnvironmentPreset>& getBuiltInPresets()
+{
+    static const std::vector<EnvironmentPreset> presets = makeBuiltInPresets();
+    return presets;
+}
+
 //==============================================================================
 /**
     Applies the full processing chain for a selected environment preset:
-    HP -> LP -> Peak EQ -> Convolution IR (wet/dry blend) ->
+    Codec (BT / streaming) -> HP -> LP -> Peak EQ ->
+    Convolution IR, stereo or true stereo (wet/dry blend) ->
     Early Reflections (car only) -> Stereo Width ->
-    Compressor (BT only) -> Output Gain
+    Compressor (Phone / BT) -> Speaker Driver (Phone / Laptop / BT) -> Output Gain
 */
 class EnvironmentProcessor
 {
 public:
     EnvironmentProcessor();
+    ~EnvironmentProcessor();
 
     void prepare (const juce::dsp::ProcessSpec& spec);
     void process (juce::AudioBuffer<float>& buffer);
@@ -171,58 +253,582 @@ public:
 
     /** Select a preset by index (0 = bypass). */
     void setPreset (int presetIndex);
-    int  getPreset() const { return currentPresetIndex; }
+    int  getPreset() const { return hot.currentPresetIndex; }
+    int  getNumPresets() const { return static_cast<int> (presets.size()); }
+
+    /**
+        Latency of the chain in host samples: the buffered block scheduler, the
+        reduced-rate resamplers, the codec's filterbank and the largest
+        compressor lookahead of any preset.  Constant for a given
+        prepare(), so presets without lookahead (and bypass) are delayed to
+        match and switching never moves the timing.
+    */
+    int  getLatencySamples() const { return hot.latencySamples; }
+
+    /**
+        When enabled, the next prepare() picks the lowest internal rate every
+        preset's bandwidth (its low-pass) allows, e.g. 48 kHz in a 192 kHz
+        session, and runs the whole chain there between RateConverter's
+        polyphase decimator and interpolator.  Takes effect on prepare() since
+        it changes every filter, IR and the reported latency.
+    */
+    void setReducedRate (bool shouldReduce) { reducedRate = shouldReduce; }
+    bool getReducedRate() const             { return reducedRate; }
+
+    /**
+        How host buffers are cut up before they reach the chain; see
+        BlockScheduler.  Buffered mode adds a block of latency, so like the
+        reduced rate this takes effect on the next prepare().
+    */
+    void setBlockScheduling (BlockScheduler::Mode newMode) { blockScheduling = newMode; }
+    BlockScheduler::Mode getBlockScheduling() const        { return blockScheduling; }
+
+    /**
+        Which lossy codec the audio crosses before it reaches the device:
+        none, each preset's own link (SBC for the Bluetooth speaker), or a
+        128 kbps AAC stream for every preset.  Whenever a codec can run, all
+        presets pass through its filterbank (uncoded where they have none),
+        so its latency is constant; that's why this takes effect on the next
+        prepare().
+    */
+    enum class CodecPath
+    {
+        off,
+        device,
+        streaming
+    };
+
+    void setCodecPath (CodecPath newPath) { codecPath = newPath; }
+    CodecPath getCodecPath() const        { return codecPath; }
+
+    /**
+        Offline bounces: the next prepare() runs the chain 2x oversampled with
+        the EQ accumulated in double, loads IRs with their full tails into a
+        larger-partition engine, and ignores the reduced rate and eco quality.
+        The oversampler's filters add a few samples of latency, reported as
+        usual.  The full IRs are decoded by the preset data job; prepare()
+        doesn't wait for them, and until the current preset's is ready it
+        plays the loader's trimmed copy.  Offline renders that must not
+        depend on that wait for isConvolutionReady().  Switching back for
+        live playback is another prepare(); process() never switches by
+        itself.
+    */
+    void setHighQuality (bool shouldUseHighQuality) { hot.highQuality = shouldUseHighQuality; }
+    bool getHighQuality() const                     { return hot.highQuality; }
+
+    /**
+        Continuous morph from the selected preset (amount 0) to targetIndex
+        (amount 1); call every block.  The amount is smoothed and, while it
+        moves, the chain is redesigned once per kMorphControlSamples: each EQ
+        stage's frequency, Q and gain are interpolated and redesigned (so
+        every intermediate filter is stable), both IRs run and are crossfaded,
+        and width, gain, reflection level, compressor and driver settings
+        ramp.  A stationary morph costs no more than a preset plus the second
+        IR.
+
+        Each end runs the IR it uses on its own: cabin, true stereo, a user
+        IR or offline the full one, with the EQ on the IIR path (a fused
+        preset runs its separate equivalent, an eco one its IR).  The target's
+        engines are made on the update thread by the first morph after
+        prepare(); until then its IR is silent.  Gliding back to 0 returns to
+        the preset's own path.
+    */
+    void setMorph (int targetIndex, float amount);
+    bool isMorphing() const { return hot.morphActive; }
+
+    /** Host rate / internal rate for the current prepare() (1 = full rate). */
+    int  getInternalRateFactor() const      { return rateConverter.getFactor(); }
+
+    /**
+        False while juce::dsp::Convolution is still loading the IR on its
+        background thread, or while the preset's fused / eco / tail data, or
+        the buffer handed to the convolver, is still being built.  Offline
+        renders wait for this so output doesn't depend on loader timing.
+    */
+    bool isConvolutionReady() const;
+
+    /**
+        How the EQ cascade and the convolution blend are run for a preset.
+        Both stages are LTI, so "fused" precomputes one FIR per preset and
+        sample rate (EQ response convolved with the wet/dry-blended IR) and
+        runs a single convolution instead of the IIR cascade + IR + blend.
+        Which one is cheaper depends on IR length vs. band count, so it's
+        selectable per preset; "automatic" runs whichever the preset data
+        job measured to be cheaper for that preset at this rate and block
+        size, and the separate path until it has.
+    */
+    enum class ConvolutionMode
+    {
+        separate,
+        fused,
+        automatic
+    };
+
+    void setConvolutionMode (int presetIndex, ConvolutionMode mode);
+    ConvolutionMode getConvolutionMode (int presetIndex) const;
+
+    /**
+        Normal runs the real IR through FFT convolution.  Eco replaces it with
+        a small IIR model fitted to the IR at prepare time (see EcoIRModel),
+        trading a little spectral accuracy for a much cheaper chain.  Eco
+        takes precedence over the fused convolution mode.
+    */
+    enum class Quality : juce::uint8
+    {
+        normal,
+        eco
+    };
+
+    void    setQuality (Quality newQuality);
+    Quality getQuality() const { return quality; }
+
+    /**
+        RMS spectral error (dB) of a preset's eco model against its real IR,
+        or -1 until the model has been fitted on the preset data thread.
+    */
+    float getEcoSpectralErrorDb (int presetIndex) const;
+
+    /**
+        When enabled, only the first AsyncTailConvolver::kHeadLength samples of
+        each IR run on the calling thread; the rest is computed on the worker
+        pool shared by all instances.  IRs shorter than the head are unaffected.
+        The pool is only started once an instance uses async tails; one
+        switched on after prepare() plays the whole IR here until it has.
+    */
+    void setAsyncTails (bool shouldUseWorkers);
+    bool getAsyncTails() const { return asyncTails; }
+
+    /**
+        True while the current preset runs its IR through the 2x2
+        TrueStereoConvolver.  Presets with irTrueStereo switch to it once their
+        data is built (stereo layouts only); they use the plain stereo
+        convolver until then, and in eco quality.  Async tails don't apply.
+    */
+    bool isTrueStereoActive() const { return hot.trueStereoActive; }
+
+    /**
+        Listening seat for presets with a cabin model.  Each seat's cabin IR
+        is built with the preset data, so switching seats swaps IRs without
+        recomputing anything.
+    */
+    void setSeat (CabinModel::Seat newSeat);
+    CabinModel::Seat getSeat() const { return seat; }
+    bool isCabinModelActive() const { return hot.cabinActive; }
+
+    /**
+        A library IR in place of a preset's built-in one (nullptr restores
+        the built-in).  The mapped file is only read on the preset data
+        thread, which decodes and partitions it like a built-in IR, so it
+        gets the fused, eco, async tail, true-stereo and cabin paths too.
+        Until it's built the preset plays its built-in IR, in a morph too.
+        Message thread.
+
+        Once prepared, the preset's data is rebuilt in the background and
+        the preset switches over when it's done.  Returns false if the IR
+        is longer than the convolvers were prepared for, or the background
+        job wouldn't restart within kJobRestartTimeoutMs, in which case it
+        takes effect on the next prepare().
+    */
+    bool setUserIR (int presetIndex, IRLibrary::MappedIRPtr ir);
+    IRLibrary::MappedIRPtr getUserIR (int presetIndex) const;
+
+    /**
+        What this instance holds for the current prepare(): convolution
+        engines (JUCE's modelled, see estimateConvolutionBytes()), delay lines,
+        the preset data built so far and scratch buffers.  Call from the
+        message thread; while the background job is still building, only
+        finished presets are counted.
+    */
+    MemoryFootprint getMemoryFootprint() const;
+
+    /** True while the background job is still building preset data. */
+    bool isBuildingPresetData() const;
+
+    /** True once something since prepare() has needed the preset data, so the job has started. */
+    bool hasStartedPresetData() const { return presetDataJobStarted.load(); }
+
+    /**
+        Bytes juce::dsp::Convolution holds for an IR of irLength samples at
+        blockSize: per channel, the uniform engine's impulse and input
+        spectra plus its FIFOs, twice over for the crossfade's previous
+        engine.  With headSize > 0, as NonUniform: a head engine at blockSize
+        and a tail engine at headSize.
+    */
+    static size_t estimateConvolutionBytes (int irLength, int blockSize, int numChannels, int headSize = 0);
+
+    /** Bytes of per-block state each instance touches, whatever the preset (see HotState). */
+    static constexpr size_t getHotStateBytes() { return sizeof (HotState); }
+
+    /** Mono or stereo; further channels pass through unprocessed. */
+    static constexpr int kMaxChannels = 2;
 
 private:
+    void processChunk (juce::AudioBuffer<float>& buffer);
+    void processBypassDelay (juce::AudioBuffer<float>& buffer);
     void rebuildFilters();
-    void loadIR (const char* data, int dataSize);
+    void loadIR (const char* data, int dataSize, juce::dsp::Convolution& target, bool& targetActive);
 
-    int currentPresetIndex = 0;
+    /** How a preset's IR runs, given what its data has turned out to be. */
+    enum class IRPath
+    {
+        plain,             // the IR straight into the convolver's loader
+        full,              // a user IR, or offline any IR, decoded by the job, into the convolver
+        head,              // the job's decoded IR up to kHeadLength; the tail convolver has the rest
+        fused,             // fused FIR, into the convolver
+        fusedHead,
+        fusedTrueStereo,   // on trueStereoConvolver
+        trueStereo,
+        cabin,
+        eco
+    };
 
-    double sampleRate       = 44100.0;
-    int    samplesPerBlock  = 512;
-    int    numChannels      = 2;
+    /**
+        What choosePathFromData() goes by besides the preset data, small
+        enough that the audio thread's setters publish it as one lock-free
+        value.  The preset data job takes a copy when it starts instead of
+        reading the fields the audio thread writes.  A copy that has gone
+        stale only costs a handoff the audio thread hands back.
+    */
+    struct PathSettings
+    {
+        juce::int8       presetIndex = 0;
+        Quality          quality     = Quality::normal;
+        CabinModel::Seat seat        = CabinModel::Seat::driver;
+        bool             asyncTails  = false;
+    };
 
-    // IIR Filter chain (HP + LP + peak bands)
-    using IIRFilter = juce::dsp::IIR::Filter<float>;
-    using IIRCoefs  = juce::dsp::IIR::Coefficients<float>;
+    // Four bytes (hence the enums' uint8 storage), so the atomic is a plain word
+    static_assert (sizeof (PathSettings) == 4 && std::atomic<PathSettings>::is_always_lock_free);
 
-    static constexpr int kMaxFilters = 10;
-    std::array<juce::dsp::ProcessorDuplicator<IIRFilter, IIRCoefs>, kMaxFilters> filters;
-    int activeFilterCount = 0;
+    PathSettings getPathSettings() const noexcept;   // from the audio thread's own fields
+    void publishPathSettings() noexcept { pathSettings.store (getPathSettings()); }
+    std::atomic<PathSettings> pathSettings;
 
-    // Convolution engine
-    juce::dsp::Convolution convolver;
-    bool  convolverActive = false;
-    float irWetMix        = 0.0f;
+    IRPath choosePathFromData (size_t presetSlot, const PathSettings& settings) const;   // once the preset's data is built
+    IRPath choosePathForMorph (size_t presetSlot) const;   // likewise, for one end of a morph
+    IRPath getStereoPathForMorph (size_t presetSlot) const;
+    bool presetPathChanged (size_t presetSlot);            // audio thread, when its data comes or goes
+    bool usesFusedIR (size_t presetSlot) const;
+    static bool needsIRHandoff (IRPath path);
 
-    // Early reflections (car cabin simulation)
+    static constexpr int kMaxFilters     = 10;
     static constexpr int kMaxReflections = 5;
+
     struct ReflectionTap
     {
         int   delaySamples = 0;
         float gain         = 0.0f;
     };
-    std::array<ReflectionTap, kMaxReflections> reflectionTaps;
-    int numReflectionTaps = 0;
-    bool earlyReflectionsActive = false;
 
-    juce::AudioBuffer<float> delayBuffer;
-    int delayWritePos = 0;
-    int delayBufferSize = 0;
+    /**
+        Everything process() reads or writes for every block, in one
+        cache-line-aligned block with no pointers to chase: the flags and
+        mix values first, then the reflection taps, coefficients and filter
+        state, all inline (under 600 bytes, so it stays in L1).  rebuildFilters() and applyMorph() fill
+        it from the cold preset and configuration data further down, which
+        the audio path never reads.  With dozens of instances the chain's
+        per-block footprint is this plus the convolvers' own buffers.
+    */
+    struct alignas (64) HotState
+    {
+        int   currentPresetIndex  = 0;
+        int   activeFilterCount   = 0;
+        int   numReflectionTaps   = 0;
+        int   delayWritePos       = 0;
+        int   delayBufferSize     = 0;
+        int   bypassDelayPos      = 0;
+        int   chainLatencySamples = 0;      // latencySamples less the scheduler's
+        int   latencySamples      = 0;      // host rate, everything included
+        float irWetMix            = 0.0f;
+        float stereoWidth         = 1.0f;
+        float reflectionLevel     = 1.0f;   // below 1 only while morphing to / from the car
+        float outputGain          = 1.0f;   // linear
+        float appliedMorph        = -1.0f;
+        float morphWetFrom        = 0.0f;
+        float morphWetTo          = 0.0f;
+
+        bool convolverActive        = false;
+        bool fusedActive            = false;
+        bool trueStereoActive       = false;
+        bool cabinActive            = false;
+        bool earlyReflectionsActive = false;
+        bool compressorActive       = false;
+        bool driverActive           = false;
+        bool codecActive            = false;
+        bool morphActive            = false;
+        bool morphConvolverActive   = false;
+        bool morphTrueStereoActive  = false;
+        bool morphCabinActive       = false;
+        bool morphDataSeen          = false;   // presetDataSeen for the morph's target
+        bool waitingForMorphEngines = false;
+        bool waitingForPresetData   = false;
+        bool waitingForIRHandoff    = false;
+        bool waitingForTailConvolver = false;
+        bool presetDataSeen         = false;   // whether rebuildFilters() found the preset's data ready
+        IRPath irPath               = IRPath::plain;
+        bool highQuality            = false;
+
+        EcoIRModel* activeEcoModel = nullptr;
+
+        std::array<ReflectionTap, kMaxReflections> reflectionTaps {};
+
+        // Early reflection low-pass (simulates absorption), one state per channel
+        DspKernels::BiquadCoefficients reflectionLPCoefs;
+        std::array<DspKernels::BiquadState, kMaxChannels> reflectionLPStates {};
+
+        // HP -> LP -> peak cascade; states are [channel * activeFilterCount + stage]
+        std::array<DspKernels::BiquadCoefficients, kMaxFilters> filterCoefs {};
+        std::array<DspKernels::BiquadState, kMaxChannels * kMaxFilters> filterStates {};
+    };
+
+    HotState hot;
 
-    // Low-pass filter for early reflections (simulates absorption)
-    juce::dsp::ProcessorDuplicator<IIRFilter, IIRCoefs> reflectionLPFilter;
+    // Internal rate and block size (host values / the reduced-rate factor, or x2 in high quality)
+    double sampleRate       = 44100.0;
+    int    samplesPerBlock  = 512;
+    int    numChannels      = 2;
+    int    hostBlockSize    = 512;
+    bool   prepared         = false;   // by any prepare() yet; under updateLock
 
-    // Stereo width
-    float stereoWidth = 1.0f;
+    // Reduced internal rate
+    bool reducedRate = false;
+    RateConverter rateConverter;
+    juce::AudioBuffer<float> internalBuffer;
 
-    // Output gain
-    juce::dsp::Gain<float> outputGain;
+    // Fixed-size blocks whatever the host sends (hostBlockSize is its largest)
+    BlockScheduler::Mode blockScheduling = BlockScheduler::Mode::host;
+    BlockScheduler scheduler;
 
-    // Compressor (BT speaker)
-    juce::dsp::Compressor<float> compressor;
-    bool compressorActive = false;
+    // Offline high quality: 2x oversampling around the whole chain
+    std::unique_ptr<juce::dsp::Oversampling<float>> oversampler;
+    std::vector<float*> oversampledChannels;
 
-    std::vector<EnvironmentPreset> presets;
+    /** One scheduled block: through the rate converter and processChunk(), or the bypass delay. */
+    void processScheduledBlock (juce::AudioBuffer<float>& block);
+
+    // Keeps bypass aligned with the processed presets when there's latency
+    // (inside the scheduler, which delays everything equally)
+    juce::AudioBuffer<float> bypassDelayLine;
+
+    // IIR Filter chain (HP + LP + peak bands), designed by designBiquad() into hot.filterCoefs,
+    // and by the same designs into the fused FIRs
+
+    // The same cascade in double, run instead in high quality (offline only, so not in hot)
+    std::array<DspKernels::PreciseBiquadCoefficients, kMaxFilters> preciseFilterCoefs {};
+    std::array<DspKernels::PreciseBiquadState, kMaxChannels * kMaxFilters> preciseFilterStates {};
+
+    // Per-preset data derived from the IRs (fused FIR, eco model, tail partitions).
+    // Built on a shared background thread, and only once fused / eco / async
+    // tails are actually requested, so prepare() and session load stay cheap;
+    // until a preset's data is ready it simply runs the plain separate path.
+    struct PresetDataJob : public juce::ThreadPoolJob
+    {
+        explicit PresetDataJob (EnvironmentProcessor& o) : juce::ThreadPoolJob ("Car Test IR prep"), owner (o) {}
+        JobStatus runJob() override;
+        bool buildAll (const PathSettings& settings);
+        EnvironmentProcessor& owner;
+    };
+
+    /**
+        Work the audio thread asks for off it: starting the preset data job,
+        making the morph's engines, refilling IR handoffs.  The audio thread
+        sets a flag and wakes UpdateThread, which every instance in the
+        process shares and which sleeps until then.  It doesn't go through
+        the message thread, so tools without a message loop get the same
+        updates, and posting a message (AsyncUpdater) would take the message
+        queue's lock.
+    */
+    class UpdateThread;
+    void requestUpdate() noexcept;
+    void serviceUpdates();   // update thread
+
+    std::atomic<bool> updateRequested { false };
+    juce::SharedResourcePointer<UpdateThread> updateThread;
+
+    // Held by serviceUpdates(), and by prepare() and setUserIR() so it never sees them half done
+    juce::CriticalSection updateLock;
+
+    bool needsPresetData() const;
+    void startPresetDataJob();
+    bool usesTrueStereo (const EnvironmentPreset& preset, Quality withQuality) const;
+    bool usesCabinModel (const EnvironmentPreset& preset, Quality withQuality) const;
+    void cancelPresetDataJob();
+    void buildPresetData (size_t presetSlot);
+    bool isPresetDataReady (size_t presetSlot) const;
+    juce::AudioBuffer<float> buildFusedIR (const EnvironmentPreset& preset,
+                                           const juce::AudioBuffer<float>& ir) const;
+
+    // Long enough for the 35 Hz high-pass to ring down below -80 dB
+    static constexpr double kFusedEqTailSeconds = 0.1;
+
+    std::vector<std::atomic<ConvolutionMode>> convolutionModes;   // set by the audio thread, read by the job
+    std::vector<juce::AudioBuffer<float>>     fusedIRs;
+
+    // ConvolutionMode::automatic: the job times both paths for each preset, once
+    // per process for each IR, rate and block size (see getConvolutionTimingCache())
+    // (char, not bool: the job writes one slot while the audio thread reads another)
+    static constexpr int kBenchmarkRuns          = 3;
+    static constexpr int kBenchmarkBlocks        = 16;
+    static constexpr int kBenchmarkLoadTimeoutMs = 2000;
+
+    std::vector<char> fusedIsCheaper;
+    double timeConvolutionPath (const juce::AudioBuffer<float>& ir, const EnvironmentPreset& preset,
+                                bool withFilters) const;
+    bool isFusedCheaper (size_t presetSlot, const juce::AudioBuffer<float>& ir) const;
+
+    // Eco quality: fitted IIR stand-ins for each preset's IR
+    Quality quality = Quality::normal;
+    std::vector<EcoIRModel> ecoModels;
+
+    // Convolution engine: uniform partitions live, a 2048-sample zero-latency
+    // head with larger partitions behind it offline
+    static constexpr int kOfflineHeadSize = 2048;
+    juce::dsp::Convolution  liveConvolver;
+    std::unique_ptr<juce::dsp::Convolution> offlineConvolver;   // made by the first offline prepare()
+    juce::dsp::Convolution* convolver = &liveConvolver;
+
+    /**
+        A buffer for the main convolver, made off the audio thread and moved
+        into its loader, so the audio thread never copies or allocates one.
+        While ready is set it belongs to the audio thread, which takes it,
+        or hands it back if it was made for another path.  Otherwise the
+        preset data job or the update thread fills it for the wanted path.
+    */
+    struct IRHandoff
+    {
+        juce::AudioBuffer<float> ir;
+        IRPath path = IRPath::plain;
+        std::atomic<IRPath> wanted { IRPath::plain };
+        std::atomic<bool>   ready  { false };
+    };
+
+    std::vector<IRHandoff> irHandoffs;
+
+    void fillIRHandoff (size_t presetSlot, IRPath path);     // off the audio thread
+    bool loadFromIRHandoff (size_t presetSlot, IRPath path,                 // audio thread
+                            juce::dsp::Convolution& target, bool& targetActive);
+    const juce::AudioBuffer<float>& getHandoffSource (size_t presetSlot, IRPath path) const;
+
+    // Late IR partitions on the shared worker pool.  Only prepared once async
+    // tails are used, by the job or on request, since that starts the workers
+    AsyncTailConvolver tailConvolver;
+    juce::CriticalSection tailConvolverLock;
+    std::atomic<bool> tailConvolverRequested { false };
+    void prepareTailConvolver();
+    bool asyncTails = false;
+    std::vector<juce::AudioBuffer<float>>  presetIRs;
+    std::vector<AsyncTailConvolver::Tail> presetTails, fusedTails;
+
+    // Library IRs standing in for presets' built-in ones: set for the next
+    // prepare(), and the ones in use, which only the preset data job reads
+    std::vector<IRLibrary::MappedIRPtr> pendingUserIRs, userIRs;
+
+    struct IRSource
+    {
+        const char* data = nullptr;
+        int         size = 0;
+    };
+
+    /** The preset's user IR if it has one, else its built-in resource. */
+    IRSource getIRSource (size_t presetSlot) const;
+
+    struct PartitionCounts
+    {
+        int tail = 0, trueStereo = 0;
+    };
+
+    /** What the tail and true-stereo convolvers need for this IR in this preset, from its header. */
+    PartitionCounts getPartitionsNeeded (size_t presetSlot, IRSource source) const;
+
+    // A user IR swapped in after prepare(): queued for the job, which rebuilds
+    // that one preset's data once nothing is reading it (releasePresetData())
+    juce::CriticalSection userIRQueueLock;
+    std::vector<std::pair<size_t, IRLibrary::MappedIRPtr>> queuedUserIRs;
+    bool presetDataJobQueued = false;   // under userIRQueueLock
+    static constexpr int kJobRestartTimeoutMs = 500;   // setUserIR()'s wait for a job on its way out
+    bool presetDataBuilt     = false;   // the job's first run is done
+    std::atomic<int> tailPartitionCapacity { 0 }, trueStereoPartitionCapacity { 0 };
+    std::atomic<bool> partitionsSized { false };   // the two capacities have been counted
+    std::vector<std::atomic<bool>> hasUserIR;   // userIRs[i] != nullptr, for the audio thread
+
+    // The preset whose data the audio thread is reading (-1 for none), and
+    // the lock other threads hold while they read one
+    std::atomic<int> presetSlotInUse { -1 }, morphSlotInUse { -1 };
+    juce::CriticalSection presetDataReadLock;
+
+    bool releasePresetData (size_t presetSlot, const juce::ThreadPoolJob& job);
+
+    // True-stereo IRs (plain and fused), partitioned for trueStereoConvolver
+    TrueStereoConvolver trueStereoConvolver;
+    std::vector<TrueStereoConvolver::IR> trueStereoIRs, fusedTrueStereoIRs;
+
+    // Multi-speaker cabin: one true-stereo IR per seat, run by trueStereoConvolver
+    CabinModel::Seat seat = CabinModel::Seat::driver;
+    std::vector<std::array<TrueStereoConvolver::IR, CabinModel::numSeats>> cabinIRs;
+
+    juce::SharedResourcePointer<juce::ThreadPool> backgroundPool;
+    PresetDataJob presetDataJob { *this };
+    std::vector<std::atomic<bool>> presetDataReady;
+    std::atomic<bool> presetDataJobStarted { false };
+    std::atomic<bool> tailConvolverReady { false };
+    std::atomic<bool> trueStereoReady { false };
+
+    // Preallocated per-block scratch (dry copy, reflection sum)
+    juce::AudioBuffer<float> scratchBuffer, reflectionScratch;
+
+    // Early reflections delay line (positions in hot)
+    juce::AudioBuffer<float> delayBuffer;
+
+    // Morph: the selected preset towards morphTargetIndex
+    struct FilterDesign
+    {
+        enum class Type { highPass, lowPass, peak, unity };   // unity: pass-through, Bypass's end of a morph
+        Type  type;
+        float freq, q, gainDb;
+    };
+
+    static constexpr int    kMorphControlSamples = 64;     // internal-rate samples per coefficient update
+    static constexpr double kMorphRampSeconds    = 0.05;
+
+    void setUpEarlyReflections();
+    LinkedCompressor::Settings makeCompressorSettings (const EnvironmentPreset& preset) const;
+    static SpeakerDriver::Settings makeDriverSettings (const EnvironmentPreset& preset);
+    CodecSimulator::Settings makeCodecSettings (const EnvironmentPreset& preset) const;
+    static int makeFilterDesigns (const EnvironmentPreset& preset, std::array<FilterDesign, kMaxFilters>& designs);
+    DspKernels::PreciseBiquadCoefficients designBiquad (const FilterDesign& design) const;   // allocation-free
+    static DspKernels::BiquadCoefficients toFloat (const DspKernels::PreciseBiquadCoefficients& coefs);
+    void setFilterStage (int index, const FilterDesign& design);
+    void setFilterStage (int index, const DspKernels::PreciseBiquadCoefficients& coefs);
+    void rebuildMorph();
+    void loadMorphEnd (size_t presetSlot, IRPath path,
+                       juce::dsp::Convolution* stereo, bool& stereoActive,
+                       TrueStereoConvolver* trueStereo, bool& trueStereoActive, bool& cabinActive);
+    void createMorphEngines();   // update thread
+    void applyMorph (float position);
+    void processMorphConvolution (juce::AudioBuffer<float>& buffer);
+
+    int   morphTargetIndex = 0;
+    juce::SmoothedValue<float> morphPosition;
+    std::array<FilterDesign, kMaxFilters> morphFrom {}, morphTo {};
+    juce::AudioBuffer<float> morphScratch;
+
+    // The target's engines, made by the first morph after prepare() (see
+    // createMorphEngines()); the audio thread only touches them once ready
+    std::unique_ptr<juce::dsp::Convolution> morphConvolver;
+    std::unique_ptr<TrueStereoConvolver> morphTrueStereo;
+    std::atomic<bool> morphEnginesReady { false }, morphEnginesRequested { false };
+
+    // Compressor / limiter (Phone, BT speaker)
+    LinkedCompressor compressor;
+    int  lookaheadSamples   = 0;   // internal rate
+
+    // Small-speaker excursion nonlinearity (Phone, Laptop, BT speaker)
+    SpeakerDriver driver;
+
+    // Lossy link to the device; runs first, on the signal as it's sent
+    CodecPath codecPath = CodecPath::off;
+    CodecSimulator codec;
+    int  codecLatencySamples = 0;   // internal rate; 0 when no preset can use a codec
+
+    const std::vector<EnvironmentPreset>& presets = getBuiltInPresets();
 };
@@ -0,0 +1,320 @@
+#include "IRLibrary.h"
+#include "MemoryFootprint.h"
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+    // Archive: magic, version, entry count, then (name, offset, size) per
+    // entry, then each entry's WAV file at a page-aligned offset
+    constexpr int         kArchiveMagic   = 0x50495443;   // "CTIP"
+    constexpr int         kArchiveVersion = 1;
+    constexpr juce::int64 kArchiveAlign   = 4096;
+    constexpr int         kMaxArchiveEntries = 100000;
+
+    juce::int64 alignUp (juce::int64 offset)
+    {
+        return (offset + kArchiveAlign - 1) / kArchiveAlign * kArchiveAlign;
+    }
+
+    juce::String getEntryName (const juce::File& file, const juce::File& directory)
+    {
+        return file.getRelativePathFrom (directory).upToLastOccurrenceOf (".", false, false)
+                   .replaceCharacter ('\\', '/');
+    }
+
+    juce::Array<juce::File> findWavFiles (const juce::File& directory)
+    {
+        auto files = directory.findChildFiles (juce::File::findFiles, true, "*.wav");
+        files.sort();
+        return files;
+    }
+}
+
+//==============================================================================
+IRLibrary::MappedIR::MappedIR (const juce::File& file, juce::Range<juce::int64> range, const juce::String& irName)
+    : mapping (file, range, juce::MemoryMappedFile::readOnly),
+      name (irName)
+{
+    // The mapping starts on a page boundary at or before the range
+    const auto offset = range.getStart() - mapping.getRange().getStart();
+
+    if (mapping.getData() != nullptr && offset >= 0
+         && offset + range.getLength() <= static_cast<juce::int64> (mapping.getSize()))
+    {
+        data = static_cast<const char*> (mapping.getData()) + offset;
+        size = static_cast<int> (range.getLength());
+    }
+}
+
+//==============================================================================
+juce::File IRLibrary::getDefaultDirectory()
+{
+    return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+               .getChildFile ("Car Test").getChildFile ("IRs");
+}
+
+void IRLibrary::scan (const juce::File& directory)
+{
+    const juce::ScopedLock sl (lock);
+
+    // Anyone still holding a mapping keeps it; it doesn't refer back to the catalogue
+    sources.clear();
+    entries.clear();
+    mappings.clear();
+    scanned = true;
+
+    if (! directory.isDirectory())
+        return;
+
+    for (const auto& file : findWavFiles (directory))
+        addFile (file, getEntryName (file, directory));
+
+    auto archives = directory.findChildFiles (juce::File::findFiles, true, juce::String ("*") + kArchiveExtension);
+    archives.sort();
+
+    for (const auto& archive : archives)
+        addArchive (archive, getEntryName (archive, directory));
+
+    std::sort (entries.begin(), entries.end(),
+               [] (const Entry& a, const Entry& b) { return a.name.compareNatural (b.name) < 0; });
+
+    entries.shrink_to_fit();
+    mappings.resize (entries.size());
+}
+
+void IRLibrary::addFile (const juce::File& file, const juce::String& name)
+{
+    sources.add (file);
+
+    Entry entry;
+    entry.name   = name;
+    entry.source = sources.size() - 1;
+    entry.range  = { 0, file.getSize() };
+
+    if (readHeader (entry))
+        entries.push_back (std::move (entry));
+}
+
+void IRLibrary::addArchive (const juce::File& archive, const juce::String& prefix)
+{
+    juce::FileInputStream in (archive);
+
+    if (! in.openedOk() || in.readInt() != kArchiveMagic)
+        return;
+
+    // Newer versions only append fields to the header
+    in.readShort();
+
+    const int count = in.readCompressedInt();
+
+    if (count <= 0 || count > kMaxArchiveEntries)
+        return;
+
+    sources.add (archive);
+    const auto archiveSize = archive.getSize();
+
+    for (int i = 0; i < count && ! in.isExhausted(); ++i)
+    {
+        Entry entry;
+        entry.name   = prefix + "/" + in.readString();
+        entry.source = sources.size() - 1;
+
+        const auto offset = in.readInt64();
+        const auto size   = in.readInt64();
+
+        if (offset < 0 || size <= 0 || offset + size > archiveSize)
+            continue;
+
+        entry.range = { offset, offset + size };
+
+        if (readHeader (entry))
+            entries.push_back (std::move (entry));
+    }
+}
+
+bool IRLibrary::readHeader (Entry& entry) const
+{
+    // MappedIR hands the data on as an int-sized block
+    if (entry.range.getLength() <= 0 || entry.range.getLength() > std::numeric_limits<int>::max())
+        return false;
+
+    auto file = std::make_unique<juce::FileInputStream> (sources[entry.source]);
+
+    if (! file->openedOk())
+        return false;
+
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatReader> reader (
+        wav.createReaderFor (new juce::SubregionStream (file.release(), entry.range.getStart(),
+                                                        entry.range.getLength(), true), true));
+
+    // Mono, stereo or true stereo, as ImpulseResponse reads them
+    if (reader == nullptr || reader->sampleRate <= 0.0 || reader->lengthInSamples <= 0
+         || (reader->numChannels != 1 && reader->numChannels != 2 && reader->numChannels != 4))
+        return false;
+
+    entry.sampleRate      = reader->sampleRate;
+    entry.numChannels     = static_cast<int> (reader->numChannels);
+    entry.lengthInSamples = reader->lengthInSamples;
+    return true;
+}
+
+//==============================================================================
+void IRLibrary::scanIfNeeded()
+{
+    if (! scanned)
+        scan (getDefaultDirectory());
+}
+
+int IRLibrary::getNumEntries()
+{
+    const juce::ScopedLock sl (lock);
+    scanIfNeeded();
+    return static_cast<int> (entries.size());
+}
+
+IRLibrary::Entry IRLibrary::getEntry (int index)
+{
+    const juce::ScopedLock sl (lock);
+    scanIfNeeded();
+    return juce::isPositiveAndBelow (index, static_cast<int> (entries.size())) ? entries[static_cast<size_t> (index)] : Entry {};
+}
+
+int IRLibrary::indexOf (const juce::String& name)
+{
+    // Most sessions use no library IRs: they never need the folder scanned
+    if (name.isEmpty())
+        return -1;
+
+    const juce::ScopedLock sl (lock);
+    scanIfNeeded();
+
+    for (size_t i = 0; i < entries.size(); ++i)
+        if (entries[i].name == name)
+            return static_cast<int> (i);
+
+    return -1;
+}
+
+IRLibrary::MappedIRPtr IRLibrary::map (int index)
+{
+    const juce::ScopedLock sl (lock);
+    scanIfNeeded();
+
+    if (! juce::isPositiveAndBelow (index, static_cast<int> (entries.size())))
+        return nullptr;
+
+    auto& shared = mappings[static_cast<size_t> (index)];
+
+    if (auto existing = shared.lock())
+        return existing;
+
+    const auto& entry = entries[static_cast<size_t> (index)];
+    auto mapped = std::make_shared<const MappedIR> (sources[entry.source], entry.range, entry.name);
+
+    if (! mapped->isValid())
+        return nullptr;
+
+    shared = mapped;
+    return mapped;
+}
+
+size_t IRLibrary::getMemoryBytes() const
+{
+    const juce::ScopedLock sl (lock);
+
+    size_t bytes = MemoryFootprint::bytesOf (entries) + MemoryFootprint::bytesOf (mappings);
+
+    for (const auto& entry : entries)
+        bytes += entry.name.getNumBytesAsUTF8();
+
+    return bytes;
+}
+
+//==============================================================================
+juce::String IRLibrary::writeArchive (const juce::File& directory, const juce::File& archive)
+{
+    if (! directory.isDirectory())
+        return directory.getFullPathName() + " isn't a folder";
+
+    struct Item
+    {
+        juce::File   file;
+        juce::String name;
+        juce::int64  offset = 0;
+    };
+
+    std::vector<Item> items;
+
+    for (const auto& file : findWavFiles (directory))
+    {
+        // Only what scan() would accept, so every entry in the archive is usable
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatReader> reader (wav.createReaderFor (file.createInputStream().release(), true));
+
+        if (reader != nullptr && reader->lengthInSamples > 0 && file.getSize() <= std::numeric_limits<int>::max())
+            items.push_back ({ file, getEntryName (file, directory) });
+    }
+
+    if (items.empty())
+        return "No readable WAV files in " + directory.getFullPathName();
+
+    // The header's size doesn't depend on the offsets (they're fixed-width), so write it twice
+    auto writeHeader = [&items] (juce::OutputStream& out)
+    {
+        out.writeInt (kArchiveMagic);
+        out.writeShort (static_cast<short> (kArchiveVersion));
+        out.writeCompressedInt (static_cast<int> (items.size()));
+
+        for (const auto& item : items)
+        {
+            out.writeString (item.name);
+            out.writeInt64 (item.offset);
+            out.writeInt64 (item.file.getSize());
+        }
+    };
+
+    juce::MemoryOutputStream header;
+    writeHeader (header);
+
+    juce::int64 offset = static_cast<juce::int64> (header.getDataSize());
+
+    for (auto& item : items)
+    {
+        item.offset = alignUp (offset);
+        offset = item.offset + item.file.getSize();
+    }
+
+    juce::TemporaryFile temp (archive);
+
+    {
+        juce::FileOutputStream out (temp.getFile());
+
+        if (! out.openedOk())
+            return "Couldn't write " + archive.getFullPathName();
+
+        writeHeader (out);
+
+        for (const auto& item : items)
+        {
+            while (out.getPosition() < item.offset)
+                out.writeByte (0);
+
+            juce::FileInputStream in (item.file);
+
+            if (! in.openedOk() || out.writeFromInputStream (in, -1) != item.file.getSize())
+                return "Couldn't read " + item.file.getFullPathName();
+        }
+
+        out.flush();
+
+        if (out.getStatus().failed())
+            return out.getStatus().getErrorMessage();
+    }
+
+    if (! temp.overwriteTargetFileWithTemporary())
+        return "Couldn't replace " + archive.getFullPathName();
+
+    return {};
+}
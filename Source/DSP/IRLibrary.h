@@ -0,0 +1,107 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/**
+    A folder of the user's measured IRs, for presets to use in place of
+    their built-in ones.
+
+    scan() indexes the folder from the file headers alone: every *.wav, and
+    every entry of each *.irpack archive (see writeArchive()), into a
+    catalogue of names, byte ranges and formats.  Nothing is decoded, so a
+    library of hundreds of IRs costs a few hundred bytes each.
+
+    map() memory-maps one IR, read-only, the first time it's selected.
+    Instances asking for the same IR share one mapping, and the OS pages
+    it in as it's read and can drop the pages again under pressure, so
+    browsing doesn't grow the heap.  Decoding and partitioning are left to
+    whoever holds the mapping (EnvironmentProcessor does it on its preset
+    data thread); the mapping goes when the last holder lets go of it.
+
+    One library is shared by every instance in the process, through
+    juce::SharedResourcePointer.  It scans getDefaultDirectory() the first
+    time anyone asks for its catalogue or an IR, not when it's made, so a
+    host scanning plugins never walks the user's folder.  Call scan() and
+    map() from the message thread.
+*/
+class IRLibrary
+{
+public:
+    struct Entry
+    {
+        juce::String name;                 // relative path without extension, "/"-separated
+        int          source = 0;           // the file (loose WAV or archive) holding it
+        juce::Range<juce::int64> range;    // byte range of the WAV within its source
+        double       sampleRate      = 0.0;
+        int          numChannels     = 0;
+        juce::int64  lengthInSamples = 0;
+    };
+
+    /** One IR's WAV data, mapped from its file; the pages are only read when decoded. */
+    class MappedIR
+    {
+    public:
+        MappedIR (const juce::File& file, juce::Range<juce::int64> range, const juce::String& name);
+
+        const char* getData() const { return data; }
+        int         getSize() const { return size; }
+        const juce::String& getName() const { return name; }
+        bool isValid() const        { return data != nullptr; }
+
+    private:
+        juce::MemoryMappedFile mapping;
+        const char*  data = nullptr;
+        int          size = 0;
+        juce::String name;
+    };
+
+    using MappedIRPtr = std::shared_ptr<const MappedIR>;
+
+    /** Empty until first used; then it scans getDefaultDirectory(), which may not exist. */
+    IRLibrary() = default;
+
+    /** <user application data>/Car Test/IRs */
+    static juce::File getDefaultDirectory();
+
+    /** Replaces the catalogue with directory's IRs (recursively), sorted by name. */
+    void scan (const juce::File& directory);
+
+    int   getNumEntries();
+    Entry getEntry (int index);
+
+    /** The entry with this name, or -1.  An empty name is -1 without scanning. */
+    int indexOf (const juce::String& name);
+
+    /** The entry's mapping, shared with anyone already holding it; nullptr if index is out of range or unreadable. */
+    MappedIRPtr map (int index);
+
+    /** Bytes of the catalogue itself (the mappings are address space, not heap); nothing until scanned. */
+    size_t getMemoryBytes() const;
+
+    /**
+        Packs every *.wav under directory into one archive, each IR
+        page-aligned so mapping one touches none of its neighbours.  Returns
+        an error message, or an empty string on success.
+    */
+    static juce::String writeArchive (const juce::File& directory, const juce::File& archive);
+
+    static constexpr const char* kArchiveExtension = ".irpack";
+
+private:
+    void addFile (const juce::File& file, const juce::String& name);
+    void addArchive (const juce::File& archive, const juce::String& prefix);
+    bool readHeader (Entry& entry) const;
+    void scanIfNeeded();   // under lock
+
+    mutable juce::CriticalSection lock;
+    bool scanned = false;
+    juce::Array<juce::File> sources;
+    std::vector<Entry> entries;
+    std::vector<std::weak_ptr<const MappedIR>> mappings;   // per entry, while anyone holds one
+
+    JUCE_DECLARE_NON_COPYABLE (IRLibrary)
+};
@@ -0,0 +1,197 @@
+#include "ImpulseResponse.h"
+#include <cmath>
+
+//==============================================================================
+double ImpulseResponse::decode (const void* data, size_t dataSize, juce::AudioBuffer<float>& dest)
+{
+    if (data == nullptr || dataSize == 0)
+        return 0.0;
+
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatReader> reader (
+        wav.createReaderFor (new juce::MemoryInputStream (data, dataSize, false), true));
+
+    if (reader == nullptr || reader->lengthInSamples <= 0)
+        return 0.0;
+
+    const int numChannels = static_cast<int> (reader->numChannels);
+    const int numSamples  = static_cast<int> (reader->lengthInSamples);
+
+    dest.setSize (numChannels, numSamples);
+    reader->read (&dest, 0, numSamples, 0, true, true);
+
+    return reader->sampleRate;
+}
+
+int ImpulseResponse::getLengthAtRate (const char* data, int dataSize, double targetRate)
+{
+    if (data == nullptr || dataSize <= 0)
+        return 0;
+
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatReader> reader (
+        wav.createReaderFor (new juce::MemoryInputStream (data, static_cast<size_t> (dataSize), false), true));
+
+    if (reader == nullptr || reader->sampleRate <= 0.0)
+        return 0;
+
+    return static_cast<int> (std::ceil (static_cast<double> (reader->lengthInSamples)
+                                        * targetRate / reader->sampleRate));
+}
+
+void ImpulseResponse::resample (juce::AudioBuffer<float>& ir, double sourceRate, double targetRate)
+{
+    if (sourceRate <= 0.0 || targetRate <= 0.0 || std::abs (sourceRate - targetRate) < 1.0e-3)
+        return;
+
+    const double ratio      = sourceRate / targetRate;
+    const int    numOutput  = static_cast<int> (std::ceil (ir.getNumSamples() / ratio));
+
+    juce::AudioBuffer<float> resampled (ir.getNumChannels(), numOutput);
+
+    for (int ch = 0; ch < ir.getNumChannels(); ++ch)
+    {
+        juce::LagrangeInterpolator interpolator;
+        interpolator.process (ratio, ir.getReadPointer (ch), resampled.getWritePointer (ch), numOutput);
+    }
+
+    ir = std::move (resampled);
+}
+
+void ImpulseResponse::trim (juce::AudioBuffer<float>& ir, bool trimEnd)
+{
+    const float threshold  = juce::Decibels::decibelsToGain (-80.0f);
+    const int   numSamples = ir.getNumSamples();
+
+    int first = numSamples;
+    int last  = -1;
+
+    for (int ch = 0; ch < ir.getNumChannels(); ++ch)
+    {
+        const auto* d = ir.getReadPointer (ch);
+
+        for (int s = 0; s < numSamples; ++s)
+        {
+            if (std::abs (d[s]) > threshold)
+            {
+                first = juce::jmin (first, s);
+                break;
+            }
+        }
+
+        for (int s = numSamples - 1; s >= 0; --s)
+        {
+            if (std::abs (d[s]) > threshold)
+            {
+                last = juce::jmax (last, s);
+                break;
+            }
+        }
+    }
+
+    if (last < first)
+    {
+        ir.setSize (ir.getNumChannels(), 0);
+        return;
+    }
+
+    if (! trimEnd)
+        last = numSamples - 1;
+
+    if (first == 0 && last == numSamples - 1)
+        return;
+
+    const int length = last - first + 1;
+    juce::AudioBuffer<float> trimmed (ir.getNumChannels(), length);
+
+    for (int ch = 0; ch < ir.getNumChannels(); ++ch)
+        trimmed.copyFrom (ch, 0, ir, ch, first, length);
+
+    ir = std::move (trimmed);
+}
+
+void ImpulseResponse::normalise (juce::AudioBuffer<float>& ir)
+{
+    auto energyOf = [&ir] (int ch)
+    {
+        const auto* d = ir.getReadPointer (ch);
+        float energy = 0.0f;
+
+        for (int s = 0; s < ir.getNumSamples(); ++s)
+            energy += d[s] * d[s];
+
+        return energy;
+    };
+
+    float maxEnergy = 0.0f;
+
+    if (ir.getNumChannels() == numTrueStereoPaths)
+    {
+        maxEnergy = juce::jmax (energyOf (leftToLeft)  + energyOf (leftToRight),
+                                energyOf (rightToLeft) + energyOf (rightToRight));
+    }
+    else
+    {
+        for (int ch = 0; ch < ir.getNumChannels(); ++ch)
+            maxEnergy = juce::jmax (maxEnergy, energyOf (ch));
+    }
+
+    if (maxEnergy > 0.0f)
+        ir.applyGain (0.125f / std::sqrt (maxEnergy));
+}
+
+//==============================================================================
+juce::AudioBuffer<float> ImpulseResponse::loadForSampleRate (const char* data, int dataSize,
+                                                             double targetRate, bool trimEnd)
+{
+    juce::AudioBuffer<float> ir;
+    const double sourceRate = decode (data, static_cast<size_t> (juce::jmax (0, dataSize)), ir);
+
+    if (sourceRate <= 0.0)
+        return {};
+
+    resample (ir, sourceRate, targetRate);
+    trim (ir, trimEnd);
+    normalise (ir);
+    return ir;
+}
+
+juce::AudioBuffer<float> ImpulseResponse::makeTrueStereo (const juce::AudioBuffer<float>& ir, double sampleRate,
+                                                          float crossGainDb, float crossDelayMs,
+                                                          float crossLowPassHz)
+{
+    if (ir.getNumChannels() == numTrueStereoPaths || ir.getNumChannels() == 0)
+        return ir;
+
+    const int delay  = juce::jmax (0, juce::roundToInt (crossDelayMs * 0.001 * sampleRate));
+    const int length = ir.getNumSamples() + delay;
+    const float gain = juce::Decibels::decibelsToGain (crossGainDb);
+
+    // One-pole low-pass for the cross paths (head / seat / baffle shadowing)
+    const float coef = std::exp (-juce::MathConstants<float>::twoPi * crossLowPassHz
+                                 / static_cast<float> (sampleRate));
+
+    juce::AudioBuffer<float> result (numTrueStereoPaths, length);
+    result.clear();
+
+    for (int side = 0; side < 2; ++side)
+    {
+        const int source = juce::jmin (side, ir.getNumChannels() - 1);
+        const int direct = side == 0 ? leftToLeft : rightToRight;
+        const int cross  = side == 0 ? leftToRight : rightToLeft;
+
+        result.copyFrom (direct, 0, ir, source, 0, ir.getNumSamples());
+
+        const auto* src = ir.getReadPointer (source);
+        auto* dst = result.getWritePointer (cross, delay);
+        float state = 0.0f;
+
+        for (int s = 0; s < ir.getNumSamples(); ++s)
+        {
+            state = src[s] * gain * (1.0f - coef) + state * coef;
+            dst[s] = state;
+        }
+    }
+
+    return result;
+}
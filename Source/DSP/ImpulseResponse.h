@@ -0,0 +1,71 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+
+//==============================================================================
+/**
+    Helpers for turning an embedded IR resource into a ready-to-use buffer.
+
+    juce::dsp::Convolution does this internally when handed raw file data, but
+    anything that wants to inspect or pre-process an IR (e.g. the fused
+    EQ + IR path) needs the same decode -> resample -> trim -> normalise steps
+    so its output matches what the convolver would have produced.
+*/
+namespace ImpulseResponse
+{
+    /**
+        Channel order of a true-stereo IR: a 4-channel WAV (or buffer) holding
+        one path per input / output pair.  Any 4-channel IR is read this way.
+    */
+    enum TrueStereoPath
+    {
+        leftToLeft   = 0,
+        leftToRight  = 1,
+        rightToLeft  = 2,
+        rightToRight = 3,
+        numTrueStereoPaths
+    };
+
+    /** Decodes WAV data into dest.  Returns the file's sample rate, or 0 on failure. */
+    double decode (const void* data, size_t dataSize, juce::AudioBuffer<float>& dest);
+
+    /**
+        Length in samples the IR will have once resampled to targetRate, read
+        from the file header only (no decoding).  0 if unreadable.
+    */
+    int getLengthAtRate (const char* data, int dataSize, double targetRate);
+
+    /** Resamples every channel of ir from sourceRate to targetRate (in place). */
+    void resample (juce::AudioBuffer<float>& ir, double sourceRate, double targetRate);
+
+    /**
+        Removes leading/trailing samples below -80 dB, like Convolution::Trim::yes.
+        With trimEnd false only the leading silence goes, so the IR's timing is
+        unchanged but its tail decays all the way out.
+    */
+    void trim (juce::AudioBuffer<float>& ir, bool trimEnd = true);
+
+    /**
+        Applies the same energy normalisation as Convolution::Normalise::yes.
+        For a true-stereo IR the energy of each input's two paths is summed,
+        which reduces to the stereo rule when the cross paths are silent.
+    */
+    void normalise (juce::AudioBuffer<float>& ir);
+
+    /**
+        Decode + resample + trim + normalise.  Returns an empty buffer if the
+        resource can't be read.
+    */
+    juce::AudioBuffer<float> loadForSampleRate (const char* data, int dataSize, double targetRate,
+                                                bool trimEnd = true);
+
+    /**
+        Builds a true-stereo IR.  A 4-channel ir is returned unchanged.  A mono
+        or stereo ir supplies the direct paths (LL, RR), and each cross path is
+        the opposite direct path delayed, attenuated and low-passed, which is a
+        rough model of the leakage between the two sides of a cabin or enclosure.
+    */
+    juce::AudioBuffer<float> makeTrueStereo (const juce::AudioBuffer<float>& ir, double sampleRate,
+                                             float crossGainDb, float crossDelayMs, float crossLowPassHz);
+}
@@ -0,0 +1,152 @@
+#include "LinkedCompressor.h"
+#include "MemoryFootprint.h"
+#include "DspKernels.h"
+#include <cmath>
+
+//==============================================================================
+void LinkedCompressor::prepare (double sr, int maximumBlockSize, int numChannels, float maxLookaheadMs)
+{
+    sampleRate   = sr;
+    maxBlockSize = juce::jmax (1, maximumBlockSize);
+    channels     = juce::jmax (1, numChannels);
+
+    sidechain.assign (static_cast<size_t> (maxBlockSize), 0.0f);
+    scratch.assign   (static_cast<size_t> (maxBlockSize), 0.0f);
+
+    const int maxLookahead = static_cast<int> (std::ceil (maxLookaheadMs * 0.001 * sampleRate));
+    delayLine.setSize (channels, juce::jmax (1, maxLookahead));
+
+    setSettings (settings);
+    reset();
+}
+
+void LinkedCompressor::reset()
+{
+    envelopeDb = 0.0f;
+    meanSquare = 0.0f;
+    delayLine.clear();
+    delayPos = 0;
+}
+
+size_t LinkedCompressor::getMemoryBytes() const
+{
+    return MemoryFootprint::bytesOf (sidechain) + MemoryFootprint::bytesOf (scratch)
+         + MemoryFootprint::bytesOf (delayLine);
+}
+
+void LinkedCompressor::setSettings (const Settings& newSettings)
+{
+    settings = newSettings;
+
+    auto coef = [this] (float ms)
+    {
+        return ms > 0.0f ? std::exp (-1.0f / (ms * 0.001f * static_cast<float> (sampleRate))) : 0.0f;
+    };
+
+    attackCoef  = coef (settings.attackMs);
+    releaseCoef = coef (settings.releaseMs);
+    rmsCoef     = coef (10.0f);   // 10 ms RMS window
+
+    const int newLookahead = juce::jlimit (0, delayLine.getNumSamples(),
+                                           juce::roundToInt (settings.lookaheadMs * 0.001 * sampleRate));
+
+    if (newLookahead != lookaheadSamples)
+    {
+        lookaheadSamples = newLookahead;
+        delayLine.clear();
+        delayPos = 0;
+    }
+}
+
+//==============================================================================
+void LinkedCompressor::process (juce::AudioBuffer<float>& buffer)
+{
+    const int numSamples = buffer.getNumSamples();
+
+    for (int start = 0; start < numSamples; start += maxBlockSize)
+        processChunk (buffer, start, juce::jmin (maxBlockSize, numSamples - start));
+}
+
+void LinkedCompressor::processChunk (juce::AudioBuffer<float>& buffer, int start, int n)
+{
+    const int chs = juce::jmin (buffer.getNumChannels(), channels);
+    auto* sc  = sidechain.data();
+    auto* tmp = scratch.data();
+
+    // ---- 1. Linked detector ----
+    if (settings.rmsDetector)
+    {
+        juce::FloatVectorOperations::multiply (sc, buffer.getReadPointer (0, start), buffer.getReadPointer (0, start), n);
+
+        for (int ch = 1; ch < chs; ++ch)
+        {
+            juce::FloatVectorOperations::multiply (tmp, buffer.getReadPointer (ch, start), buffer.getReadPointer (ch, start), n);
+            juce::FloatVectorOperations::add (sc, tmp, n);
+        }
+
+        juce::FloatVectorOperations::multiply (sc, 1.0f / static_cast<float> (chs), n);
+
+        // Mean-square smoothing is the one serial step of the RMS detector
+        for (int i = 0; i < n; ++i)
+        {
+            meanSquare = sc[i] + rmsCoef * (meanSquare - sc[i]);
+            sc[i] = meanSquare;
+        }
+    }
+    else
+    {
+        juce::FloatVectorOperations::abs (sc, buffer.getReadPointer (0, start), n);
+
+        for (int ch = 1; ch < chs; ++ch)
+        {
+            juce::FloatVectorOperations::abs (tmp, buffer.getReadPointer (ch, start), n);
+            juce::FloatVectorOperations::max (sc, sc, tmp, n);
+        }
+    }
+
+    // ---- 2. Level (dB) and soft-knee static curve: independent per sample ----
+    const auto& kernels = DspKernels::get();
+    const float dbScale = settings.rmsDetector ? 10.0f : 20.0f;   // mean-square vs amplitude
+    const float slope   = 1.0f / juce::jmax (1.0f, settings.ratio) - 1.0f;
+
+    kernels.gainComputer (sc, n, dbScale, settings.thresholdDb, slope, settings.kneeDb);
+
+    // ---- 3. Attack / release ballistics in the log domain ----
+    for (int i = 0; i < n; ++i)
+    {
+        const float target = sc[i];
+        const float coef   = target < envelopeDb ? attackCoef : releaseCoef;
+        envelopeDb = target + coef * (envelopeDb - target);
+        sc[i] = envelopeDb;
+    }
+
+    // ---- 4. dB -> linear ----
+    kernels.dbToGain (sc, n);
+
+    // ---- 5. Lookahead delay, then apply the shared gain to every channel ----
+    for (int ch = 0; ch < chs; ++ch)
+    {
+        auto* data = buffer.getWritePointer (ch, start);
+
+        if (lookaheadSamples > 0)
+        {
+            auto* line = delayLine.getWritePointer (ch);
+            int pos = delayPos;
+
+            for (int i = 0; i < n; ++i)
+            {
+                const float delayed = line[pos];
+                line[pos] = data[i];
+                data[i] = delayed;
+
+                if (++pos == lookaheadSamples)
+                    pos = 0;
+            }
+        }
+
+        juce::FloatVectorOperations::multiply (data, sc, n);
+    }
+
+    if (lookaheadSamples > 0)
+        delayPos = (delayPos + n) % lookaheadSamples;
+}
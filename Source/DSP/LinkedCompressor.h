@@ -0,0 +1,68 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+/**
+    Stereo-linked feed-forward compressor / limiter, modelled on the DSP
+    limiters in small smart speakers and phones.
+
+    All channels share one detector (max of |x| across channels, or their
+    mean-square for RMS mode), so the stereo image never shifts with gain
+    reduction.  Gain is computed per block: detection runs on
+    FloatVectorOperations, the soft-knee static curve and dB -> linear
+    conversion on DspKernels (gainComputer, dbToGain), and only the attack /
+    release smoothing is sample-serial.  An optional lookahead delays the
+    audio so gain reduction lands before the transient; getLatencySamples()
+    reports it.
+*/
+class LinkedCompressor
+{
+public:
+    struct Settings
+    {
+        float thresholdDb = 0.0f;
+        float ratio       = 1.0f;
+        float kneeDb      = 0.0f;
+        float attackMs    = 10.0f;
+        float releaseMs   = 100.0f;
+        float lookaheadMs = 0.0f;
+        bool  rmsDetector = false;
+    };
+
+    /** maxLookaheadMs bounds any later Settings::lookaheadMs (no allocation after this). */
+    void prepare (double sampleRate, int maximumBlockSize, int numChannels, float maxLookaheadMs);
+    void reset();
+
+    /** Heap bytes of the lookahead delay and sidechain buffers. */
+    size_t getMemoryBytes() const;
+
+    void setSettings (const Settings& newSettings);
+    int  getLatencySamples() const { return lookaheadSamples; }
+
+    void process (juce::AudioBuffer<float>& buffer);
+
+private:
+    void processChunk (juce::AudioBuffer<float>& buffer, int start, int numSamples);
+
+    Settings settings;
+    double sampleRate = 44100.0;
+    int maxBlockSize  = 512;
+    int channels      = 2;
+
+    float attackCoef  = 0.0f;
+    float releaseCoef = 0.0f;
+    float rmsCoef     = 0.0f;
+
+    // Detector / gain state
+    float envelopeDb  = 0.0f;
+    float meanSquare  = 0.0f;
+
+    // Per-block sidechain: level -> gain (dB) -> gain (linear)
+    std::vector<float> sidechain, scratch;
+
+    // Lookahead delay line
+    juce::AudioBuffer<float> delayLine;
+    int lookaheadSamples = 0;
+    int delayPos = 0;
+};
@@ -0,0 +1,96 @@
+#include "LoudnessMatcher.h"
+#include <cmath>
+
+//==============================================================================
+void LoudnessMatcher::prepare (double newSampleRate, int numChannels)
+{
+    sampleRate = newSampleRate;
+
+    inputMeter.prepare  (sampleRate, numChannels);
+    outputMeter.prepare (sampleRate, numChannels);
+    gain.reset (sampleRate, kRampSeconds);
+
+    reset();
+}
+
+void LoudnessMatcher::reset()
+{
+    inputMeter.reset();
+    outputMeter.reset();
+    gain.setCurrentAndTargetValue (1.0f);
+    lastPreset = -1;
+    lastFromReference = false;
+
+    inputShortTerm   = LoudnessMeter::kSilenceLufs;
+    inputIntegrated  = LoudnessMeter::kSilenceLufs;
+    outputMomentary  = LoudnessMeter::kSilenceLufs;
+    outputShortTerm  = LoudnessMeter::kSilenceLufs;
+    outputIntegrated = LoudnessMeter::kSilenceLufs;
+    appliedGainDb    = 0.0f;
+}
+
+//==============================================================================
+void LoudnessMatcher::measureInput (const juce::AudioBuffer<float>& buffer)
+{
+    inputMeter.process (buffer);
+    inputShortTerm  = inputMeter.getShortTermLufs();
+    inputIntegrated = inputMeter.getIntegratedLufs();
+}
+
+void LoudnessMatcher::processOutput (juce::AudioBuffer<float>& buffer, int presetIndex, bool matchEnabled,
+                                     bool fromReference)
+{
+    const int numSamples = buffer.getNumSamples();
+    const int preset     = juce::jlimit (0, kMaxPresets - 1, presetIndex);
+
+    // Each preset's output, and each source's, is measured from scratch
+    if (preset != lastPreset || fromReference != lastFromReference)
+    {
+        outputMeter.reset();
+        lastPreset = preset;
+        lastFromReference = fromReference;
+    }
+
+    outputMeter.process (buffer);
+
+    auto& learnedDb = presetGainDb[static_cast<size_t> (preset)];
+    const float inLufs  = inputMeter.getShortTermLufs();
+    const float outLufs = outputMeter.getShortTermLufs();
+
+    if (preset != 0 && ! fromReference && outputMeter.isShortTermValid()
+         && inLufs > kMinLevelLufs && outLufs > kMinLevelLufs)
+    {
+        const float target = juce::jlimit (-kMaxGainDb, kMaxGainDb, inLufs - outLufs);
+        const float coeff  = 1.0f - std::exp (-static_cast<float> (numSamples / (kAdaptSeconds * sampleRate)));
+        learnedDb += (target - learnedDb) * coeff;
+    }
+
+    const float gainDb = (matchEnabled && preset != 0) ? learnedDb : 0.0f;
+    gain.setTargetValue (juce::Decibels::decibelsToGain (gainDb));
+
+    if (gain.isSmoothing())
+        gain.applyGain (buffer, numSamples);
+    else if (gainDb != 0.0f)
+        buffer.applyGain (gain.getTargetValue());
+
+    // Published figures are what leaves the plugin (before the background noise)
+    auto withGain = [gainDb] (float lufs) { return lufs > LoudnessMeter::kSilenceLufs ? lufs + gainDb : lufs; };
+
+    inputShortTerm   = inLufs;
+    outputMomentary  = withGain (outputMeter.getMomentaryLufs());
+    outputShortTerm  = withGain (outLufs);
+    outputIntegrated = withGain (outputMeter.getIntegratedLufs());
+    appliedGainDb    = gainDb;
+}
+
+LoudnessMatcher::Readings LoudnessMatcher::getReadings() const
+{
+    Readings r;
+    r.inputShortTermLufs   = inputShortTerm.load();
+    r.inputIntegratedLufs  = inputIntegrated.load();
+    r.outputMomentaryLufs  = outputMomentary.load();
+    r.outputShortTermLufs  = outputShortTerm.load();
+    r.outputIntegratedLufs = outputIntegrated.load();
+    r.matchGainDb          = appliedGainDb.load();
+    return r;
+}
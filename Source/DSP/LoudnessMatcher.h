@@ -0,0 +1,71 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "LoudnessMeter.h"
+
+//==============================================================================
+/**
+    Loudness-matched A/B: meters the plugin input (the bypassed signal) and
+    the environment's output, and learns per preset the gain that brings the
+    output's short-term loudness back to the input's.
+
+    Learning always runs, so turning matching on is instant for any preset
+    that has already been heard; the gain is only applied while matching is
+    enabled.  A preset change restarts the output meter, and the gain only
+    adapts once a full 3 s short-term window of that preset exists and both
+    sides are above the silence threshold.
+
+    Readings are published through atomics and can be read from any thread.
+*/
+class LoudnessMatcher
+{
+public:
+    struct Readings
+    {
+        float inputShortTermLufs   = LoudnessMeter::kSilenceLufs;
+        float inputIntegratedLufs  = LoudnessMeter::kSilenceLufs;   // since prepare()
+        float outputMomentaryLufs  = LoudnessMeter::kSilenceLufs;   // output figures include the match gain
+        float outputShortTermLufs  = LoudnessMeter::kSilenceLufs;
+        float outputIntegratedLufs = LoudnessMeter::kSilenceLufs;   // since the last preset change
+        float matchGainDb          = 0.0f;                          // applied now
+    };
+
+    static constexpr int   kMaxPresets      = 8;
+    static constexpr float kMaxGainDb       = 24.0f;
+    static constexpr float kMinLevelLufs    = -60.0f;   // quieter than this, hold the gain
+    static constexpr float kAdaptSeconds    = 1.0f;     // learning time constant
+    static constexpr double kRampSeconds    = 0.05;     // applied gain ramp
+
+    void prepare (double sampleRate, int numChannels);
+    void reset();
+
+    /** Meters the input before any processing. */
+    void measureInput (const juce::AudioBuffer<float>& buffer);
+
+    /**
+        Meters the environment's output, updates the learned gain, then applies
+        it if matching.  While fromReference is set the output is a reference
+        track rather than the metered input, so the gain is applied but not
+        learned, and the output meter restarts whenever it changes.
+    */
+    void processOutput (juce::AudioBuffer<float>& buffer, int presetIndex, bool matchEnabled, bool fromReference);
+
+    Readings getReadings() const;
+
+private:
+    LoudnessMeter inputMeter, outputMeter;
+
+    double sampleRate = 44100.0;
+    int lastPreset    = -1;
+    bool lastFromReference = false;
+
+    std::array<float, kMaxPresets> presetGainDb {};
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> gain { 1.0f };
+
+    std::atomic<float> inputShortTerm   { LoudnessMeter::kSilenceLufs },
+                       inputIntegrated  { LoudnessMeter::kSilenceLufs },
+                       outputMomentary  { LoudnessMeter::kSilenceLufs },
+                       outputShortTerm  { LoudnessMeter::kSilenceLufs },
+                       outputIntegrated { LoudnessMeter::kSilenceLufs },
+                       appliedGainDb    { 0.0f };
+};
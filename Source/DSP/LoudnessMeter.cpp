@@ -0,0 +1,196 @@
+#include "LoudnessMeter.h"
+#include <cmath>
+
+//==============================================================================
+void LoudnessMeter::prepare (double sampleRate, int numChannels)
+{
+    channels       = juce::jlimit (1, kMaxChannels, numChannels);
+    subBlockLength = juce::jmax (1, juce::roundToInt (sampleRate * 0.1));
+
+    // BS.1770 K-weighting, re-derived from its analogue prototypes so any rate
+    // matches the 48 kHz reference coefficients
+    {
+        constexpr double f0 = 1681.974450955533, gainDb = 3.999843853973347, q = 0.7071752369554196;
+        const double k  = std::tan (juce::MathConstants<double>::pi * f0 / sampleRate);
+        const double vh = std::pow (10.0, gainDb / 20.0);
+        const double vb = std::pow (vh, 0.4996667741545416);
+        const double a0 = 1.0 + k / q + k * k;
+
+        Biquad stage;
+        stage.b0 = (vh + vb * k / q + k * k) / a0;
+        stage.b1 = 2.0 * (k * k - vh) / a0;
+        stage.b2 = (vh - vb * k / q + k * k) / a0;
+        stage.a1 = 2.0 * (k * k - 1.0) / a0;
+        stage.a2 = (1.0 - k / q + k * k) / a0;
+        shelf.fill (stage);
+    }
+
+    {
+        constexpr double f0 = 38.13547087602444, q = 0.5003270373238773;
+        const double k  = std::tan (juce::MathConstants<double>::pi * f0 / sampleRate);
+        const double a0 = 1.0 + k / q + k * k;
+
+        Biquad stage;
+        stage.b0 = 1.0;
+        stage.b1 = -2.0;
+        stage.b2 = 1.0;
+        stage.a1 = 2.0 * (k * k - 1.0) / a0;
+        stage.a2 = (1.0 - k / q + k * k) / a0;
+        highPass.fill (stage);
+    }
+
+    for (int i = 0; i < kHistogramBins; ++i)
+    {
+        const float lufs = kHistogramMinLufs + (static_cast<float> (i) + 0.5f) * kHistogramStep;
+        binEnergy[static_cast<size_t> (i)] = std::pow (10.0, (lufs + 0.691) / 10.0);
+    }
+
+    reset();
+}
+
+void LoudnessMeter::reset()
+{
+    for (int ch = 0; ch < kMaxChannels; ++ch)
+    {
+        shelf[static_cast<size_t> (ch)].z1    = shelf[static_cast<size_t> (ch)].z2    = 0.0;
+        highPass[static_cast<size_t> (ch)].z1 = highPass[static_cast<size_t> (ch)].z2 = 0.0;
+    }
+
+    subBlockFill = 0;
+    subBlockSum  = 0.0;
+    subBlockEnergy.fill (0.0);
+    ringPos       = 0;
+    subBlocksSeen = 0;
+    histogram.fill (0);
+    integratedLufs = kSilenceLufs;
+}
+
+//==============================================================================
+void LoudnessMeter::process (const juce::AudioBuffer<float>& buffer)
+{
+    const int numSamples = buffer.getNumSamples();
+    const int chs        = juce::jmin (channels, buffer.getNumChannels());
+
+    // Run up to each 100 ms boundary, all channels at a time
+    for (int pos = 0; pos < numSamples;)
+    {
+        const int count = juce::jmin (numSamples - pos, subBlockLength - subBlockFill);
+
+        for (int ch = 0; ch < chs; ++ch)
+        {
+            const float* data = buffer.getReadPointer (ch, pos);
+            auto& s1 = shelf[static_cast<size_t> (ch)];
+            auto& s2 = highPass[static_cast<size_t> (ch)];
+            double sum = 0.0;
+
+            // Channel weights are all 1 for mono and stereo
+            for (int i = 0; i < count; ++i)
+            {
+                const double y = s2.processSample (s1.processSample (data[i]));
+                sum += y * y;
+            }
+
+            subBlockSum += sum;
+        }
+
+        subBlockFill += count;
+        pos          += count;
+
+        if (subBlockFill == subBlockLength)
+            finishSubBlock();
+    }
+}
+
+void LoudnessMeter::finishSubBlock()
+{
+    subBlockEnergy[static_cast<size_t> (ringPos)] = subBlockSum / subBlockLength;
+    ringPos = (ringPos + 1) % kShortTermSubBlocks;
+    ++subBlocksSeen;
+
+    subBlockSum  = 0.0;
+    subBlockFill = 0;
+
+    // Each sub-block completes a 400 ms gating block; only the absolute gate is applied here
+    if (subBlocksSeen >= kMomentarySubBlocks)
+    {
+        const float lufs = getMomentaryLufs();
+
+        if (lufs >= kHistogramMinLufs)
+        {
+            const int bin = juce::jmin (kHistogramBins - 1,
+                                        static_cast<int> ((lufs - kHistogramMinLufs) / kHistogramStep));
+            ++histogram[static_cast<size_t> (bin)];
+            integratedLufs = computeIntegrated();
+        }
+    }
+}
+
+//==============================================================================
+float LoudnessMeter::energyToLufs (double energy)
+{
+    return energy > 0.0 ? juce::jmax (kSilenceLufs, static_cast<float> (-0.691 + 10.0 * std::log10 (energy)))
+                        : kSilenceLufs;
+}
+
+float LoudnessMeter::getMomentaryLufs() const
+{
+    // Until the window has filled, average what there is
+    const int count = juce::jmin (subBlocksSeen, kMomentarySubBlocks);
+
+    if (count == 0)
+        return kSilenceLufs;
+
+    double sum = 0.0;
+
+    for (int i = 1; i <= count; ++i)
+        sum += subBlockEnergy[static_cast<size_t> ((ringPos - i + kShortTermSubBlocks) % kShortTermSubBlocks)];
+
+    return energyToLufs (sum / count);
+}
+
+float LoudnessMeter::getShortTermLufs() const
+{
+    const int count = juce::jmin (subBlocksSeen, kShortTermSubBlocks);
+
+    if (count == 0)
+        return kSilenceLufs;
+
+    double sum = 0.0;
+
+    for (int i = 0; i < count; ++i)
+        sum += subBlockEnergy[static_cast<size_t> (i)];
+
+    return energyToLufs (sum / count);
+}
+
+float LoudnessMeter::computeIntegrated() const
+{
+    // First pass: everything above the absolute gate sets the relative gate
+    double sum = 0.0;
+    juce::uint64 count = 0;
+
+    for (int i = 0; i < kHistogramBins; ++i)
+    {
+        sum   += histogram[static_cast<size_t> (i)] * binEnergy[static_cast<size_t> (i)];
+        count += histogram[static_cast<size_t> (i)];
+    }
+
+    if (count == 0)
+        return kSilenceLufs;
+
+    const float relativeGate = energyToLufs (sum / static_cast<double> (count)) - 10.0f;
+    const int firstBin = juce::jlimit (0, kHistogramBins,
+                                       static_cast<int> (std::ceil ((relativeGate - kHistogramMinLufs) / kHistogramStep - 0.5f)));
+
+    // Second pass: blocks above the relative gate
+    sum   = 0.0;
+    count = 0;
+
+    for (int i = firstBin; i < kHistogramBins; ++i)
+    {
+        sum   += histogram[static_cast<size_t> (i)] * binEnergy[static_cast<size_t> (i)];
+        count += histogram[static_cast<size_t> (i)];
+    }
+
+    return count > 0 ? energyToLufs (sum / static_cast<double> (count)) : kSilenceLufs;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+/**
+    Streaming ITU-R BS.1770 / EBU R128 loudness: momentary (400 ms),
+    short-term (3 s) and gated integrated loudness, in LUFS.
+
+    Samples are K-weighted (shelf + high-pass biquads, coefficients derived
+    for any sample rate), squared and summed into 100 ms sub-blocks.  A ring
+    of the last 30 sub-block energies gives both sliding windows, and every
+    sub-block completes a 400 ms gating block (75% overlap) that is counted
+    into a fixed 0.1 LU histogram.  Integrated loudness is re-gated from the
+    histogram once per sub-block, so memory stays constant however long the
+    meter runs and the per-sample cost is just the two biquads.
+
+    process() only reads the buffer.  Not thread-safe: publish the readings
+    yourself if another thread needs them.
+*/
+class LoudnessMeter
+{
+public:
+    static constexpr float kSilenceLufs = -100.0f;   // reported when there's nothing to measure
+
+    void prepare (double sampleRate, int numChannels);
+
+    /** Clears the filters, windows and gating histogram. */
+    void reset();
+
+    void process (const juce::AudioBuffer<float>& buffer);
+
+    float getMomentaryLufs() const;
+    float getShortTermLufs() const;
+    float getIntegratedLufs() const { return integratedLufs; }
+
+    /** True once a full 3 s short-term window has been measured since reset(). */
+    bool isShortTermValid() const { return subBlocksSeen >= kShortTermSubBlocks; }
+
+private:
+    static constexpr int kMaxChannels         = 8;
+    static constexpr int kMomentarySubBlocks  = 4;    // 400 ms of 100 ms sub-blocks
+    static constexpr int kShortTermSubBlocks  = 30;   // 3 s
+    static constexpr float kHistogramMinLufs  = -70.0f;   // also the absolute gate
+    static constexpr float kHistogramMaxLufs  = 5.0f;
+    static constexpr float kHistogramStep     = 0.1f;
+    static constexpr int kHistogramBins       = 750;      // (max - min) / step
+
+    /** Transposed direct form II; double state keeps the 38 Hz high-pass quiet at high rates. */
+    struct Biquad
+    {
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+        double z1 = 0.0, z2 = 0.0;
+
+        double processSample (double x)
+        {
+            const double y = b0 * x + z1;
+            z1 = b1 * x - a1 * y + z2;
+            z2 = b2 * x - a2 * y;
+            return y;
+        }
+    };
+
+    void finishSubBlock();
+    float computeIntegrated() const;
+
+    static float energyToLufs (double energy);
+
+    int channels         = 2;
+    int subBlockLength   = 4410;
+    int subBlockFill     = 0;
+    double subBlockSum   = 0.0;
+
+    std::array<Biquad, kMaxChannels> shelf, highPass;
+
+    std::array<double, kShortTermSubBlocks> subBlockEnergy {};
+    int ringPos          = 0;
+    int subBlocksSeen    = 0;
+
+    std::array<juce::uint32, kHistogramBins> histogram {};
+    std::array<double, kHistogramBins> binEnergy {};   // energy at each bin centre
+    float integratedLufs = kSilenceLufs;                // re-gated once per sub-block
+};
@@ -0,0 +1,49 @@
+#include "MemoryFootprint.h"
+
+//==============================================================================
+size_t MemoryFootprint::total() const
+{
+    size_t sum = 0;
+    for (auto b : bytes)
+        sum += b;
+    return sum;
+}
+
+MemoryFootprint& MemoryFootprint::operator+= (const MemoryFootprint& other)
+{
+    for (size_t i = 0; i < bytes.size(); ++i)
+        bytes[i] += other.bytes[i];
+    return *this;
+}
+
+const char* MemoryFootprint::getName (Subsystem s)
+{
+    switch (s)
+    {
+        case convolution:   return "Convolution";
+        case delayLines:    return "Delay lines";
+        case presetData:    return "Preset data";
+        case scratch:       return "Scratch";
+        case uiImages:      return "UI images";
+        case numSubsystems: break;
+    }
+
+    return "";
+}
+
+juce::String MemoryFootprint::toString() const
+{
+    auto format = [] (size_t b)
+    {
+        return b >= 1024 * 1024 ? juce::String (static_cast<double> (b) / (1024.0 * 1024.0), 1) + " MB"
+                                : juce::String (static_cast<double> (b) / 1024.0, 1) + " KB";
+    };
+
+    juce::String text;
+
+    for (int i = 0; i < numSubsystems; ++i)
+        text << getName (static_cast<Subsystem> (i)) << ": " << format (bytes[static_cast<size_t> (i)]) << "\n";
+
+    text << "Total: " << format (total());
+    return text;
+}
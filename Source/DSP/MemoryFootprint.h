@@ -0,0 +1,73 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <vector>
+
+//==============================================================================
+/**
+    Bytes held by one plugin instance, by subsystem.
+
+    Computed on request from the sizes of the containers involved; nothing
+    hooks the allocator, so asking costs a few loops over small vectors and
+    is fine for a once-a-second overlay.  juce::dsp::Convolution doesn't
+    report its buffers, so those are modelled from the IR length and block
+    size (see EnvironmentProcessor::estimateConvolutionBytes()).
+*/
+struct MemoryFootprint
+{
+    enum Subsystem
+    {
+        convolution,    // partitioned convolution engines: spectra, FIFOs, overlap
+        delayLines,     // reflections, bypass alignment, lookahead, resamplers, scheduler
+        presetData,     // per-preset IRs, fused FIRs, tails, true-stereo and cabin partitions
+        scratch,        // per-block work buffers, noise synthesis, the capture ring
+        uiImages,       // decoded editor images (one copy shared by every instance)
+        numSubsystems
+    };
+
+    std::array<size_t, numSubsystems> bytes {};
+
+    size_t& operator[] (Subsystem s)       { return bytes[static_cast<size_t> (s)]; }
+    size_t  operator[] (Subsystem s) const { return bytes[static_cast<size_t> (s)]; }
+
+    size_t total() const;
+    MemoryFootprint& operator+= (const MemoryFootprint& other);
+
+    static const char* getName (Subsystem s);
+
+    /** One line per subsystem and a total, in KB / MB. */
+    juce::String toString() const;
+
+    //==========================================================================
+    // Heap bytes owned by the containers this project uses (capacity, not size)
+    static size_t bytesOf (const juce::AudioBuffer<float>& buffer)
+    {
+        return static_cast<size_t> (buffer.getNumChannels()) * static_cast<size_t> (buffer.getNumSamples())
+                 * sizeof (float);
+    }
+
+    template <typename T>
+    static size_t bytesOf (const std::vector<T>& v)
+    {
+        return v.capacity() * sizeof (T);
+    }
+
+    template <typename T>
+    static size_t bytesOf (const std::vector<std::vector<T>>& v)
+    {
+        size_t total = v.capacity() * sizeof (std::vector<T>);
+        for (const auto& inner : v)
+            total += bytesOf (inner);
+        return total;
+    }
+
+    template <typename T, size_t N>
+    static size_t bytesOf (const std::array<T, N>& a)
+    {
+        size_t total = 0;
+        for (const auto& element : a)
+            total += bytesOf (element);
+        return total;
+    }
+};
@@ -0,0 +1,426 @@
+#include "MixAnalyser.h"
+#include "OfflineRenderer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr float kFloorDb = -100.0f;
+
+    float powerToDb (double power)
+    {
+        return power > 0.0 ? juce::jmax (kFloorDb, static_cast<float> (10.0 * std::log10 (power))) : kFloorDb;
+    }
+
+    std::unique_ptr<juce::AudioFormatReader> createReader (const juce::File& file)
+    {
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+        return std::unique_ptr<juce::AudioFormatReader> (formats.createReaderFor (file));
+    }
+}
+
+//==============================================================================
+const char* MixAnalyser::getBandName (int band)
+{
+    switch (band)
+    {
+        case sub:             return "Sub";
+        case bass:            return "Bass";
+        case lowMid:          return "LowMid";
+        case intelligibility: return "Intel";
+        case air:             return "Air";
+        default:              return "";
+    }
+}
+
+juce::Range<float> MixAnalyser::getBandRange (int band)
+{
+    switch (band)
+    {
+        case sub:             return { 20.0f,   60.0f };
+        case bass:            return { 60.0f,   250.0f };
+        case lowMid:          return { 250.0f,  1000.0f };
+        case intelligibility: return { 1000.0f, 4000.0f };
+        case air:             return { 4000.0f, 16000.0f };
+        default:              return {};
+    }
+}
+
+//==============================================================================
+/** Everything one pass measures, fed block by block. */
+class MixAnalyser::Accumulator
+{
+public:
+    explicit Accumulator (double rate)
+        : sampleRate (rate)
+    {
+        window.resize (static_cast<size_t> (kFftSize));
+        juce::dsp::WindowingFunction<float>::fillWindowingTables (window.data(), kFftSize,
+                                                                 juce::dsp::WindowingFunction<float>::hann, false);
+
+        for (auto w : window)
+            windowPower += static_cast<double> (w) * w;
+
+        for (auto& f : frame)
+            f.assign (static_cast<size_t> (kFftSize), 0.0f);
+
+        fftData.assign  (static_cast<size_t> (2 * kFftSize), 0.0f);
+        powerSum.assign (static_cast<size_t> (kFftSize / 2 + 1), 0.0);
+    }
+
+    void process (const juce::AudioBuffer<float>& buffer, int start, int numSamples)
+    {
+        const int chs = buffer.getNumChannels();
+        const float* left  = buffer.getReadPointer (0, start);
+        const float* right = buffer.getReadPointer (juce::jmin (1, chs - 1), start);
+
+        for (int pos = 0; pos < numSamples;)
+        {
+            const int count = juce::jmin (numSamples - pos, kFftSize - fill);
+
+            for (int i = 0; i < count; ++i)
+            {
+                const double l = left[pos + i], r = right[pos + i];
+                const double mid = 0.5 * (l + r), side = 0.5 * (l - r);
+
+                sumLeft  += l * l;
+                sumRight += r * r;
+                sumMid   += mid * mid;
+                sumSide  += side * side;
+                peak = juce::jmax (peak, std::abs (l), std::abs (r));
+            }
+
+            std::copy (left  + pos, left  + pos + count, frame[0].data() + fill);
+            std::copy (right + pos, right + pos + count, frame[1].data() + fill);
+
+            fill  += count;
+            pos   += count;
+            total += count;
+
+            if (fill == kFftSize)
+            {
+                analyseFrame();
+
+                // 50% overlap: the second half becomes the next frame's first
+                for (auto& f : frame)
+                    std::copy (f.begin() + kHop, f.end(), f.begin());
+
+                fill = kHop;
+            }
+        }
+    }
+
+    Measurements finish()
+    {
+        // Shorter than one frame: analyse what there is, zero-padded
+        if (numFrames == 0 && fill > 0)
+        {
+            for (auto& f : frame)
+                std::fill (f.begin() + fill, f.end(), 0.0f);
+
+            analyseFrame();
+        }
+
+        Measurements m;
+
+        if (total == 0)
+            return m;
+
+        const double channelPower = 0.5 * (sumLeft + sumRight) / static_cast<double> (total);
+        m.levelDb    = powerToDb (channelPower);
+        m.widthDb    = sumMid > 0.0 ? powerToDb (sumSide / sumMid) : kFloorDb;
+        m.monoFoldDb = channelPower > 0.0 ? powerToDb (sumMid / static_cast<double> (total) / channelPower) : 0.0f;
+        m.crestDb    = peak > 0.0 ? static_cast<float> (20.0 * std::log10 (peak)) - m.levelDb : 0.0f;
+
+        // One-sided Hann power spectrum -> mean power per channel
+        const double binHz = sampleRate / kFftSize;
+        const double scale = numFrames > 0 ? 2.0 / (numFrames * kFftSize * windowPower * 2.0) : 0.0;
+        double weighted = 0.0, sum = 0.0;
+
+        for (size_t k = 1; k < powerSum.size(); ++k)
+        {
+            weighted += powerSum[k] * static_cast<double> (k) * binHz;
+            sum      += powerSum[k];
+        }
+
+        m.centroidHz = sum > 0.0 ? static_cast<float> (weighted / sum) : 0.0f;
+
+        for (int b = 0; b < numBands; ++b)
+        {
+            const auto range = getBandRange (b);
+            double bandPower = 0.0;
+
+            for (size_t k = 1; k < powerSum.size(); ++k)
+            {
+                const double hz = static_cast<double> (k) * binHz;
+
+                if (hz >= range.getStart() && hz < range.getEnd())
+                    bandPower += powerSum[k];
+            }
+
+            m.bandDb[static_cast<size_t> (b)] = powerToDb (bandPower * scale);
+        }
+
+        return m;
+    }
+
+private:
+    static constexpr int kFftOrder = 12;
+    static constexpr int kFftSize  = 1 << kFftOrder;
+    static constexpr int kHop      = kFftSize / 2;
+
+    void analyseFrame()
+    {
+        for (auto& f : frame)
+        {
+            std::fill (fftData.begin(), fftData.end(), 0.0f);
+            juce::FloatVectorOperations::multiply (fftData.data(), f.data(), window.data(), kFftSize);
+            fft.performFrequencyOnlyForwardTransform (fftData.data(), true);
+
+            for (size_t k = 0; k < powerSum.size(); ++k)
+                powerSum[k] += static_cast<double> (fftData[k]) * fftData[k];
+        }
+
+        ++numFrames;
+    }
+
+    double sampleRate;
+    juce::dsp::FFT fft { kFftOrder };
+    std::vector<float> window, fftData;
+    std::array<std::vector<float>, 2> frame;   // left, right (mono sources use the same channel twice)
+    std::vector<double> powerSum;
+    double windowPower = 0.0;
+    int fill = 0;
+    juce::int64 numFrames = 0;
+
+    double sumLeft = 0.0, sumRight = 0.0, sumMid = 0.0, sumSide = 0.0, peak = 0.0;
+    juce::int64 total = 0;
+};
+
+//==============================================================================
+MixAnalyser::Report MixAnalyser::analyse (const juce::File& file, const Options& options)
+{
+    Report report;
+    report.sourceName = file.getFileName();
+
+    auto probe = createReader (file);
+
+    if (probe == nullptr)
+    {
+        report.error = "Couldn't read " + file.getFullPathName();
+        return report;
+    }
+
+    // The chains are mono / stereo; wider files are analysed from their first two channels
+    const double sampleRate = probe->sampleRate;
+    const int    channels   = juce::jlimit (1, 2, static_cast<int> (probe->numChannels));
+    const auto   length     = probe->lengthInSamples;
+    const int    blockSize  = juce::jmax (64, options.blockSize);
+    probe.reset();
+
+    report.sampleRate      = sampleRate;
+    report.numChannels     = channels;
+    report.lengthInSamples = length;
+
+    const auto& presetTable = getBuiltInPresets();
+
+    for (int index : options.presets)
+        if (juce::isPositiveAndBelow (index, static_cast<int> (presetTable.size())))
+            report.presets.push_back ({ index, presetTable[static_cast<size_t> (index)].name, {} });
+
+    // One pass over the input plus one per preset, each on its own pool thread
+    const int numPasses  = static_cast<int> (report.presets.size()) + 1;
+    const int numThreads = juce::jlimit (1, numPasses,
+                                         options.numThreads > 0 ? options.numThreads : juce::SystemStats::getNumCpus());
+
+    std::atomic<bool> readFailed { false };
+    std::atomic<bool> loadFailed { false };
+    std::atomic<bool> cancelled { false };
+
+    auto runPass = [&] (int pass)
+    {
+        // The file can go away or be rewritten between the probe and a pass
+        auto reader = createReader (file);
+
+        if (reader == nullptr)
+        {
+            readFailed = true;
+            return;
+        }
+
+        const bool isInput = pass == 0;
+        auto& result = isInput ? report.input : report.presets[static_cast<size_t> (pass - 1)].output;
+
+        std::unique_ptr<EnvironmentProcessor> env;
+        int latency = 0;
+
+        if (! isInput)
+        {
+            OfflineRenderer::Settings settings;
+            settings.presetIndex = report.presets[static_cast<size_t> (pass - 1)].presetIndex;
+            settings.sampleRate  = sampleRate;
+            settings.blockSize   = blockSize;
+            settings.quality     = options.quality;
+            settings.codecPath   = options.codecPath;
+            settings.reducedRate = options.reducedRate;
+
+            env = std::make_unique<EnvironmentProcessor>();
+
+            if (! OfflineRenderer::prepareChain (*env, settings, channels))
+            {
+                loadFailed = true;
+                return;
+            }
+
+            latency = env->getLatencySamples();
+
+            // How far eco's fitted model is from the IR it stands in for
+            if (options.quality == EnvironmentProcessor::Quality::eco)
+                report.presets[static_cast<size_t> (pass - 1)].ecoErrorDb = env->getEcoSpectralErrorDb (settings.presetIndex);
+        }
+
+        Accumulator accumulator (sampleRate);
+        juce::AudioBuffer<float> block (channels, blockSize);
+
+        // Chains run `latency` samples past the end so the tail is measured, minus the leading delay
+        const juce::int64 totalSamples = length + latency;
+
+        for (juce::int64 start = 0; start < totalSamples; start += blockSize)
+        {
+            if (options.shouldExit != nullptr && options.shouldExit())
+            {
+                cancelled = true;
+                return;
+            }
+
+            const int count = static_cast<int> (juce::jmin (static_cast<juce::int64> (blockSize), totalSamples - start));
+            juce::AudioBuffer<float> view (block.getArrayOfWritePointers(), channels, count);
+            view.clear();
+
+            const int toRead = static_cast<int> (juce::jlimit (static_cast<juce::int64> (0),
+                                                               static_cast<juce::int64> (count), length - start));
+
+            if (toRead > 0)
+                reader->read (&view, 0, toRead, start, true, channels > 1);
+
+            if (env != nullptr)
+                env->process (view);
+
+            const int skip = static_cast<int> (juce::jlimit (static_cast<juce::int64> (0),
+                                                             static_cast<juce::int64> (count), latency - start));
+
+            if (skip < count)
+                accumulator.process (view, skip, count - skip);
+        }
+
+        result = accumulator.finish();
+    };
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    {
+        juce::ThreadPool pool (numThreads);
+        juce::WaitableEvent finished;
+        std::atomic<int> remaining { numPasses };
+
+        for (int pass = 0; pass < numPasses; ++pass)
+        {
+            pool.addJob ([&, pass]
+            {
+                runPass (pass);
+
+                if (--remaining == 0)
+                    finished.signal();
+            });
+        }
+
+        finished.wait();
+    }
+
+    // A chain that never finished loading would report its plain path as the preset
+    if (cancelled)
+        report.error = "Analysis of " + file.getFullPathName() + " cancelled";
+    else if (readFailed)
+        report.error = "Couldn't read " + file.getFullPathName();
+    else if (loadFailed)
+        report.error = "A preset's IRs didn't load within " + juce::String (OfflineRenderer::kLoadTimeoutMs / 1000)
+                     + " s analysing " + file.getFullPathName();
+
+    report.seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+
+    if (report.seconds > 0.0 && sampleRate > 0.0)
+        report.realtimeFactor = (static_cast<double> (length) / sampleRate) / report.seconds;
+
+    return report;
+}
+
+//==============================================================================
+juce::String MixAnalyser::Report::toString() const
+{
+    if (error.isNotEmpty())
+        return error + "\n";
+
+    auto cell = [] (const juce::String& text, int width) { return text.paddedLeft (' ', width); };
+    auto value = [] (float v) { return juce::String (v, 1); };
+    auto delta = [] (float v) { return (v >= 0.0f ? "+" : "") + juce::String (v, 1); };
+
+    auto hz    = [] (int v) { return (v >= 0 ? "+" : "") + juce::String (v) + " Hz"; };
+
+    const int duration = sampleRate > 0.0 ? static_cast<int> (static_cast<double> (lengthInSamples) / sampleRate) : 0;
+
+    juce::String out;
+    out << "Mix translation: " << sourceName << "  (" << duration / 60 << ":"
+        << juce::String (duration % 60).paddedLeft ('0', 2) << ", " << juce::String (sampleRate, 0) << " Hz, "
+        << numChannels << " ch)\n"
+        << "Analysed " << static_cast<int> (presets.size()) << " environments in " << juce::String (seconds, 2)
+        << " s (" << juce::String (realtimeFactor, 0) << "x real time)\n\n";
+
+    // Header
+    out << juce::String ("").paddedRight (' ', 16) << cell ("Level", 7);
+
+    for (int b = 0; b < numBands; ++b)
+        out << cell (getBandName (b), 7);
+
+    const bool eco = std::any_of (presets.begin(), presets.end(),
+                                  [] (const PresetResult& p) { return p.ecoErrorDb >= 0.0f; });
+
+    out << cell ("Centroid", 10) << cell ("Width", 8) << cell ("MonoFold", 9) << cell ("Crest", 7)
+        << (eco ? cell ("EcoFit", 8) : juce::String()) << "\n";
+
+    // Input: absolute figures
+    out << juce::String ("Input (dBFS)").paddedRight (' ', 16) << cell (value (input.levelDb), 7);
+
+    for (auto db : input.bandDb)
+        out << cell (value (db), 7);
+
+    out << cell (juce::String (juce::roundToInt (input.centroidHz)) + " Hz", 10)
+        << cell (value (input.widthDb), 8) << cell (value (input.monoFoldDb), 9) << cell (value (input.crestDb), 7) << "\n";
+
+    // Environments: change from the input (width and mono fold stay absolute)
+    for (const auto& preset : presets)
+    {
+        const auto& m = preset.output;
+        out << preset.name.substring (0, 15).paddedRight (' ', 16) << cell (delta (m.levelDb - input.levelDb), 7);
+
+        for (size_t b = 0; b < m.bandDb.size(); ++b)
+            out << cell (delta (m.bandDb[b] - input.bandDb[b]), 7);
+
+        out << cell (hz (juce::roundToInt (m.centroidHz - input.centroidHz)), 10)
+            << cell (value (m.widthDb), 8) << cell (value (m.monoFoldDb), 9)
+            << cell (delta (m.crestDb - input.crestDb), 7);
+
+        if (eco)
+            out << cell (preset.ecoErrorDb >= 0.0f ? value (preset.ecoErrorDb) : juce::String ("--"), 8);
+
+        out << "\n";
+    }
+
+    out << "\nLevel and bands: dB change from the input.  Centroid: shift.  Width: side vs mid energy (dB).\n"
+           "MonoFold: mono sum vs channel average (0 = nothing cancels).  Crest: change in peak / RMS (dB).\n";
+
+    if (eco)
+        out << "EcoFit: RMS spectral error of the eco model against the real IR (dB).\n";
+
+    return out;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "EnvironmentProcessor.h"
+
+//==============================================================================
+/**
+    Mix-translation numbers: how much of a track's sub-bass, intelligibility
+    band and stereo content survives each environment.
+
+    analyse() streams a file through every requested preset's chain, one
+    preset per core on a local thread pool, plus one pass over the dry input.
+    Each pass reads the file block by block with its own reader and gathers
+    everything in that single pass:
+
+      - band energies and spectral centroid from a 50%-overlap Hann power
+        spectrum (4096 points), summed over both channels
+      - level, peak (crest factor), and mid / side energies for width and
+        mono-fold cancellation
+
+    Memory is a few blocks per pass regardless of length, so albums work as
+    well as single tracks.  Usable from the console tool and from the editor
+    (on a background thread).
+*/
+class MixAnalyser
+{
+public:
+    enum Band
+    {
+        sub,              // 20 - 60 Hz
+        bass,             // 60 - 250 Hz
+        lowMid,           // 250 Hz - 1 kHz
+        intelligibility,  // 1 - 4 kHz
+        air,              // 4 - 16 kHz
+        numBands
+    };
+
+    static const char*       getBandName  (int band);
+    static juce::Range<float> getBandRange (int band);
+
+    /** What one pass measured.  Levels are dBFS (power, both channels). */
+    struct Measurements
+    {
+        std::array<float, numBands> bandDb {};
+        float levelDb    = -100.0f;
+        float centroidHz = 0.0f;
+        float widthDb    = -100.0f;   // side energy relative to mid
+        float monoFoldDb = 0.0f;      // mono sum relative to the channels' average: 0 = no loss, -3 = uncorrelated
+        float crestDb    = 0.0f;      // peak over RMS
+    };
+
+    struct PresetResult
+    {
+        int          presetIndex = 0;
+        juce::String name;
+        Measurements output;
+        float        ecoErrorDb = -1.0f;   // eco quality: the IR model's RMS spectral error; -1 otherwise
+    };
+
+    struct Report
+    {
+        juce::String sourceName;
+        double       sampleRate      = 0.0;
+        int          numChannels     = 0;
+        juce::int64  lengthInSamples = 0;
+
+        Measurements input;
+        std::vector<PresetResult> presets;
+
+        double seconds        = 0.0;   // wall-clock time of the whole analysis
+        double realtimeFactor = 0.0;   // audio duration / wall-clock time
+        juce::String error;            // set if the file couldn't be read or a chain didn't load
+
+        /** Fixed-width text table: the input's figures, then each preset's change.
+            Just the error, if there is one: the figures are incomplete then. */
+        juce::String toString() const;
+    };
+
+    struct Options
+    {
+        std::vector<int> presets { 1, 2, 3, 4 };
+        int  blockSize   = 4096;
+        int  numThreads  = 0;          // 0 = one per core
+        EnvironmentProcessor::Quality quality = EnvironmentProcessor::Quality::normal;
+        EnvironmentProcessor::CodecPath codecPath = EnvironmentProcessor::CodecPath::off;
+        bool reducedRate = false;
+
+        // Polled between blocks by every pass; once true the report is just an error
+        std::function<bool()> shouldExit;
+    };
+
+    static Report analyse (const juce::File& file, const Options& options = {});
+
+private:
+    class Accumulator;
+};
@@ -1,97 +1,344 @@
 #include "NoiseGenerator.h"
+#include "MemoryFootprint.h"
+#include "DspKernels.h"
+#include <BinaryData.h>
+#include <cmath>
+
+namespace
+{
+    constexpr float kSilentDb = -200.0f;
+
+    // Width of a 1/3-octave band relative to its centre frequency
+    const float kThirdOctaveWidth = std::pow (2.0f, 1.0f / 6.0f) - std::pow (2.0f, -1.0f / 6.0f);
+
+    bool isNumber (const juce::String& token)
+    {
+        return token.isNotEmpty() && token.containsOnly ("0123456789.-+eE");
+    }
+}
+
+//==============================================================================
+NoiseProfile NoiseProfile::parse (const juce::String& text)
+{
+    NoiseProfile profile;
+
+    for (auto line : juce::StringArray::fromLines (text))
+    {
+        line = line.upToFirstOccurrenceOf ("#", false, false).trim();
+
+        if (line.isEmpty())
+            continue;
+
+        if (line.startsWithIgnoreCase ("name:"))
+        {
+            profile.name = line.fromFirstOccurrenceOf (":", false, false).trim();
+            continue;
+        }
+
+        if (line.startsWithIgnoreCase ("speed:"))
+        {
+            profile.speedKmh = juce::jmax (0.0f, line.fromFirstOccurrenceOf (":", false, false).trim().getFloatValue());
+            continue;
+        }
+
+        auto tokens = juce::StringArray::fromTokens (line, " \t,", {});
+        tokens.removeEmptyStrings();
+
+        // Anything else that isn't "frequency level [level [level]]" is a column header
+        if (tokens.size() < 2 || ! isNumber (tokens[0]))
+            continue;
+
+        const float hz = tokens[0].getFloatValue();
+
+        if (hz <= 0.0f || (! profile.bandHz.empty() && hz <= profile.bandHz.back()))
+            continue;
+
+        profile.bandHz.push_back (hz);
+
+        // Missing component columns are silent
+        for (int c = 0; c < numComponents; ++c)
+            profile.levelsDb[static_cast<size_t> (c)].push_back (c + 1 < tokens.size() && isNumber (tokens[c + 1])
+                                                                   ? tokens[c + 1].getFloatValue()
+                                                                   : kSilentDb);
+    }
+
+    return profile;
+}
+
+std::vector<NoiseProfile> NoiseProfile::loadDirectory (const juce::File& directory)
+{
+    std::vector<NoiseProfile> result;
+
+    for (const auto& file : directory.findChildFiles (juce::File::findFiles, false, "*.txt"))
+    {
+        auto profile = parse (file.loadFileAsString());
+
+        if (! profile.isValid())
+            continue;
+
+        if (profile.name.isEmpty())
+            profile.name = file.getFileNameWithoutExtension();
+
+        result.push_back (std::move (profile));
+    }
+
+    std::stable_sort (result.begin(), result.end(),
+                      [] (const NoiseProfile& a, const NoiseProfile& b) { return a.speedKmh < b.speedKmh; });
+    return result;
+}
+
+const std::vector<NoiseProfile>& NoiseProfile::getBuiltIn()
+{
+    static const std::vector<NoiseProfile> builtIn = []
+    {
+        std::vector<NoiseProfile> result;
+
+        for (auto [data, size] : { std::pair { BinaryData::noise_idle_txt,    BinaryData::noise_idle_txtSize },
+                                   std::pair { BinaryData::noise_city_txt,    BinaryData::noise_city_txtSize },
+                                   std::pair { BinaryData::noise_highway_txt, BinaryData::noise_highway_txtSize } })
+        {
+            auto profile = parse (juce::String::fromUTF8 (data, size));
+            jassert (profile.isValid());
+            result.push_back (std::move (profile));
+        }
+
+        std::stable_sort (result.begin(), result.end(),
+                          [] (const NoiseProfile& a, const NoiseProfile& b) { return a.speedKmh < b.speedKmh; });
+        return result;
+    }();
+
+    return builtIn;
+}
 
 //==============================================================================
-NoiseGenerator::NoiseGenerator() {}
+NoiseGenerator::NoiseGenerator()
+    : profiles (NoiseProfile::getBuiltIn())
+{
+}
 
 void NoiseGenerator::prepare (double sr, int /*samplesPerBlock*/)
 {
+    DspKernels::get();   // first call picks the variant, off the audio thread
+
     currentSampleRate = sr;
+    speedCoeff = 1.0f - std::exp (-static_cast<float> (kHop / (kSpeedTimeConstant * sr)));
 
-    // Road noise low-pass  – keep rumble below ~400 Hz
-    roadLP.setCoefficients (400.0f, sr);
+    // Sine window: applied once on synthesis, its square sums to one at 50% overlap
+    window.resize (static_cast<size_t> (kFftSize));
 
-    // AC hum band: LP at 180 Hz, HP at 80 Hz -> narrow band around 120 Hz
-    humLP.setCoefficients (180.0f, sr);
-    humHP.setCoefficients (80.0f,  sr);
+    for (int n = 0; n < kFftSize; ++n)
+        window[static_cast<size_t> (n)] = std::sin (juce::MathConstants<float>::pi * (n + 0.5f) / kFftSize);
 
-    // City ambience mid-range texture
-    cityLP.setCoefficients (2000.0f, sr);
+    magnitudes.assign (static_cast<size_t> (kNumBins), 0.0f);
+    phases.assign (static_cast<size_t> (kNumBins), 0.0f);
+    fftData.assign    (static_cast<size_t> (2 * kFftSize), 0.0f);
+    overlapAdd.assign (static_cast<size_t> (kFftSize), 0.0f);
 
+    buildBinLevels();
     reset();
 }
 
 void NoiseGenerator::reset()
 {
-    pink0 = pink1 = pink2 = pink3 = pink4 = pink5 = pink6 = 0.0f;
-    roadLP.reset();
-    humLP.reset();
-    humHP.reset();
-    cityLP.reset();
+    if (overlapAdd.empty())
+        return;
+
+    smoothedSpeed = targetSpeed;
+    builtSpeed    = -1.0f;
+    updateMagnitudes();
+
+    // Prime one frame so the first hop out already has both overlapping halves
+    std::fill (overlapAdd.begin(), overlapAdd.end(), 0.0f);
+    synthesiseFrame();
+    readPos = kHop;
 }
 
-//==============================================================================
-float NoiseGenerator::generatePinkSample()
+size_t NoiseGenerator::getMemoryBytes() const
 {
-    // Paul Kellet's economy pink noise approximation
-    const float white = rng.nextFloat() * 2.0f - 1.0f;
+    size_t total = MemoryFootprint::bytesOf (window) + MemoryFootprint::bytesOf (magnitudes)
+                 + MemoryFootprint::bytesOf (phases) + MemoryFootprint::bytesOf (fftData)
+                 + MemoryFootprint::bytesOf (overlapAdd)
+                 + binLevelsDb.capacity() * sizeof (binLevelsDb[0]);
 
-    pink0 = 0.99886f * pink0 + white * 0.0555179f;
-    pink1 = 0.99332f * pink1 + white * 0.0750759f;
-    pink2 = 0.96900f * pink2 + white * 0.1538520f;
-    pink3 = 0.86650f * pink3 + white * 0.3104856f;
-    pink4 = 0.55000f * pink4 + white * 0.5329522f;
-    pink5 = -0.7616f * pink5 - white * 0.0168980f;
+    for (const auto& levels : binLevelsDb)
+        total += MemoryFootprint::bytesOf (levels);
 
-    float pink = pink0 + pink1 + pink2 + pink3 + pink4 + pink5 + pink6 + white * 0.5362f;
-    pink6 = white * 0.115926f;
+    return total;
+}
 
-    return pink * 0.11f; // normalize
+void NoiseGenerator::setSeed (juce::int64 seed)
+{
+    rng.setSeed (seed);
+    reset();
 }
 
-//==============================================================================
-void NoiseGenerator::process (juce::AudioBuffer<float>& buffer, float amount)
+void NoiseGenerator::setSpeed (float kmh)
+{
+    targetSpeed = juce::jmax (0.0f, kmh);
+}
+
+void NoiseGenerator::setProfiles (std::vector<NoiseProfile> newProfiles)
 {
-    if (amount <= 0.0001f)
+    newProfiles.erase (std::remove_if (newProfiles.begin(), newProfiles.end(),
+                                       [] (const NoiseProfile& p) { return ! p.isValid(); }),
+                       newProfiles.end());
+
+    if (newProfiles.empty())
         return;
 
-    const int numChannels = buffer.getNumChannels();
-    const int numSamples  = buffer.getNumSamples();
+    std::stable_sort (newProfiles.begin(), newProfiles.end(),
+                      [] (const NoiseProfile& a, const NoiseProfile& b) { return a.speedKmh < b.speedKmh; });
+    profiles = std::move (newProfiles);
+
+    if (! overlapAdd.empty())
+    {
+        buildBinLevels();
+        builtSpeed = -1.0f;
+        updateMagnitudes();
+    }
+}
 
-    for (int s = 0; s < numSamples; ++s)
+//==============================================================================
+void NoiseGenerator::buildBinLevels()
+{
+    const float binWidth   = static_cast<float> (currentSampleRate / kFftSize);
+    const float binWidthDb = 10.0f * std::log10 (binWidth);
+
+    binLevelsDb.resize (profiles.size());
+
+    for (size_t p = 0; p < profiles.size(); ++p)
     {
-        float pinkSample = generatePinkSample();
-        float white = rng.nextFloat() * 2.0f - 1.0f;
+        const auto& profile = profiles[p];
+        const auto& bands   = profile.bandHz;
+        const int numBands  = static_cast<int> (bands.size());
 
-        // City noise: road rumble + engine/AC hum + mid-range ambience
-        float roadSample = roadLP.processSample (pinkSample);
-        float humSample  = humLP.processSample (white);
-        humSample = humSample - humHP.processSample (humSample); // crude band-pass
-        float citySample = cityLP.processSample (pinkSample * 0.5f + white * 0.5f);
+        for (int c = 0; c < NoiseProfile::numComponents; ++c)
+        {
+            const auto& levels = profile.levelsDb[static_cast<size_t> (c)];
+            auto& bins = binLevelsDb[p][static_cast<size_t> (c)];
+            bins.assign (static_cast<size_t> (kNumBins), kSilentDb);
 
-        float noise = roadSample * 0.45f + humSample * 0.30f + citySample * 0.25f;
+            // Band power -> power density, so bins of any width get the right share
+            auto densityDb = [&] (int b)
+            {
+                const auto i = static_cast<size_t> (b);
+                return levels[i] - 10.0f * std::log10 (bands[i] * kThirdOctaveWidth);
+            };
 
-        // Scale by amount  (amount 0..1 maps to roughly -60 dB .. -12 dB)
-        float gain = amount * amount * 0.25f;   // quadratic taper feels more natural
-        noise *= gain;
+            int band = 0;
 
-        // Add to every channel
-        for (int ch = 0; ch < numChannels; ++ch)
-            buffer.getWritePointer (ch)[s] += noise;
+            // DC and Nyquist stay silent
+            for (int k = 1; k < kNumBins - 1; ++k)
+            {
+                const float hz = static_cast<float> (k) * binWidth;
+
+                while (band < numBands - 2 && hz > bands[static_cast<size_t> (band + 1)])
+                    ++band;
+
+                // Straight lines in log frequency between band centres, held flat past either end
+                const float lo = bands[static_cast<size_t> (band)];
+                const float hi = bands[static_cast<size_t> (band + 1)];
+                const float t  = juce::jlimit (0.0f, 1.0f, std::log (hz / lo) / std::log (hi / lo));
+
+                bins[static_cast<size_t> (k)] = juce::jmap (t, densityDb (band), densityDb (band + 1)) + binWidthDb;
+            }
+        }
     }
 }
 
-//==============================================================================
-void NoiseGenerator::OnePole::setCoefficients (float cutoff, double sr)
+void NoiseGenerator::updateMagnitudes()
+{
+    if (profiles.empty() || magnitudes.empty())
+        return;
+
+    // Anchors either side of the speed, clamped to the slowest and fastest
+    size_t upper = 0;
+    while (upper < profiles.size() && profiles[upper].speedKmh < smoothedSpeed)
+        ++upper;
+
+    const size_t lower = upper == 0 ? 0 : upper - 1;
+    upper = juce::jmin (upper, profiles.size() - 1);
+
+    const float span = profiles[upper].speedKmh - profiles[lower].speedKmh;
+    const float t    = span > 0.0f ? juce::jlimit (0.0f, 1.0f, (smoothedSpeed - profiles[lower].speedKmh) / span)
+                                   : 0.0f;
+
+    // A random-phase bin of magnitude |X| (with its mirror) carries 2 |X|^2 / N^2 of
+    // power after JUCE's 1/N-scaled inverse, so |X| = N sqrt (p / 2)
+    for (int k = 0; k < kNumBins; ++k)
+    {
+        const auto i = static_cast<size_t> (k);
+        float power = 0.0f;
+
+        for (int c = 0; c < NoiseProfile::numComponents; ++c)
+        {
+            const auto ci = static_cast<size_t> (c);
+            const float db = juce::jmap (t, binLevelsDb[lower][ci][i], binLevelsDb[upper][ci][i]);
+
+            if (db > kSilentDb)
+                power += std::pow (10.0f, db * 0.1f);
+        }
+
+        magnitudes[i] = static_cast<float> (kFftSize) * std::sqrt (power * 0.5f);
+    }
+
+    builtSpeed = smoothedSpeed;
+}
+
+void NoiseGenerator::synthesiseFrame()
 {
-    float w = juce::MathConstants<float>::twoPi * cutoff / static_cast<float> (sr);
-    float c = std::cos (w);
-    a1 = -(c - 1.0f) / (c + 1.0f);      // simple one-pole LP approximation
-    b0 = (1.0f + a1) * 0.5f;
+    // Glide towards the target speed; the spectrum is rebuilt only while it moves
+    smoothedSpeed += (targetSpeed - smoothedSpeed) * speedCoeff;
+
+    if (std::abs (targetSpeed - smoothedSpeed) < 0.01f)
+        smoothedSpeed = targetSpeed;
+
+    if (std::abs (smoothedSpeed - builtSpeed) >= 0.01f)
+        updateMagnitudes();
+
+    const auto& kernels = DspKernels::get();
+
+    for (auto& phase : phases)
+        phase = rng.nextFloat() * juce::MathConstants<float>::twoPi;
+
+    kernels.polarToComplex (fftData.data(), magnitudes.data(), phases.data(), kNumBins);
+
+    fft.performRealOnlyInverseTransform (fftData.data());
+
+    // Slide the finished hop out, then add the new windowed frame over both halves
+    std::copy (overlapAdd.begin() + kHop, overlapAdd.end(), overlapAdd.begin());
+    std::fill (overlapAdd.begin() + kHop, overlapAdd.end(), 0.0f);
+
+    kernels.multiplyAdd (overlapAdd.data(), window.data(), fftData.data(), kFftSize);
 }
 
-float NoiseGenerator::OnePole::processSample (float x)
+//==============================================================================
+void NoiseGenerator::process (juce::AudioBuffer<float>& buffer, float amount)
 {
-    float y = b0 * x - a1 * z1;
-    z1 = y;
-    return y;
+    if (amount <= 0.0001f || overlapAdd.empty())
+        return;
+
+    const int numChannels = buffer.getNumChannels();
+    const int numSamples  = buffer.getNumSamples();
+
+    // Quadratic taper feels more natural; full amount plays the profile levels as written
+    const float gain = amount * amount;
+
+    for (int pos = 0; pos < numSamples;)
+    {
+        if (readPos == kHop)
+        {
+            synthesiseFrame();
+            readPos = 0;
+        }
+
+        const int count = juce::jmin (numSamples - pos, kHop - readPos);
+
+        // Same (mono) noise on every channel
+        for (int ch = 0; ch < numChannels; ++ch)
+            DspKernels::get().addScaled (buffer.getWritePointer (ch, pos), overlapAdd.data() + readPos, gain, count);
+
+        readPos += count;
+        pos     += count;
+    }
 }
@@ -1,16 +1,62 @@
 #pragma once
 
+#include <juce_dsp/juce_dsp.h>
 #include <juce_audio_basics/juce_audio_basics.h>
 
 //==============================================================================
 /**
-    Generates city background noise to blend into the output.
-    Driven by a single "amount" parameter (0 = silent, 1 = full).
+    Measured interior noise at one vehicle speed, as 1/3-octave band levels
+    for three components: road (tyres + wind), engine and HVAC.
 
-    The noise is a mix of:
-      - Filtered pink noise  (simulates road rumble / traffic)
-      - Narrow-band hum      (simulates AC / engine drone)
-      - Occasional broader spectrum (city ambience)
+    Profiles are plain text so they can be swapped without a rebuild:
+
+        # comment
+        name: City, 50 km/h
+        speed: 50
+        20      -40.0   -68.0   -72.6     <- band Hz, road dB, engine dB, hvac dB
+        25      ...
+
+    Levels are dBFS of band power at full noise amount.  Bands must ascend.
+*/
+struct NoiseProfile
+{
+    enum Component
+    {
+        road,
+        engine,
+        hvac,
+        numComponents
+    };
+
+    juce::String name;
+    float speedKmh = 0.0f;
+    std::vector<float> bandHz;
+    std::array<std::vector<float>, numComponents> levelsDb;
+
+    bool isValid() const { return bandHz.size() >= 2; }
+
+    /** Parses the text format above; the result is invalid if there are fewer than two bands. */
+    static NoiseProfile parse (const juce::String& text);
+
+    /** Every valid *.txt profile in directory, sorted by speed. */
+    static std::vector<NoiseProfile> loadDirectory (const juce::File& directory);
+
+    /** Idle, city and highway profiles from the binary resources, sorted by speed. */
+    static const std::vector<NoiseProfile>& getBuiltIn();
+};
+
+//==============================================================================
+/**
+    Generates in-car background noise to blend into the output.
+    Driven by an "amount" (0 = silent, 1 = full) and the vehicle speed.
+
+    Synthesis is spectral: each hop, a random-phase spectrum with the target
+    magnitude is inverse-FFT'd, sine-windowed and overlap-added at 50%.  The
+    sine window squared sums to one across the overlap, so output power
+    matches the target spectrum.  The target comes from the two profiles
+    either side of the current speed, interpolated in dB per component and
+    summed in power; speed changes glide over a couple of seconds and the
+    target is only rebuilt while the speed is still moving.
 */
 class NoiseGenerator
 {
@@ -21,28 +67,45 @@ public:
     void process (juce::AudioBuffer<float>& buffer, float amount);
     void reset();
 
+    /** Heap bytes of the per-profile bin levels and the synthesis buffers. */
+    size_t getMemoryBytes() const;
+
+    /** Reseeds the random source so renders are reproducible. */
+    void setSeed (juce::int64 seed);
+
+    /** Target vehicle speed in km/h; the spectrum glides towards it. */
+    void setSpeed (float kmh);
+
+    /** Replaces the profiles (invalid ones are dropped; none left keeps the current set).
+        Call before prepare() or while not processing. */
+    void setProfiles (std::vector<NoiseProfile> newProfiles);
+
 private:
-    /** Simple one-pole filter for colouring white noise. */
-    struct OnePole
-    {
-        float b0 = 0.0f, a1 = 0.0f, z1 = 0.0f;
-        void  setCoefficients (float cutoff, double sr);
-        float processSample (float x);
-        void  reset() { z1 = 0.0f; }
-    };
+    static constexpr int kFftOrder = 11;
+    static constexpr int kFftSize  = 1 << kFftOrder;
+    static constexpr int kHop      = kFftSize / 2;
+    static constexpr int kNumBins  = kFftSize / 2 + 1;
+
+    static constexpr float kSpeedTimeConstant = 2.0f;   // seconds
+
+    void buildBinLevels();
+    void updateMagnitudes();
+    void synthesiseFrame();
 
     juce::Random rng;
     double currentSampleRate = 44100.0;
 
-    // Pink noise approximation via Paul Kellet's method
-    float pink0 = 0.0f, pink1 = 0.0f, pink2 = 0.0f,
-          pink3 = 0.0f, pink4 = 0.0f, pink5 = 0.0f, pink6 = 0.0f;
-    float generatePinkSample();
-
-    // Low-pass to shape road noise
-    OnePole roadLP;
-    // Band-pass for AC / engine hum (~120 Hz)
-    OnePole humLP, humHP;
-    // Mid-range city ambience
-    OnePole cityLP;
+    std::vector<NoiseProfile> profiles;
+
+    // Per profile, per component: level of each FFT bin in dB (rebuilt at prepare)
+    std::vector<std::array<std::vector<float>, NoiseProfile::numComponents>> binLevelsDb;
+
+    juce::dsp::FFT fft { kFftOrder };
+    std::vector<float> window, magnitudes, phases, fftData, overlapAdd;
+    int readPos = kHop;
+
+    float targetSpeed   = 50.0f;
+    float smoothedSpeed = 50.0f;
+    float builtSpeed    = -1.0f;   // speed the magnitudes were last built for
+    float speedCoeff    = 0.0f;    // per hop
 };
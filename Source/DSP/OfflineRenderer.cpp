@@ -0,0 +1,498 @@
+#include "OfflineRenderer.h"
+#include <array>
+#include <cmath>
+
+//==============================================================================
+OfflineRenderer::Result OfflineRenderer::render (const juce::AudioBuffer<float>& input,
+                                                 const Settings& settings)
+{
+    const int channels  = juce::jmax (1, input.getNumChannels());
+    const int blockSize = juce::jmax (1, settings.blockSize);
+
+    EnvironmentProcessor env;
+    NoiseGenerator noise;
+
+    Result result;
+
+    if (! prepareChain (env, settings, channels))
+    {
+        result.error = "Preset " + juce::String (settings.presetIndex) + " didn't load within "
+                     + juce::String (kLoadTimeoutMs / 1000) + " s";
+        return result;
+    }
+
+    noise.prepare (settings.sampleRate, blockSize);
+
+    juce::AudioBuffer<float> block (channels, blockSize);
+    noise.setSpeed (settings.noiseSpeedKmh);
+    noise.setSeed (settings.noiseSeed);
+
+    // ---- Render ----
+    // The input is followed by `latency` samples of silence, and that many
+    // leading output samples are dropped, so output[t] lines up with input[t]
+    const int numSamples = input.getNumSamples();
+    const int latency    = env.getLatencySamples();
+    result.output.setSize (channels, numSamples);
+    result.output.clear();
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    for (int start = 0; start < numSamples + latency; start += blockSize)
+    {
+        const int length = juce::jmin (blockSize, numSamples + latency - start);
+        juce::AudioBuffer<float> view (block.getArrayOfWritePointers(), channels, length);
+        view.clear();
+
+        const int inputLength = juce::jlimit (0, length, numSamples - start);
+
+        for (int ch = 0; ch < channels; ++ch)
+            view.copyFrom (ch, 0, input, juce::jmin (ch, input.getNumChannels() - 1), start, inputLength);
+
+        env.process (view);
+
+        // Keep only the part of this block that maps onto [0, numSamples)
+        const int skip = juce::jlimit (0, length, latency - start);
+
+        if (skip < length)
+            for (int ch = 0; ch < channels; ++ch)
+                result.output.copyFrom (ch, start + skip - latency, view, ch, skip, length - skip);
+    }
+
+    // Noise goes on after alignment, so it's identical whatever the chain's latency
+    for (int start = 0; start < numSamples; start += blockSize)
+    {
+        juce::AudioBuffer<float> view (result.output.getArrayOfWritePointers(), channels, start,
+                                       juce::jmin (blockSize, numSamples - start));
+        noise.process (view, settings.noiseAmount);
+    }
+
+    result.seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+
+    if (result.seconds > 0.0)
+        result.realtimeFactor = (numSamples / settings.sampleRate) / result.seconds;
+
+    return result;
+}
+
+bool OfflineRenderer::prepareChain (EnvironmentProcessor& env, const Settings& settings, int numChannels)
+{
+    const int channels  = juce::jmax (1, numChannels);
+    const int blockSize = juce::jmax (1, settings.blockSize);
+
+    juce::dsp::ProcessSpec spec;
+    spec.sampleRate       = settings.sampleRate;
+    spec.maximumBlockSize = static_cast<juce::uint32> (blockSize);
+    spec.numChannels      = static_cast<juce::uint32> (channels);
+
+    // Modes first, so prepare() starts building whatever they need straight
+    // away rather than via the update thread
+    env.setQuality (settings.quality);
+    env.setConvolutionMode (settings.presetIndex, settings.convolutionMode);
+    env.setSeat (settings.seat);
+    env.setCodecPath (settings.codecPath);
+    env.setReducedRate (settings.reducedRate);
+    env.setHighQuality (settings.highQuality);
+    env.setPreset (settings.presetIndex);
+    env.prepare (spec);
+
+    // ---- Let the convolver finish loading and crossfading ----
+    juce::AudioBuffer<float> block (channels, blockSize);
+    const auto deadline = juce::Time::getMillisecondCounter() + static_cast<juce::uint32> (kLoadTimeoutMs);
+
+    while (! env.isConvolutionReady())
+    {
+        if (juce::Time::getMillisecondCounter() >= deadline)
+        {
+            jassertfalse;   // a loader thread is stuck, or the machine is badly overloaded
+            return false;
+        }
+
+        block.clear();
+        env.process (block);
+        juce::Thread::sleep (1);
+    }
+
+    for (int warm = 0; warm < static_cast<int> (settings.sampleRate * 0.25) / blockSize + 1; ++warm)
+    {
+        block.clear();
+        env.process (block);
+    }
+
+    env.reset();
+    return true;
+}
+
+//==============================================================================
+OfflineRenderer::Deviation OfflineRenderer::compare (const juce::AudioBuffer<float>& reference,
+                                                     const juce::AudioBuffer<float>& test)
+{
+    Deviation d;
+
+    const int channels   = juce::jmin (reference.getNumChannels(), test.getNumChannels());
+    const int numSamples = juce::jmin (reference.getNumSamples(), test.getNumSamples());
+
+    if (channels == 0 || numSamples == 0)
+        return d;
+
+    double sumSquares = 0.0;
+
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        const auto* r = reference.getReadPointer (ch);
+        const auto* t = test.getReadPointer (ch);
+
+        for (int s = 0; s < numSamples; ++s)
+        {
+            const float diff = t[s] - r[s];
+            d.maxAbs = juce::jmax (d.maxAbs, std::abs (diff));
+            sumSquares += static_cast<double> (diff) * diff;
+        }
+    }
+
+    d.rms      = static_cast<float> (std::sqrt (sumSquares / (static_cast<double> (channels) * numSamples)));
+    d.maxAbsDb = juce::Decibels::gainToDecibels (d.maxAbs, -200.0f);
+    d.rmsDb    = juce::Decibels::gainToDecibels (d.rms, -200.0f);
+    return d;
+}
+
+//==============================================================================
+OfflineRenderer::InstanceBenchmark OfflineRenderer::benchmarkInstances (const Settings& settings,
+                                                                       int numInstances, double seconds)
+{
+    InstanceBenchmark result;
+    result.numInstances  = juce::jmax (1, numInstances);
+    result.hotStateBytes = EnvironmentProcessor::getHotStateBytes();
+
+    const int blockSize = juce::jmax (1, settings.blockSize);
+    const int numBlocks = juce::jmax (1, static_cast<int> (seconds * settings.sampleRate) / blockSize);
+
+    std::vector<std::unique_ptr<EnvironmentProcessor>> chains;
+
+    for (int i = 0; i < result.numInstances; ++i)
+    {
+        chains.push_back (std::make_unique<EnvironmentProcessor>());
+
+        if (! prepareChain (*chains.back(), settings, 2))
+        {
+            result.error = "Instance " + juce::String (i + 1) + " didn't load within "
+                         + juce::String (kLoadTimeoutMs / 1000) + " s";
+            return result;
+        }
+    }
+
+    const auto input = TestSignals::pinkNoise (settings.sampleRate, 1.0);
+    const int  inputLength = juce::jmin (blockSize, input.getNumSamples());
+    juce::AudioBuffer<float> block (2, blockSize);
+
+    // Both runs process numBlocks * numInstances blocks; only the interleaving differs
+    auto run = [&] (bool roundRobin)
+    {
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+
+        for (int b = 0; b < numBlocks; ++b)
+        {
+            for (int i = 0; i < result.numInstances; ++i)
+            {
+                block.clear();
+                for (int ch = 0; ch < 2; ++ch)
+                    block.copyFrom (ch, 0, input, ch, 0, inputLength);
+
+                chains[roundRobin ? static_cast<size_t> (i) : 0]->process (block);
+            }
+        }
+
+        const double elapsed = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks()
+                                                                         - startTicks);
+        return elapsed * 1.0e9 / (static_cast<double> (numBlocks) * result.numInstances * blockSize);
+    };
+
+    result.nsPerSampleOne  = run (false);
+    result.nsPerSampleMany = run (true);
+    return result;
+}
+
+//==============================================================================
+OfflineRenderer::StartupBenchmark OfflineRenderer::benchmarkStartup (const Settings& settings, int numInstances)
+{
+    StartupBenchmark result;
+    result.numInstances = juce::jmax (1, numInstances);
+
+    // Made, prepared and loaded, then any background work waited for; the
+    // chains are kept alive to the end so the footprints add up as in a session
+    auto load = [&] (bool eager, double& readyMs, size_t& bytes)
+    {
+        std::vector<std::unique_ptr<EnvironmentProcessor>> chains;
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+
+        for (int i = 0; i < result.numInstances; ++i)
+        {
+            chains.push_back (std::make_unique<EnvironmentProcessor>());
+
+            // Async tails need every preset's data, so prepare() builds it all straight away
+            chains.back()->setAsyncTails (eager);
+
+            if (! prepareChain (*chains.back(), settings, 2))
+            {
+                result.error = "Instance " + juce::String (i + 1) + " didn't load within "
+                             + juce::String (kLoadTimeoutMs / 1000) + " s";
+                return false;
+            }
+        }
+
+        const auto deadline = juce::Time::getMillisecondCounter() + static_cast<juce::uint32> (kLoadTimeoutMs);
+
+        for (const auto& chain : chains)
+        {
+            if (! eager && chain->hasStartedPresetData())
+                result.lazyBuiltData = true;
+
+            while (chain->isBuildingPresetData())
+            {
+                if (juce::Time::getMillisecondCounter() >= deadline)
+                {
+                    result.error = "Preset data wasn't built within " + juce::String (kLoadTimeoutMs / 1000) + " s";
+                    return false;
+                }
+
+                juce::Thread::sleep (1);
+            }
+        }
+
+        readyMs = 1000.0 * juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+
+        for (const auto& chain : chains)
+            bytes += chain->getMemoryFootprint().total();
+
+        return true;
+    };
+
+    if (load (false, result.lazyReadyMs, result.lazyBytes))
+        load (true, result.eagerReadyMs, result.eagerBytes);
+
+    return result;
+}
+
+//==============================================================================
+OfflineRenderer::CompressorBenchmark OfflineRenderer::benchmarkCompressor (double sampleRate, int blockSize,
+                                                                         double seconds)
+{
+    blockSize = juce::jmax (1, blockSize);
+
+    auto input = TestSignals::pinkNoise (sampleRate, juce::jmax (0.1, seconds));
+    input.applyGain (2.0f);   // peaks well over the threshold, so both are always limiting
+
+    const int numSamples = input.getNumSamples();
+    juce::AudioBuffer<float> buffer (2, numSamples);
+
+    auto run = [&] (auto&& processBlock)
+    {
+        double elapsed = 0.0;
+
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            buffer.makeCopyOf (input, true);
+            const auto startTicks = juce::Time::getHighResolutionTicks();
+
+            for (int start = 0; start < numSamples; start += blockSize)
+            {
+                juce::AudioBuffer<float> block (buffer.getArrayOfWritePointers(), 2, start,
+                                                juce::jmin (blockSize, numSamples - start));
+                processBlock (block);
+            }
+
+            elapsed = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+        }
+
+        return elapsed * 1.0e9 / numSamples;
+    };
+
+    LinkedCompressor::Settings settings;
+    settings.thresholdDb = -10.0f;
+    settings.ratio       = 10.0f;
+    settings.attackMs    = 1.0f;
+    settings.releaseMs   = 60.0f;
+
+    LinkedCompressor linked;
+    linked.prepare (sampleRate, blockSize, 2, 0.0f);
+    linked.setSettings (settings);
+
+    juce::dsp::Compressor<float> reference;
+    reference.prepare ({ sampleRate, static_cast<juce::uint32> (blockSize), 2 });
+    reference.setThreshold (settings.thresholdDb);
+    reference.setRatio (settings.ratio);
+    reference.setAttack (settings.attackMs);
+    reference.setRelease (settings.releaseMs);
+
+    CompressorBenchmark result;
+    result.nsPerSampleLinked = run ([&] (juce::AudioBuffer<float>& block) { linked.process (block); });
+    result.nsPerSampleJuce   = run ([&] (juce::AudioBuffer<float>& block)
+    {
+        juce::dsp::AudioBlock<float> audio (block);
+        reference.process (juce::dsp::ProcessContextReplacing<float> (audio));
+    });
+
+    return result;
+}
+
+//==============================================================================
+namespace
+{
+    // Per built-in preset, in MB.  The Sedan and the BT speaker build every
+    // preset's data (cabin model, true stereo), so theirs include it; the
+    // Laptop's 3 s IR dominates the plain convolver
+    constexpr std::array<int, 5> kMemoryBudgetsMB { 1, 24, 2, 28, 32 };
+}
+
+bool OfflineRenderer::checkMemoryBudgets (juce::String& report)
+{
+    bool passed = true;
+
+    for (int preset = 0; preset < static_cast<int> (kMemoryBudgetsMB.size()); ++preset)
+    {
+        Settings settings;
+        settings.presetIndex = preset;
+        settings.sampleRate  = 48000.0;
+        settings.blockSize   = 512;
+
+        EnvironmentProcessor env;
+        bool loaded = prepareChain (env, settings, 2);
+
+        // Every preset's data, not just this one's
+        const auto deadline = juce::Time::getMillisecondCounter() + static_cast<juce::uint32> (kLoadTimeoutMs);
+        while (loaded && env.isBuildingPresetData())
+        {
+            loaded = juce::Time::getMillisecondCounter() < deadline;
+            juce::Thread::sleep (10);
+        }
+
+        if (! loaded)
+        {
+            passed = false;
+            report << "Preset " << preset << "  DIDN'T LOAD within " << kLoadTimeoutMs / 1000 << " s\n\n";
+            continue;
+        }
+
+        const auto footprint = env.getMemoryFootprint();
+        const auto budget    = static_cast<size_t> (kMemoryBudgetsMB[static_cast<size_t> (preset)]) * 1024 * 1024;
+        const bool within    = footprint.total() <= budget;
+        passed = passed && within;
+
+        report << "Preset " << preset << " (budget " << kMemoryBudgetsMB[static_cast<size_t> (preset)] << " MB)"
+               << (within ? "" : "  OVER BUDGET") << "\n"
+               << footprint.toString() << "\n\n";
+    }
+
+    return passed;
+}
+
+//==============================================================================
+bool OfflineRenderer::writeWav (const juce::AudioBuffer<float>& buffer, double sampleRate, const juce::File& file)
+{
+    file.deleteFile();
+    std::unique_ptr<juce::OutputStream> stream (file.createOutputStream());
+
+    if (stream == nullptr)
+        return false;
+
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatWriter> writer (
+        wav.createWriterFor (stream.get(), sampleRate, static_cast<unsigned int> (buffer.getNumChannels()),
+                             32, {}, 0));
+
+    if (writer == nullptr)
+        return false;
+
+    stream.release();   // the writer owns it now
+    return writer->writeFromAudioSampleBuffer (buffer, 0, buffer.getNumSamples());
+}
+
+bool OfflineRenderer::readWav (const juce::File& file, juce::AudioBuffer<float>& dest, double& sampleRate)
+{
+    auto stream = file.createInputStream();
+
+    if (stream == nullptr)
+        return false;
+
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatReader> reader (wav.createReaderFor (stream.release(), true));
+
+    if (reader == nullptr)
+        return false;
+
+    dest.setSize (static_cast<int> (reader->numChannels), static_cast<int> (reader->lengthInSamples));
+    reader->read (&dest, 0, dest.getNumSamples(), 0, true, true);
+    sampleRate = reader->sampleRate;
+    return true;
+}
+
+//==============================================================================
+juce::AudioBuffer<float> OfflineRenderer::TestSignals::impulse (double sampleRate, double seconds)
+{
+    juce::AudioBuffer<float> b (2, juce::jmax (1, static_cast<int> (sampleRate * seconds)));
+    b.clear();
+    b.setSample (0, 0, 1.0f);
+    b.setSample (1, 0, 1.0f);
+    return b;
+}
+
+juce::AudioBuffer<float> OfflineRenderer::TestSignals::sweep (double sampleRate, double seconds,
+                                                             float startHz, float endHz)
+{
+    // Exponential (log) sine sweep at -6 dBFS
+    const int numSamples = juce::jmax (1, static_cast<int> (sampleRate * seconds));
+    juce::AudioBuffer<float> b (2, numSamples);
+
+    const double k     = std::log (static_cast<double> (endHz) / startHz);
+    const double scale = juce::MathConstants<double>::twoPi * startHz * seconds / k;
+
+    for (int s = 0; s < numSamples; ++s)
+    {
+        const double t = s / sampleRate;
+        const auto v = static_cast<float> (0.5 * std::sin (scale * (std::exp (t * k / seconds) - 1.0)));
+        b.setSample (0, s, v);
+        b.setSample (1, s, v);
+    }
+
+    return b;
+}
+
+juce::AudioBuffer<float> OfflineRenderer::TestSignals::pinkNoise (double sampleRate, double seconds,
+                                                                 juce::int64 seed)
+{
+    // Seeded pink noise (Paul Kellet's refined filter), identical on both channels
+    juce::AudioBuffer<float> b (2, juce::jmax (1, static_cast<int> (sampleRate * seconds)));
+    juce::Random rng (seed);
+    float p0 = 0.0f, p1 = 0.0f, p2 = 0.0f, p3 = 0.0f, p4 = 0.0f, p5 = 0.0f, p6 = 0.0f;
+
+    for (int s = 0; s < b.getNumSamples(); ++s)
+    {
+        const float white = rng.nextFloat() * 2.0f - 1.0f;
+        p0 = 0.99886f * p0 + white * 0.0555179f;
+        p1 = 0.99332f * p1 + white * 0.0750759f;
+        p2 = 0.96900f * p2 + white * 0.1538520f;
+        p3 = 0.86650f * p3 + white * 0.3104856f;
+        p4 = 0.55000f * p4 + white * 0.5329522f;
+        p5 = -0.7616f * p5 - white * 0.0168980f;
+        const float pink = (p0 + p1 + p2 + p3 + p4 + p5 + p6 + white * 0.5362f) * 0.11f;
+        p6 = white * 0.115926f;
+
+        b.setSample (0, s, pink);
+        b.setSample (1, s, pink);
+    }
+
+    return b;
+}
+
+juce::AudioBuffer<float> OfflineRenderer::TestSignals::cityNoise (double sampleRate, double seconds,
+                                                                 juce::int64 seed)
+{
+    // Seeded full-scale NoiseGenerator output on a silent buffer
+    juce::AudioBuffer<float> b (2, juce::jmax (1, static_cast<int> (sampleRate * seconds)));
+    b.clear();
+
+    NoiseGenerator gen;
+    gen.prepare (sampleRate, b.getNumSamples());
+    gen.setSeed (seed);
+    gen.process (b, 1.0f);
+    return b;
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "EnvironmentProcessor.h"
+#include "NoiseGenerator.h"
+
+//==============================================================================
+/**
+    Deterministic offline rendering of the DSP chain, for golden-render
+    comparisons and for measuring what an optimisation costs and saves.
+
+    A render builds a fresh EnvironmentProcessor + NoiseGenerator, waits for
+    the convolver to finish loading, and then feeds the input through in
+    fixed-size blocks.  The same settings always produce the same output,
+    including the seeded noise.
+*/
+class OfflineRenderer
+{
+public:
+    struct Settings
+    {
+        int         presetIndex = 0;
+        double      sampleRate  = 44100.0;
+        int         blockSize   = 512;
+        float       noiseAmount = 0.0f;
+        float       noiseSpeedKmh = 50.0f;
+        juce::int64 noiseSeed   = 1;
+        EnvironmentProcessor::Quality         quality         = EnvironmentProcessor::Quality::normal;
+        EnvironmentProcessor::ConvolutionMode convolutionMode = EnvironmentProcessor::ConvolutionMode::separate;
+        CabinModel::Seat                      seat            = CabinModel::Seat::driver;
+        EnvironmentProcessor::CodecPath       codecPath       = EnvironmentProcessor::CodecPath::off;
+        bool                                  reducedRate     = false;
+        bool                                  highQuality     = false;
+    };
+
+    struct Result
+    {
+        juce::AudioBuffer<float> output;
+        double seconds        = 0.0;   // wall-clock processing time
+        double realtimeFactor = 0.0;   // audio duration / processing time
+        juce::String error;            // set (and output empty) if the chain didn't load in time
+    };
+
+    /** How long prepareChain() waits for the IRs and preset data before giving up. */
+    static constexpr int kLoadTimeoutMs = 30000;
+
+    /**
+        Renders input (at settings.sampleRate) through the chain.  Any chain
+        latency (reduced rate, lookahead) is compensated, so output lines up
+        with input and renders with different settings compare sample-wise.
+    */
+    static Result render (const juce::AudioBuffer<float>& input, const Settings& settings);
+
+    /**
+        Sets env up for settings (preset, modes, rate, numChannels) and returns
+        once its IRs and any preset data have loaded and the crossfade has
+        settled, with the state reset.  Whatever is fed through it afterwards
+        is deterministic.  Used by render() and by streaming analyses.
+
+        Returns false if that took longer than kLoadTimeoutMs: the chain may
+        still be on its plain path then, so its output can't be trusted.
+    */
+    static bool prepareChain (EnvironmentProcessor& env, const Settings& settings, int numChannels);
+
+    //==========================================================================
+    struct Deviation
+    {
+        float maxAbs   = 0.0f;
+        float rms      = 0.0f;
+        float maxAbsDb = -200.0f;
+        float rmsDb    = -200.0f;
+
+        bool within (float maxAbsLimitDb, float rmsLimitDb) const
+        {
+            return maxAbsDb <= maxAbsLimitDb && rmsDb <= rmsLimitDb;
+        }
+    };
+
+    /** Sample-wise difference of test against reference (over their common length). */
+    static Deviation compare (const juce::AudioBuffer<float>& reference,
+                              const juce::AudioBuffer<float>& test);
+
+    //==========================================================================
+    struct InstanceBenchmark
+    {
+        int    numInstances    = 0;
+        size_t hotStateBytes   = 0;     // EnvironmentProcessor::getHotStateBytes()
+        double nsPerSampleOne  = 0.0;   // one chain on its own, its state always cached
+        double nsPerSampleMany = 0.0;   // numInstances chains round-robin, each evicting the others
+        juce::String error;             // set (and nothing timed) if a chain didn't load in time
+    };
+
+    /**
+        What the chain's per-instance footprint costs in a big session.
+        numInstances stereo chains process settings.blockSize blocks
+        round-robin, as a host runs them, and the same total number of
+        blocks is then run through one chain alone.  The difference between
+        the two is the cost of cache misses on per-instance state; run it
+        under `perf stat -e cache-misses,L1-dcache-load-misses` for the raw
+        counts.
+    */
+    static InstanceBenchmark benchmarkInstances (const Settings& settings, int numInstances, double seconds);
+
+    //==========================================================================
+    struct StartupBenchmark
+    {
+        int    numInstances   = 0;
+        double lazyReadyMs    = 0.0;   // made and prepared until every chain is ready, as shipped
+        double eagerReadyMs   = 0.0;   // the same with every preset's data built at prepare()
+        size_t lazyBytes      = 0;     // getMemoryFootprint().total(), summed over the chains
+        size_t eagerBytes     = 0;
+        bool   lazyBuiltData  = false; // a lazy chain started the preset data job after all
+        juce::String error;            // set if a chain didn't load in time
+    };
+
+    /**
+        What building preset data on demand saves when a session loads.
+        numInstances chains are made and prepared in settings' modes until
+        each is ready to play, first as they are, then with every preset's
+        derived data (fused FIRs, eco models, tail partitions) built in
+        prepare(), as it was before that was lazy.  Pick a preset and modes
+        that don't need the data, or there's nothing to save.
+    */
+    static StartupBenchmark benchmarkStartup (const Settings& settings, int numInstances);
+
+    //==========================================================================
+    struct CompressorBenchmark
+    {
+        double nsPerSampleLinked = 0.0;   // LinkedCompressor, on the active DspKernels variant
+        double nsPerSampleJuce   = 0.0;   // juce::dsp::Compressor with the same settings
+    };
+
+    /**
+        What LinkedCompressor costs next to juce::dsp::Compressor.  Both run
+        the Phone's limiter (-10 dB, 10:1, 1 ms attack, 60 ms release, peak
+        detector) with a hard knee, as JUCE's has none, over seconds of loud
+        stereo pink noise in blockSize blocks.  Each is timed on its second
+        pass, so neither pays for a cold cache.
+    */
+    static CompressorBenchmark benchmarkCompressor (double sampleRate, int blockSize, double seconds);
+
+    /**
+        Release check for memory regressions.  Prepares every built-in preset
+        in its default modes at 48 kHz / 512 samples / stereo, waits for its
+        preset data, and compares the chain's footprint with that preset's
+        budget.  report gets each preset's breakdown; false if any is over.
+    */
+    static bool checkMemoryBudgets (juce::String& report);
+
+    //==========================================================================
+    /** Golden renders are stored as 32-bit float WAV files. */
+    static bool writeWav (const juce::AudioBuffer<float>& buffer, double sampleRate, const juce::File& file);
+    static bool readWav  (const juce::File& file, juce::AudioBuffer<float>& dest, double& sampleRate);
+
+    //==========================================================================
+    /** Fixed test signals (stereo). */
+    struct TestSignals
+    {
+        static juce::AudioBuffer<float> impulse   (double sampleRate, double seconds);
+        static juce::AudioBuffer<float> sweep     (double sampleRate, double seconds,
+                                                   float startHz = 20.0f, float endHz = 20000.0f);
+        static juce::AudioBuffer<float> pinkNoise (double sampleRate, double seconds, juce::int64 seed = 1);
+        static juce::AudioBuffer<float> cityNoise (double sampleRate, double seconds, juce::int64 seed = 1);
+    };
+};
@@ -0,0 +1,296 @@
+#include "RateConverter.h"
+#include "MemoryFootprint.h"
+#include <cmath>
+
+//==============================================================================
+int RateConverter::getFactorForBandwidth (double hostRate, float bandwidthHz, int maxFactor)
+{
+    // The halfbands are flat to 0.45 of the lower rate
+    constexpr double kPassbandFraction = 0.45;
+
+    int result = 1;
+
+    while (result * 2 <= juce::jmin (maxFactor, kMaxFactor)
+            && hostRate / (result * 2) * kPassbandFraction >= bandwidthHz)
+        result *= 2;
+
+    return result;
+}
+
+RateConverter::RateConverter()
+{
+    designHalfband();
+}
+
+void RateConverter::designHalfband()
+{
+    // Windowed sinc at a quarter of the higher rate; every other side tap is zero
+    std::array<float, kNumTaps> window {};
+    juce::dsp::WindowingFunction<float>::fillWindowingTables (window.data(), kNumTaps,
+                                                             juce::dsp::WindowingFunction<float>::kaiser,
+                                                             false, 9.5f);
+
+    std::array<double, kNumTaps> h {};
+    double sideSum = 0.0;
+
+    for (int n = 0; n < kNumTaps; ++n)
+    {
+        const int offset = n - kCentre;
+
+        if (offset == 0 || offset % 2 == 0)
+            continue;
+
+        const double x = juce::MathConstants<double>::pi * offset * 0.5;
+        h[static_cast<size_t> (n)] = 0.5 * std::sin (x) / x * window[static_cast<size_t> (n)];
+        sideSum += h[static_cast<size_t> (n)];
+    }
+
+    // Exact 0.5 centre and unity DC gain, so both interpolator phases match
+    for (auto& tap : h)
+        tap *= 0.5 / sideSum;
+
+    h[static_cast<size_t> (kCentre)] = 0.5;
+
+    decimatorTaps.clear();
+    evenTaps.clear();
+    oddTaps.clear();
+
+    for (int n = 0; n < kNumTaps; ++n)
+    {
+        const auto gain = static_cast<float> (h[static_cast<size_t> (n)]);
+
+        if (gain == 0.0f)
+            continue;
+
+        decimatorTaps.push_back ({ n, gain });
+
+        // Zero-stuffed input: even outputs see the even taps, odd outputs the odd ones (x2 for the stuffing)
+        if (n % 2 == 0)
+            evenTaps.push_back ({ n / 2, 2.0f * gain });
+        else
+            oddTaps.push_back ({ (n - 1) / 2, 2.0f * gain });
+    }
+}
+
+//==============================================================================
+void RateConverter::prepare (int numChannels, int maxHostBlockSize, int newFactor)
+{
+    channels     = juce::jmax (1, numChannels);
+    maxHostBlock = juce::jmax (1, maxHostBlockSize);
+    factor       = juce::jlimit (1, kMaxFactor, juce::nextPowerOfTwo (newFactor));
+
+    numStages = 0;
+    while ((1 << numStages) < factor)
+        ++numStages;
+
+    for (auto& stage : stages)
+    {
+        stage.decimatorHistory.setSize    (channels, 2 * kNumTaps);
+        stage.interpolatorHistory.setSize (channels, 2 * kLowTaps);
+    }
+
+    const int capacity = maxHostBlock + factor;
+    inputFifo.setSize  (channels, capacity);
+    outputFifo.setSize (channels, capacity);
+    workA.setSize      (channels, capacity);
+    workB.setSize      (channels, capacity);
+
+    reset();
+}
+
+void RateConverter::reset()
+{
+    for (auto& stage : stages)
+    {
+        stage.decimatorHistory.clear();
+        stage.interpolatorHistory.clear();
+        stage.decimatorPos    = 0;
+        stage.interpolatorPos = 0;
+    }
+
+    inputFifo.clear();
+    outputFifo.clear();
+
+    inputFill  = 0;
+    outputFill = factor - 1;   // zeros, so output can always be returned in full
+}
+
+size_t RateConverter::getMemoryBytes() const
+{
+    size_t total = MemoryFootprint::bytesOf (decimatorTaps) + MemoryFootprint::bytesOf (evenTaps)
+                 + MemoryFootprint::bytesOf (oddTaps)
+                 + MemoryFootprint::bytesOf (inputFifo) + MemoryFootprint::bytesOf (outputFifo)
+                 + MemoryFootprint::bytesOf (workA) + MemoryFootprint::bytesOf (workB);
+
+    for (const auto& stage : stages)
+        total += MemoryFootprint::bytesOf (stage.decimatorHistory) + MemoryFootprint::bytesOf (stage.interpolatorHistory);
+
+    return total;
+}
+
+int RateConverter::getLatencySamples() const
+{
+    // Each stage pair delays by 2 * kCentre - 1 samples at its higher rate
+    // (the kept decimator phase saves one), which sums to (2 * kCentre - 1)
+    // * (factor - 1) host samples; the output FIFO adds factor - 1 more
+    return 2 * kCentre * (factor - 1);
+}
+
+int RateConverter::getMaxInternalBlockSize() const
+{
+    return (maxHostBlock + factor - 1) / factor;
+}
+
+//==============================================================================
+int RateConverter::decimate (Stage& stage, int channel, const float* input, float* output, int numInput) const
+{
+    // Mirrored history: the last kNumTaps samples are always contiguous
+    auto* history = stage.decimatorHistory.getWritePointer (channel);
+    int pos = stage.decimatorPos;
+
+    for (int i = 0; i < numInput; ++i)
+    {
+        history[pos] = history[pos + kNumTaps] = input[i];
+
+        // Only the samples that survive the decimation are computed
+        if ((i & 1) != 0)
+        {
+            const float* newest = history + pos + kNumTaps;
+            float sum = 0.0f;
+
+            for (const auto& tap : decimatorTaps)
+                sum += tap.gain * newest[-tap.offset];
+
+            output[i >> 1] = sum;
+        }
+
+        if (++pos == kNumTaps)
+            pos = 0;
+    }
+
+    return numInput / 2;
+}
+
+void RateConverter::interpolate (Stage& stage, int channel, const float* input, float* output, int numInput) const
+{
+    auto* history = stage.interpolatorHistory.getWritePointer (channel);
+    int pos = stage.interpolatorPos;
+
+    for (int i = 0; i < numInput; ++i)
+    {
+        history[pos] = history[pos + kLowTaps] = input[i];
+        const float* newest = history + pos + kLowTaps;
+
+        float even = 0.0f, odd = 0.0f;
+
+        for (const auto& tap : evenTaps)
+            even += tap.gain * newest[-tap.offset];
+
+        for (const auto& tap : oddTaps)
+            odd += tap.gain * newest[-tap.offset];
+
+        output[2 * i]     = even;
+        output[2 * i + 1] = odd;
+
+        if (++pos == kLowTaps)
+            pos = 0;
+    }
+}
+
+//==============================================================================
+int RateConverter::downsample (const juce::AudioBuffer<float>& host, juce::AudioBuffer<float>& internal)
+{
+    const int numSamples = host.getNumSamples();
+    const int chs        = juce::jmin (channels, host.getNumChannels(), internal.getNumChannels());
+
+    jassert (inputFill + numSamples <= inputFifo.getNumSamples());
+
+    for (int ch = 0; ch < chs; ++ch)
+        inputFifo.copyFrom (ch, inputFill, host, ch, 0, numSamples);
+
+    const int total  = inputFill + numSamples;
+    const int frames = total / factor;
+    const int count  = frames * factor;
+
+    for (int ch = 0; ch < chs; ++ch)
+    {
+        const float* src = inputFifo.getReadPointer (ch);
+        auto* dst = internal.getWritePointer (ch);
+        int length = count;
+
+        if (numStages == 0)
+            std::copy (src, src + count, dst);
+
+        // First stage out of the FIFO, middle stages in place, last into internal
+        for (int s = 0; s < numStages; ++s)
+        {
+            auto* out = (s == numStages - 1) ? dst : workA.getWritePointer (ch);
+            length = decimate (stages[static_cast<size_t> (s)], ch, src, out, length);
+            src = out;
+        }
+
+        // Keep the partial frame for next time
+        auto* fifo = inputFifo.getWritePointer (ch);
+        std::copy (fifo + count, fifo + total, fifo);
+    }
+
+    for (int s = 0; s < numStages; ++s)
+    {
+        auto& stage = stages[static_cast<size_t> (s)];
+        stage.decimatorPos = (stage.decimatorPos + (count >> s)) % kNumTaps;
+    }
+
+    inputFill = total - count;
+    return frames;
+}
+
+void RateConverter::upsample (const juce::AudioBuffer<float>& internal, int numInternal, juce::AudioBuffer<float>& host)
+{
+    const int numSamples = host.getNumSamples();
+    const int chs        = juce::jmin (channels, host.getNumChannels(), internal.getNumChannels());
+    const int produced   = numInternal * factor;
+
+    jassert (outputFill + produced <= outputFifo.getNumSamples());
+
+    for (int ch = 0; ch < chs; ++ch)
+    {
+        const float* src = internal.getReadPointer (ch);
+        int length = numInternal;
+        bool useA  = true;
+
+        if (numStages == 0)
+            std::copy (src, src + numInternal, outputFifo.getWritePointer (ch, outputFill));
+
+        // Last decimation stage is the first to interpolate; ping-pong between the work buffers
+        for (int s = numStages - 1; s >= 0; --s)
+        {
+            auto* out = (s == 0) ? outputFifo.getWritePointer (ch, outputFill)
+                                 : (useA ? workA : workB).getWritePointer (ch);
+
+            interpolate (stages[static_cast<size_t> (s)], ch, src, out, length);
+            length *= 2;
+            src  = out;
+            useA = ! useA;
+        }
+    }
+
+    for (int s = 0; s < numStages; ++s)
+    {
+        auto& stage = stages[static_cast<size_t> (s)];
+        stage.interpolatorPos = (stage.interpolatorPos + (numInternal << (numStages - 1 - s))) % kLowTaps;
+    }
+
+    outputFill += produced;
+    jassert (outputFill >= numSamples);
+
+    for (int ch = 0; ch < chs; ++ch)
+    {
+        auto* fifo = outputFifo.getWritePointer (ch);
+        host.copyFrom (ch, 0, fifo, numSamples);
+
+        // What's left is less than one frame; std::copy is safe for this forward overlap
+        std::copy (fifo + numSamples, fifo + outputFill, fifo);
+    }
+
+    outputFill -= numSamples;
+}
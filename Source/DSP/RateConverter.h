@@ -0,0 +1,87 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+/**
+    Runs part of the chain at a lower internal rate: host rate / factor, where
+    factor is 1, 2, 4 or 8.
+
+    Each factor of two is a linear-phase halfband FIR (127 taps, Kaiser
+    window, ~95 dB stopband, flat to 0.45 of the lower rate), applied in
+    polyphase form: the decimator only computes the samples it keeps, and the
+    interpolator only runs the non-zero taps of each output phase.
+
+    Host blocks needn't be multiples of the factor.  Input is buffered until a
+    whole low-rate frame exists, and the output FIFO starts factor - 1 samples
+    full, so every call returns exactly as many samples as it was given.
+    getLatencySamples() includes that FIFO and the filters' group delay.
+*/
+class RateConverter
+{
+public:
+    static constexpr int kMaxFactor = 8;
+
+    /** Largest factor (up to maxFactor) whose internal rate keeps bandwidthHz within the passband. */
+    static int getFactorForBandwidth (double hostRate, float bandwidthHz, int maxFactor = kMaxFactor);
+
+    RateConverter();
+
+    void prepare (int numChannels, int maxHostBlockSize, int factor);
+    void reset();
+
+    /** Heap bytes of the histories, FIFOs and work buffers. */
+    size_t getMemoryBytes() const;
+
+    int getFactor() const { return factor; }
+
+    /** Host-rate samples of delay through downsample() + upsample(). */
+    int getLatencySamples() const;
+
+    /** Most low-rate samples one downsample() call can produce. */
+    int getMaxInternalBlockSize() const;
+
+    /** Buffers host, decimates every complete frame into internal, returns the low-rate sample count. */
+    int downsample (const juce::AudioBuffer<float>& host, juce::AudioBuffer<float>& internal);
+
+    /** Interpolates numInternal low-rate samples and fills host (same length as given to downsample). */
+    void upsample (const juce::AudioBuffer<float>& internal, int numInternal, juce::AudioBuffer<float>& host);
+
+private:
+    static constexpr int kNumTaps   = 127;                  // 4k + 3: halfband with odd centre
+    static constexpr int kCentre    = (kNumTaps - 1) / 2;
+    static constexpr int kLowTaps   = (kNumTaps + 1) / 2;   // low-rate history the interpolator needs
+
+    struct Tap
+    {
+        int   offset;
+        float gain;
+    };
+
+    /** One factor-of-two stage: decimator history at the higher rate, interpolator history at the lower. */
+    struct Stage
+    {
+        juce::AudioBuffer<float> decimatorHistory, interpolatorHistory;
+        int decimatorPos    = 0;
+        int interpolatorPos = 0;
+    };
+
+    void designHalfband();
+    int  decimate    (Stage& stage, int channel, const float* input, float* output, int numInput) const;
+    void interpolate (Stage& stage, int channel, const float* input, float* output, int numInput) const;
+
+    int factor    = 1;
+    int numStages = 0;
+    int channels  = 2;
+    int maxHostBlock = 512;
+
+    // Non-zero taps: decimator (all phases), interpolator even / odd output phase
+    std::vector<Tap> decimatorTaps, evenTaps, oddTaps;
+
+    std::array<Stage, 3> stages;
+
+    juce::AudioBuffer<float> inputFifo, outputFifo, workA, workB;
+    int inputFill  = 0;
+    int outputFill = 0;
+};
@@ -0,0 +1,128 @@
+#include "SpeakerDriver.h"
+#include "MemoryFootprint.h"
+#include <cmath>
+
+//==============================================================================
+void SpeakerDriver::prepare (double sr, int maximumBlockSize, int numChannels)
+{
+    sampleRate   = sr;
+    maxBlockSize = juce::jmax (1, maximumBlockSize);
+    channels     = juce::jmax (1, numChannels);
+
+    excursion.setSize (channels, maxBlockSize);
+    upsampledBand.setSize (channels, 2 * maxBlockSize);
+
+    // Polyphase IIR half-bands: a few samples of delay, which only the
+    // distortion residual sees, so nothing needs compensating
+    oversampler = std::make_unique<juce::dsp::Oversampling<float>> (
+        static_cast<size_t> (channels), 1, juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, true, false);
+    oversampler->initProcessing (static_cast<size_t> (maxBlockSize));
+    splitStates.assign   (static_cast<size_t> (channels), {});
+    dcBlockStates.assign (static_cast<size_t> (channels), {});
+
+    // One-pole DC blocker at 10 Hz, as a biquad so it runs in the same kernel
+    const float r = std::exp (-juce::MathConstants<float>::twoPi * 10.0f / static_cast<float> (sampleRate));
+    dcBlockCoefs  = { (1.0f + r) * 0.5f, -(1.0f + r) * 0.5f, 0.0f, -r, 0.0f };
+
+    setSettings (settings);
+    reset();
+}
+
+void SpeakerDriver::reset()
+{
+    std::fill (splitStates.begin(), splitStates.end(), DspKernels::BiquadState {});
+    std::fill (dcBlockStates.begin(), dcBlockStates.end(), DspKernels::BiquadState {});
+
+    if (oversampler != nullptr)
+        oversampler->reset();
+}
+
+size_t SpeakerDriver::getMemoryBytes() const
+{
+    // The oversampler's own up-sampled block is the same size as upsampledBand
+    return MemoryFootprint::bytesOf (excursion) + 2 * MemoryFootprint::bytesOf (upsampledBand)
+         + MemoryFootprint::bytesOf (splitStates) + MemoryFootprint::bytesOf (dcBlockStates);
+}
+
+void SpeakerDriver::setSettings (const Settings& newSettings)
+{
+    settings = newSettings;
+
+    // Butterworth low-pass at the resonance (the RBJ form, as EnvironmentProcessor's)
+    const double freq = juce::jlimit (10.0, sampleRate * 0.45, static_cast<double> (settings.resonanceHz));
+    const double n    = 1.0 / std::tan (juce::MathConstants<double>::pi * freq / sampleRate);
+    const double n2   = n * n;
+    const double c1   = 1.0 / (1.0 + juce::MathConstants<double>::sqrt2 * n + n2);
+
+    splitCoefs = { static_cast<float> (c1), static_cast<float> (2.0 * c1), static_cast<float> (c1),
+                   static_cast<float> (c1 * 2.0 * (1.0 - n2)),
+                   static_cast<float> (c1 * (1.0 - juce::MathConstants<double>::sqrt2 * n + n2)) };
+
+    // The curve is in units of the limit, so the level only scales in and out of it
+    const float limitGain = juce::Decibels::decibelsToGain (settings.limitDb);
+    inputScale  = 1.0f / (limitGain * kTableRange);
+    outputScale = limitGain;
+
+    const float asymmetry = juce::jlimit (0.0f, 0.5f, settings.asymmetry);
+    if (asymmetry != tableAsymmetry)
+        buildTable (asymmetry);
+}
+
+void SpeakerDriver::buildTable (float asymmetry)
+{
+    // Unit slope through zero, saturating at 1 / (1 + a) outwards and 1 / (1 - a) inwards,
+    // so a loud band comes out both compressed and lopsided (even as well as odd harmonics)
+    for (int i = 0; i <= kTableSize; ++i)
+    {
+        const float u = (2.0f * static_cast<float> (i) / static_cast<float> (kTableSize) - 1.0f) * kTableRange;
+        const float k = u >= 0.0f ? 1.0f + asymmetry : 1.0f - asymmetry;
+
+        table[static_cast<size_t> (i)] = std::tanh (u * k) / k;
+    }
+
+    table[static_cast<size_t> (kTableSize + 1)] = table[static_cast<size_t> (kTableSize)];
+    tableAsymmetry = asymmetry;
+}
+
+//==============================================================================
+void SpeakerDriver::process (juce::AudioBuffer<float>& buffer)
+{
+    const int numSamples = buffer.getNumSamples();
+
+    for (int start = 0; start < numSamples; start += maxBlockSize)
+        processChunk (buffer, start, juce::jmin (maxBlockSize, numSamples - start));
+}
+
+void SpeakerDriver::processChunk (juce::AudioBuffer<float>& buffer, int start, int n)
+{
+    const int chs       = juce::jmin (buffer.getNumChannels(), channels);
+    const auto& kernels = DspKernels::get();
+
+    // ---- 1. Split off the excursion band ----
+    for (int ch = 0; ch < chs; ++ch)
+        excursion.copyFrom (ch, 0, buffer, ch, start, n);
+
+    kernels.biquadCascade (excursion.getArrayOfWritePointers(), chs, n, &splitCoefs, 1, splitStates.data());
+
+    // ---- 2. Stiffening suspension at twice the rate, keeping only what it adds ----
+    auto band = juce::dsp::AudioBlock<float> (excursion).getSubsetChannelBlock (0, static_cast<size_t> (chs))
+                                                        .getSubBlock (0, static_cast<size_t> (n));
+    auto up         = oversampler->processSamplesUp (band);
+    const int upLen = static_cast<int> (up.getNumSamples());
+
+    for (int ch = 0; ch < chs; ++ch)
+    {
+        auto* shaped = up.getChannelPointer (static_cast<size_t> (ch));
+        upsampledBand.copyFrom (ch, 0, shaped, upLen);
+        kernels.tableShaper (shaped, upLen, table.data(), kTableSize, inputScale, outputScale);
+        kernels.addScaled (shaped, upsampledBand.getReadPointer (ch), -1.0f, upLen);
+    }
+
+    oversampler->processSamplesDown (band);
+
+    // ---- 3. Drop the DC offset the asymmetry leaves, and add the distortion to the signal ----
+    kernels.biquadCascade (excursion.getArrayOfWritePointers(), chs, n, &dcBlockCoefs, 1, dcBlockStates.data());
+
+    for (int ch = 0; ch < chs; ++ch)
+        kernels.addScaled (buffer.getWritePointer (ch, start), excursion.getReadPointer (ch), 1.0f, n);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+#include "DspKernels.h"
+#include <array>
+
+//==============================================================================
+/**
+    Large-signal behaviour of a small loudspeaker driver: the suspension
+    stiffens as the cone nears its excursion limit, so bass flattens out and
+    distorts at volume while the top end stays clean.
+
+    Below its resonance a sealed driver's excursion follows the drive, and
+    above it falls at 12 dB/octave, so the signal is split with a 2-pole
+    low-pass at the resonance.  Only that excursion band goes through the
+    nonlinearity: a precomputed, linearly interpolated stiffening curve
+    (DspKernels::tableShaper, vectorised) that is unity for small signals
+    and saturates, asymmetrically, towards the limit.  The rest of the
+    signal is added back untouched, so quiet material passes through
+    unchanged and louder material loses bass progressively.
+
+    The excursion band is only 12 dB/octave down above the resonance, and
+    at the reduced internal rates (the phone runs at a quarter of 48 kHz)
+    the curve's upper harmonics would fold back, so the curve runs 2x
+    oversampled through a polyphase IIR half-band pair.  Only what the
+    curve adds, shaped minus unshaped, goes through the resamplers: the
+    linear part of the signal never leaves the base rate, so quiet material
+    is still bit-exact and the stage adds no latency.  The residual carries
+    the half-band pair's few samples of group delay, which on a distortion
+    product is inaudible.
+*/
+class SpeakerDriver
+{
+public:
+    struct Settings
+    {
+        float resonanceHz = 800.0f;   // top of the excursion band
+        float limitDb     = 0.0f;     // excursion-band level (dBFS) that drives the cone to its limit
+        float asymmetry   = 0.0f;     // 0 - 0.5: outward travel stiffens sooner than inward
+    };
+
+    void prepare (double sampleRate, int maximumBlockSize, int numChannels);
+    void reset();
+
+    /** Heap bytes of the excursion band buffers (base and oversampled) and filter states. */
+    size_t getMemoryBytes() const;
+
+    /** Allocation-free; only a change of asymmetry recomputes the curve. */
+    void setSettings (const Settings& newSettings);
+
+    void process (juce::AudioBuffer<float>& buffer);
+
+    // The curve spans +-kTableRange times the limit, in kTableSize steps
+    static constexpr int   kTableSize  = 256;
+    static constexpr float kTableRange = 4.0f;
+
+private:
+    void processChunk (juce::AudioBuffer<float>& buffer, int start, int numSamples);
+    void buildTable (float asymmetry);
+
+    Settings settings;
+    double sampleRate = 44100.0;
+    int maxBlockSize  = 512;
+    int channels      = 2;
+
+    // Excursion band split, and the DC its asymmetric distortion leaves behind
+    DspKernels::BiquadCoefficients splitCoefs, dcBlockCoefs;
+    std::vector<DspKernels::BiquadState> splitStates, dcBlockStates;
+
+    // kTableSize + 1 points, plus a copy of the last for the interpolation at the top
+    std::array<float, kTableSize + 2> table {};
+    float tableAsymmetry = -1.0f;
+    float inputScale     = 1.0f;
+    float outputScale    = 1.0f;
+
+    // The excursion band, then what the curve adds to it; the oversampled
+    // band is kept unshaped in upsampledBand to subtract
+    juce::AudioBuffer<float> excursion, upsampledBand;
+    std::unique_ptr<juce::dsp::Oversampling<float>> oversampler;
+};
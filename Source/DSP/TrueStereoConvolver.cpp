@@ -0,0 +1,208 @@
+#include "TrueStereoConvolver.h"
+#include "MemoryFootprint.h"
+#include <cmath>
+
+//==============================================================================
+TrueStereoConvolver::IR TrueStereoConvolver::makeIR (const juce::AudioBuffer<float>& source, int partitionSize)
+{
+    IR result;
+
+    if (source.getNumChannels() != kNumPaths || source.getNumSamples() == 0 || ! juce::isPowerOfTwo (partitionSize))
+        return result;
+
+    result.partitionSize = partitionSize;
+    result.numPartitions = (source.getNumSamples() + partitionSize - 1) / partitionSize;
+
+    const int fftSize = 2 * partitionSize;
+    const int numBins = partitionSize + 1;
+    juce::dsp::FFT transform (juce::roundToInt (std::log2 (fftSize)));
+    std::vector<float> work (static_cast<size_t> (fftSize * 2));
+
+    for (int path = 0; path < kNumPaths; ++path)
+    {
+        const auto* src = source.getReadPointer (path);
+        auto& parts = result.partitions[static_cast<size_t> (path)];
+        parts.resize (static_cast<size_t> (result.numPartitions));
+
+        for (int k = 0; k < result.numPartitions; ++k)
+        {
+            const int start = k * partitionSize;
+            const int count = juce::jmin (partitionSize, source.getNumSamples() - start);
+
+            // Partition in the first half, zeros in the second (overlap-add)
+            std::fill (work.begin(), work.end(), 0.0f);
+            std::copy (src + start, src + start + count, work.begin());
+            transform.performRealOnlyForwardTransform (work.data(), true);
+
+            const auto* bins = reinterpret_cast<const std::complex<float>*> (work.data());
+            parts[static_cast<size_t> (k)].assign (bins, bins + numBins);
+        }
+    }
+
+    return result;
+}
+
+int TrueStereoConvolver::getPartitionSizeForBlockSize (int maximumBlockSize)
+{
+    return juce::jlimit (64, 2048, juce::nextPowerOfTwo (juce::jmax (1, maximumBlockSize)));
+}
+
+//==============================================================================
+void TrueStereoConvolver::prepare (int partitionSize, int maxPartitions)
+{
+    jassert (juce::isPowerOfTwo (partitionSize));
+
+    blockSize = partitionSize;
+    fftSize   = 2 * partitionSize;
+    numBins   = partitionSize + 1;
+    maxParts  = juce::jmax (1, maxPartitions);
+
+    fft = std::make_unique<juce::dsp::FFT> (juce::roundToInt (std::log2 (fftSize)));
+    fftBuffer.assign (static_cast<size_t> (fftSize * 2), 0.0f);
+
+    for (size_t ch = 0; ch < 2; ++ch)
+    {
+        inputData[ch].assign (static_cast<size_t> (fftSize), 0.0f);
+        inputSegments[ch].assign (static_cast<size_t> (maxParts), Spectrum (static_cast<size_t> (numBins)));
+        accumulatedOlder[ch].assign (static_cast<size_t> (numBins), {});
+        overlapData[ch].assign (static_cast<size_t> (blockSize), 0.0f);
+    }
+
+    reset();
+}
+
+void TrueStereoConvolver::reset()
+{
+    for (size_t ch = 0; ch < 2; ++ch)
+    {
+        std::fill (inputData[ch].begin(), inputData[ch].end(), 0.0f);
+        std::fill (accumulatedOlder[ch].begin(), accumulatedOlder[ch].end(), std::complex<float>());
+        std::fill (overlapData[ch].begin(), overlapData[ch].end(), 0.0f);
+
+        for (auto& spectrum : inputSegments[ch])
+            std::fill (spectrum.begin(), spectrum.end(), std::complex<float>());
+    }
+
+    inputDataPos   = 0;
+    currentSegment = 0;
+}
+
+size_t TrueStereoConvolver::getMemoryBytes() const
+{
+    return MemoryFootprint::bytesOf (inputData) + MemoryFootprint::bytesOf (inputSegments)
+         + MemoryFootprint::bytesOf (accumulatedOlder) + MemoryFootprint::bytesOf (overlapData)
+         + MemoryFootprint::bytesOf (fftBuffer);
+}
+
+void TrueStereoConvolver::setIR (const IR* newIR)
+{
+    if (newIR != nullptr
+         && (newIR->numPartitions == 0 || newIR->partitionSize != blockSize || newIR->numPartitions > maxParts))
+        newIR = nullptr;
+
+    reset();
+    ir = newIR;
+}
+
+//==============================================================================
+void TrueStereoConvolver::process (juce::AudioBuffer<float>& buffer)
+{
+    if (ir == nullptr || buffer.getNumChannels() < 2)
+        return;
+
+    const int numSamples = buffer.getNumSamples();
+    int pos = 0;
+
+    while (pos < numSamples)
+    {
+        const int n = juce::jmin (numSamples - pos, blockSize - inputDataPos);
+        float* channels[2] = { buffer.getWritePointer (0, pos), buffer.getWritePointer (1, pos) };
+
+        processSegment (channels, channels, n);
+        pos += n;
+    }
+}
+
+void TrueStereoConvolver::processSegment (const float* const* input, float* const* output, int numSamples)
+{
+    const bool newSegment = inputDataPos == 0;
+    auto* bins = reinterpret_cast<std::complex<float>*> (fftBuffer.data());
+    const auto current = static_cast<size_t> (currentSegment);
+
+    // ---- 1. One forward transform per input channel ----
+    for (size_t in = 0; in < 2; ++in)
+    {
+        std::copy (input[in], input[in] + numSamples, inputData[in].begin() + inputDataPos);
+
+        std::fill (fftBuffer.begin(), fftBuffer.end(), 0.0f);
+        std::copy (inputData[in].begin(), inputData[in].end(), fftBuffer.begin());
+        fft->performRealOnlyForwardTransform (fftBuffer.data(), true);
+
+        std::copy (bins, bins + numBins, inputSegments[in][current].begin());
+    }
+
+    // ---- 2. Older partitions: once per segment, accumulated per output ----
+    if (newSegment)
+    {
+        for (size_t out = 0; out < 2; ++out)
+        {
+            auto& acc = accumulatedOlder[out];
+            std::fill (acc.begin(), acc.end(), std::complex<float>());
+
+            for (int k = 1; k < ir->numPartitions; ++k)
+            {
+                const auto slot = static_cast<size_t> ((currentSegment + k) % maxParts);
+
+                for (size_t in = 0; in < 2; ++in)
+                {
+                    const auto& x = inputSegments[in][slot];
+                    const auto& h = ir->partitions[in * 2 + out][static_cast<size_t> (k)];
+
+                    for (size_t b = 0; b < static_cast<size_t> (numBins); ++b)
+                        acc[b] += x[b] * h[b];
+                }
+            }
+        }
+    }
+
+    // ---- 3. Newest partition, then one inverse transform per output ----
+    const bool segmentComplete = inputDataPos + numSamples == blockSize;
+
+    for (size_t out = 0; out < 2; ++out)
+    {
+        std::fill (fftBuffer.begin(), fftBuffer.end(), 0.0f);
+        std::copy (accumulatedOlder[out].begin(), accumulatedOlder[out].end(), bins);
+
+        for (size_t in = 0; in < 2; ++in)
+        {
+            const auto& x = inputSegments[in][current];
+            const auto& h = ir->partitions[in * 2 + out][0];
+
+            for (size_t b = 0; b < static_cast<size_t> (numBins); ++b)
+                bins[b] += x[b] * h[b];
+        }
+
+        fft->performRealOnlyInverseTransform (fftBuffer.data());
+
+        const auto* result  = fftBuffer.data() + inputDataPos;
+        const auto* overlap = overlapData[out].data() + inputDataPos;
+
+        for (int i = 0; i < numSamples; ++i)
+            output[out][i] = result[i] + overlap[i];
+
+        if (segmentComplete)
+            std::copy (fftBuffer.begin() + blockSize, fftBuffer.begin() + fftSize, overlapData[out].begin());
+    }
+
+    inputDataPos += numSamples;
+
+    if (segmentComplete)
+    {
+        // Newest spectrum moves down the history; the next segment starts empty
+        for (auto& data : inputData)
+            std::fill (data.begin(), data.end(), 0.0f);
+
+        inputDataPos   = 0;
+        currentSegment = currentSegment > 0 ? currentSegment - 1 : maxParts - 1;
+    }
+}
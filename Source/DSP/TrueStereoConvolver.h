@@ -0,0 +1,86 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <complex>
+
+//==============================================================================
+/**
+    Zero-latency, uniformly partitioned true-stereo (2 in x 2 out) convolution.
+
+    A true-stereo IR has four paths, stored as a 4-channel buffer in the order
+    of ImpulseResponse::TrueStereoPath (LL, LR, RL, RR: input -> output).
+    Each input channel is forward-transformed once per call and that spectrum
+    feeds both output paths; products are accumulated in the frequency domain
+    so there is one inverse transform per output.  Four IRs therefore cost the
+    same FFTs as a plain stereo convolution, plus the extra multiply-adds.
+
+    Partitions older than the current one are accumulated once per partition
+    (when the input segment rolls over); only the newest is redone per call,
+    the same scheme juce::dsp::Convolution uses for its zero-latency head.
+*/
+class TrueStereoConvolver
+{
+public:
+    static constexpr int kNumPaths = 4;
+
+    TrueStereoConvolver() = default;
+
+    /** Frequency-domain partitions of one true-stereo IR, built off the audio thread. */
+    struct IR
+    {
+        int partitionSize = 0;
+        int numPartitions = 0;
+        // [path][partition] -> partitionSize + 1 bins
+        std::array<std::vector<std::vector<std::complex<float>>>, kNumPaths> partitions;
+    };
+
+    /**
+        Partitions and transforms a 4-channel IR (see ImpulseResponse::makeTrueStereo).
+        Empty if ir doesn't have four channels.
+    */
+    static IR makeIR (const juce::AudioBuffer<float>& ir, int partitionSize);
+
+    /** Partition size suited to a host block size: the next power of two, within [64, 2048]. */
+    static int getPartitionSizeForBlockSize (int maximumBlockSize);
+
+    /** Allocates for IRs of up to maxPartitions partitions of partitionSize. */
+    void prepare (int partitionSize, int maxPartitions);
+    void reset();
+
+    /** Heap bytes of the prepared buffers; IRs belong to whoever made them. */
+    size_t getMemoryBytes() const;
+
+    /** Swaps in an IR prepared by makeIR with the prepared partition size (nullptr = none).  No allocation. */
+    void setIR (const IR* newIR);
+    bool isActive() const { return ir != nullptr; }
+
+    /** Replaces the first two channels of buffer with the fully wet true-stereo output. */
+    void process (juce::AudioBuffer<float>& buffer);
+
+private:
+    using Spectrum = std::vector<std::complex<float>>;
+
+    void processSegment (const float* const* input, float* const* output, int numSamples);
+
+    std::unique_ptr<juce::dsp::FFT> fft;
+    const IR* ir = nullptr;
+
+    int blockSize = 0;
+    int fftSize   = 0;
+    int numBins   = 0;
+    int maxParts  = 0;
+
+    // Input segment [block | zeros] per input channel, and its spectrum history
+    std::array<std::vector<float>, 2> inputData;
+    std::array<std::vector<Spectrum>, 2> inputSegments;
+    int inputDataPos   = 0;
+    int currentSegment = 0;
+
+    // Per output: older partitions summed once per segment, and the overlap-add tail
+    std::array<Spectrum, 2> accumulatedOlder;
+    std::array<std::vector<float>, 2> overlapData;
+    std::vector<float> fftBuffer;
+
+    JUCE_DECLARE_NON_COPYABLE (TrueStereoConvolver)
+};
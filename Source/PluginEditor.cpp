@@ -1,5 +1,4 @@
 #include "PluginEditor.h"
-#include "BinaryData.h"
 
 //==============================================================================
 //  DashboardLookAndFeel — physical car-button appearance
@@ -204,8 +203,8 @@ static void drawDashPanel (juce::Graphics& g, juce::Rectangle<float> bounds, flo
 CarTestAudioProcessorEditor::CarTestAudioProcessorEditor (CarTestAudioProcessor& p)
     : AudioProcessorEditor (&p), processorRef (p)
 {
-    // Load dashboard background from binary data
-    dashboardBg = juce::ImageCache::getFromMemory (BinaryData::Dashboard_png, BinaryData::Dashboard_pngSize);
+    // Dashboard background (decoded once per process, shared between editors)
+    dashboardBg = processorRef.getDashboardImage();
 
     // Collect preset buttons
     presetButtons = { &bypassButton, &sedanButton, &phoneButton, &laptopButton, &btButton };
@@ -231,11 +230,55 @@ CarTestAudioProcessorEditor::CarTestAudioProcessorEditor (CarTestAudioProcessor&
     noiseLabel.setColour (juce::Label::textColourId, DashColours::textBright);
     noiseLabel.setFont (juce::FontOptions (10.0f, juce::Font::bold));
 
-    // --- APVTS Attachment ---
+    // --- Loudness readout + match toggle ---
+    addAndMakeVisible (loudnessLabel);
+    loudnessLabel.setJustificationType (juce::Justification::centred);
+    loudnessLabel.setColour (juce::Label::textColourId, DashColours::textDim);
+    loudnessLabel.setFont (juce::FontOptions (9.0f, juce::Font::bold));
+
+    addAndMakeVisible (matchButton);
+    matchButton.setClickingTogglesState (true);
+    matchButton.setWantsKeyboardFocus (false);
+    matchButton.setLookAndFeel (&dashboardLnF);
+
+    addAndMakeVisible (recordButton);
+    recordButton.setClickingTogglesState (false);
+    recordButton.setWantsKeyboardFocus (false);
+    recordButton.setLookAndFeel (&dashboardLnF);
+    recordButton.onClick = [this] { toggleCapture(); };
+
+    addAndMakeVisible (analyseButton);
+    analyseButton.setWantsKeyboardFocus (false);
+    analyseButton.setLookAndFeel (&dashboardLnF);
+    analyseButton.onClick = [this] { chooseFileToAnalyse(); };
+
+    addAndMakeVisible (irButton);
+    irButton.setClickingTogglesState (false);
+    irButton.setWantsKeyboardFocus (false);
+    irButton.setLookAndFeel (&dashboardLnF);
+    irButton.onClick = [this] { chooseUserIR(); };
+
+    addAndMakeVisible (referenceButton);
+    referenceButton.setClickingTogglesState (false);
+    referenceButton.setWantsKeyboardFocus (false);
+    referenceButton.setLookAndFeel (&dashboardLnF);
+    referenceButton.onClick = [this] { toggleReference(); };
+
+    // --- APVTS Attachments ---
     noiseAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment> (
                           processorRef.getAPVTS(), "noiseAmount", noiseSlider);
-
-    // Timer to keep button highlighting in sync with automation
+    matchAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment> (
+                          processorRef.getAPVTS(), "loudnessMatch", matchButton);
+
+   #if JUCE_DEBUG
+    addAndMakeVisible (memoryOverlay);
+    memoryOverlay.setJustificationType (juce::Justification::topLeft);
+    memoryOverlay.setColour (juce::Label::textColourId, DashColours::textDim);
+    memoryOverlay.setFont (juce::FontOptions (9.0f));
+    memoryOverlay.setInterceptsMouseClicks (false, false);
+   #endif
+
+    // Timer to keep button highlighting and the loudness readout in sync
     startTimerHz (15);
 
     updateButtonStates();
@@ -251,8 +294,17 @@ CarTestAudioProcessorEditor::~CarTestAudioProcessorEditor()
 {
     stopTimer();
 
+    // Every pass checks between blocks, so a running analysis stops within one
+    if (analysisThread != nullptr)
+        analysisThread->stopThread (-1);
+
     for (auto* btn : presetButtons)
         btn->setLookAndFeel (nullptr);
+    matchButton.setLookAndFeel (nullptr);
+    recordButton.setLookAndFeel (nullptr);
+    analyseButton.setLookAndFeel (nullptr);
+    irButton.setLookAndFeel (nullptr);
+    referenceButton.setLookAndFeel (nullptr);
     noiseSlider.setLookAndFeel (nullptr);
 }
 
@@ -372,6 +424,18 @@ void CarTestAudioProcessorEditor::resized()
     // ---- BYPASS: bottom-left, near steering column ----
     bypassButton.setBounds (scaled (22.0f, 324.0f, 84.0f, 34.0f));
 
+    // ---- MATCH: beside BYPASS, loudness readout under the head unit ----
+    matchButton.setBounds   (scaled (118.0f, 324.0f, 64.0f, 34.0f));
+    recordButton.setBounds  (scaled (188.0f, 324.0f, 72.0f, 34.0f));
+    analyseButton.setBounds (scaled (266.0f, 324.0f, 84.0f, 34.0f));
+    irButton.setBounds      (scaled (356.0f, 324.0f, 48.0f, 34.0f));
+    referenceButton.setBounds (scaled (410.0f, 324.0f, 64.0f, 34.0f));
+    loudnessLabel.setBounds (scaled (240.0f, 190.0f, 170.0f, 14.0f));
+
+   #if JUCE_DEBUG
+    memoryOverlay.setBounds (scaled (6.0f, 6.0f, 160.0f, 80.0f));
+   #endif
+
     // ---- PHONE / LAPTOP / BT SPEAKER: passenger side dash, horizontal row ----
     const float passBtnW = 60.0f;
     const float passBtnH = 36.0f;
@@ -404,6 +468,312 @@ void CarTestAudioProcessorEditor::timerCallback()
         currentPreset = idx;
         updateButtonStates();
     }
+
+    updateLoudnessReadout();
+    updateCaptureButton();
+    updateReferenceButton();
+
+   #if JUCE_DEBUG
+    if (--memoryOverlayCountdown <= 0)
+    {
+        memoryOverlayCountdown = 15;
+        updateMemoryOverlay();
+    }
+   #endif
+}
+
+#if JUCE_DEBUG
+void CarTestAudioProcessorEditor::updateMemoryOverlay()
+{
+    memoryOverlay.setText (processorRef.getMemoryFootprint().toString(), juce::dontSendNotification);
+}
+#endif
+
+void CarTestAudioProcessorEditor::updateLoudnessReadout()
+{
+    const auto r = processorRef.getLoudnessReadings();
+
+    auto format = [] (float lufs)
+    {
+        return lufs > LoudnessMeter::kSilenceLufs ? juce::String (lufs, 1) : juce::String ("--");
+    };
+
+    juce::String text = "IN " + format (r.inputShortTermLufs) + "  OUT " + format (r.outputShortTermLufs) + " LUFS";
+
+    if (r.matchGainDb != 0.0f)
+        text << "  (" << (r.matchGainDb > 0.0f ? "+" : "") << juce::String (r.matchGainDb, 1) << " dB)";
+
+    loudnessLabel.setText (text, juce::dontSendNotification);
+}
+
+void CarTestAudioProcessorEditor::toggleCapture()
+{
+    auto& capture = processorRef.getCaptureRecorder();
+
+    if (capture.isRecording())
+    {
+        capture.stop();
+    }
+    else
+    {
+        const auto name = "Car Test " + processorRef.getPresetNames()[currentPreset] + " "
+                        + juce::Time::getCurrentTime().formatted ("%Y-%m-%d %H-%M-%S") + ".wav";
+        const auto file = juce::File::getSpecialLocation (juce::File::userMusicDirectory)
+                              .getChildFile ("Car Test Captures").getChildFile (name);
+
+        const auto result = capture.start (file, CaptureRecorder::Format::wav);
+
+        if (result.failed())
+            juce::AlertWindow::showMessageBoxAsync (juce::MessageBoxIconType::WarningIcon,
+                                                    "Capture", result.getErrorMessage());
+    }
+
+    updateCaptureButton();
+}
+
+void CarTestAudioProcessorEditor::updateCaptureButton()
+{
+    const auto& capture = processorRef.getCaptureRecorder();
+    const bool recording = capture.isRecording();
+    juce::String text ("REC");
+
+    if (recording)
+    {
+        const auto stats   = capture.getStats();
+        const int  seconds = static_cast<int> (stats.seconds);
+        text << " " << seconds / 60 << ":" << juce::String (seconds % 60).paddedLeft ('0', 2);
+
+        // Dropped blocks mean the disk fell more than the ring's length behind
+        if (stats.overruns > 0)
+            text << " !";
+    }
+
+    recordButton.setToggleState (recording, juce::dontSendNotification);
+    recordButton.setButtonText (text);
+}
+
+void CarTestAudioProcessorEditor::chooseFileToAnalyse()
+{
+    analyseChooser = std::make_unique<juce::FileChooser> ("Analyse mix translation",
+                                                          juce::File::getSpecialLocation (juce::File::userMusicDirectory),
+                                                          "*.wav;*.aif;*.aiff;*.flac;*.ogg");
+
+    const auto flags = juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles;
+
+    analyseChooser->launchAsync (flags, [this] (const juce::FileChooser& chooser)
+    {
+        const auto file = chooser.getResult();
+
+        if (file == juce::File())
+            return;
+
+        analyseButton.setEnabled (false);
+        analyseButton.setButtonText ("ANALYSING");
+
+        // The last analysis has posted its result by now, but may not quite have returned
+        if (analysisThread != nullptr)
+            analysisThread->stopThread (-1);
+
+        analysisThread = std::make_unique<AnalysisThread> (*this, file);
+        analysisThread->startThread();
+    });
+}
+
+//==============================================================================
+CarTestAudioProcessorEditor::AnalysisThread::AnalysisThread (CarTestAudioProcessorEditor& e, const juce::File& f)
+    : juce::Thread ("Car Test analysis"), editor (&e), file (f)
+{
+}
+
+void CarTestAudioProcessorEditor::AnalysisThread::run()
+{
+    MixAnalyser::Options options;
+    options.shouldExit = [this] { return threadShouldExit(); };
+
+    const auto result = MixAnalyser::analyse (file, options);
+
+    // The editor is closing and waiting for us: nothing to report to
+    if (threadShouldExit())
+        return;
+
+    // Nothing worth saving or copying: just say what went wrong
+    if (result.error.isNotEmpty())
+    {
+        juce::MessageManager::callAsync ([safeEditor = editor, error = result.error]
+        {
+            if (safeEditor != nullptr)
+            {
+                safeEditor->analyseButton.setEnabled (true);
+                safeEditor->analyseButton.setButtonText ("ANALYSE");
+            }
+
+            juce::AlertWindow::showMessageBoxAsync (juce::MessageBoxIconType::WarningIcon, "Mix translation", error);
+        });
+
+        return;
+    }
+
+    const auto report     = result.toString();
+    const auto reportFile = file.getSiblingFile (file.getFileNameWithoutExtension() + " - Car Test report.txt");
+    const bool saved      = reportFile.replaceWithText (report);
+
+    juce::MessageManager::callAsync ([safeEditor = editor, report, reportFile, saved]
+    {
+        juce::SystemClipboard::copyTextToClipboard (report);
+
+        if (safeEditor != nullptr)
+        {
+            safeEditor->analyseButton.setEnabled (true);
+            safeEditor->analyseButton.setButtonText ("ANALYSE");
+        }
+
+        juce::AlertWindow::showMessageBoxAsync (juce::MessageBoxIconType::InfoIcon, "Mix translation",
+                                                (saved ? "Report saved to " + reportFile.getFullPathName() + " and copied"
+                                                       : juce::String ("Report copied"))
+                                                    + " to the clipboard.");
+    });
+}
+
+void CarTestAudioProcessorEditor::chooseUserIR()
+{
+    enum { rescanId = 1, builtInId, firstEntryId };
+
+    auto& library = processorRef.getIRLibrary();
+    const auto current = processorRef.getUserIR (currentPreset);
+
+    juce::PopupMenu menu;
+    menu.addItem (builtInId, "Built-in", true, current.isEmpty());
+    menu.addSeparator();
+
+    // Names and formats come from the catalogue; nothing is mapped until one is picked
+    for (int i = 0; i < library.getNumEntries(); ++i)
+    {
+        const auto entry = library.getEntry (i);
+        const auto info  = juce::String (entry.sampleRate / 1000.0, 1) + " kHz, "
+                         + juce::String (static_cast<double> (entry.lengthInSamples) / entry.sampleRate, 2) + " s";
+
+        menu.addItem (juce::PopupMenu::Item (entry.name).setID (firstEntryId + i)
+                                                        .setTicked (entry.name == current)
+                                                        .setShortcutKeyDescription (info));
+    }
+
+    if (library.getNumEntries() == 0)
+        menu.addItem (juce::PopupMenu::Item ("No IRs in " + IRLibrary::getDefaultDirectory().getFullPathName())
+                          .setEnabled (false));
+
+    menu.addSeparator();
+    menu.addItem (rescanId, "Rescan Library");
+
+    juce::Component::SafePointer<CarTestAudioProcessorEditor> safeThis (this);
+
+    menu.showMenuAsync (juce::PopupMenu::Options().withTargetComponent (irButton),
+                        [safeThis, preset = currentPreset] (int result)
+    {
+        if (safeThis == nullptr || result == 0)
+            return;
+
+        auto& processor = safeThis->processorRef;
+
+        if (result == rescanId)
+            processor.getIRLibrary().scan (IRLibrary::getDefaultDirectory());
+        else if (result == builtInId)
+            processor.setUserIR (preset, {});
+        else
+            processor.setUserIR (preset, processor.getIRLibrary().getEntry (result - firstEntryId).name);
+
+        safeThis->updateButtonStates();
+    });
+}
+
+void CarTestAudioProcessorEditor::toggleReference()
+{
+    auto& player = processorRef.getReferencePlayer();
+
+    if (player.getFile() == juce::File())
+    {
+        chooseReference();
+        return;
+    }
+
+    // Right-click for the track itself; a plain click is the A/B switch
+    if (juce::ModifierKeys::currentModifiers.isPopupMenu())
+    {
+        enum { loadId = 1, removeId };
+
+        juce::PopupMenu menu;
+        menu.addSectionHeader (player.getFile().getFileName());
+        menu.addItem (loadId, "Load Reference...");
+        menu.addItem (removeId, "Remove Reference");
+
+        juce::Component::SafePointer<CarTestAudioProcessorEditor> safeThis (this);
+
+        menu.showMenuAsync (juce::PopupMenu::Options().withTargetComponent (referenceButton),
+                            [safeThis] (int result)
+        {
+            if (safeThis == nullptr)
+                return;
+
+            if (result == loadId)
+            {
+                safeThis->chooseReference();
+            }
+            else if (result == removeId)
+            {
+                safeThis->processorRef.getAPVTS().getParameterAsValue ("reference").setValue (false);
+                safeThis->processorRef.getReferencePlayer().unload();
+                safeThis->updateReferenceButton();
+            }
+        });
+
+        return;
+    }
+
+    auto value = processorRef.getAPVTS().getParameterAsValue ("reference");
+    value.setValue (! static_cast<bool> (value.getValue()));
+    updateReferenceButton();
+}
+
+void CarTestAudioProcessorEditor::chooseReference()
+{
+    referenceChooser = std::make_unique<juce::FileChooser> ("Load a reference track",
+                                                            juce::File::getSpecialLocation (juce::File::userMusicDirectory),
+                                                            "*.wav;*.aif;*.aiff");
+
+    const auto flags = juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles;
+
+    referenceChooser->launchAsync (flags, [this] (const juce::FileChooser& chooser)
+    {
+        const auto file = chooser.getResult();
+
+        if (file == juce::File())
+            return;
+
+        const auto result = processorRef.getReferencePlayer().load (file);
+
+        if (result.failed())
+            juce::AlertWindow::showMessageBoxAsync (juce::MessageBoxIconType::WarningIcon,
+                                                    "Reference", result.getErrorMessage());
+        else
+            processorRef.getAPVTS().getParameterAsValue ("reference").setValue (true);
+
+        updateReferenceButton();
+    });
+}
+
+void CarTestAudioProcessorEditor::updateReferenceButton()
+{
+    const auto stats = processorRef.getReferencePlayer().getStats();
+    const bool on    = processorRef.getAPVTS().getRawParameterValue ("reference")->load() >= 0.5f;
+    juce::String text ("REF");
+
+    // Still measuring the track's loudness, or the read-ahead fell behind
+    if (on && stats.lengthSeconds > 0.0 && ! stats.ready)
+        text << " ...";
+    else if (stats.underruns > 0)
+        text << " !";
+
+    referenceButton.setToggleState (on && stats.ready, juce::dontSendNotification);
+    referenceButton.setButtonText (text);
 }
 
 void CarTestAudioProcessorEditor::selectPreset (int index)
@@ -421,5 +791,9 @@ void CarTestAudioProcessorEditor::updateButtonStates()
         presetButtons[i]->setToggleState (selected, juce::dontSendNotification);
     }
 
+    // Lit when the environment plays a library IR; bypass has none to replace
+    irButton.setEnabled (currentPreset != 0);
+    irButton.setToggleState (processorRef.getUserIR (currentPreset).isNotEmpty(), juce::dontSendNotification);
+
     repaint();
 }
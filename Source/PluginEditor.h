@@ -2,6 +2,7 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "DSP/MixAnalyser.h"
 
 //==============================================================================
 // Automotive colour palette (shared by editor + LookAndFeel classes)
@@ -90,8 +91,41 @@ private:
     juce::Slider noiseSlider;
     juce::Label  noiseLabel { {}, "CITY NOISE" };
 
-    // APVTS attachment
+    // Loudness readout + match toggle
+    juce::Label      loudnessLabel;
+    juce::TextButton matchButton { "MATCH" };
+
+    // Listener capture: records the output to a file in the user's music folder
+    juce::TextButton recordButton { "REC" };
+
+    // Offline mix-translation report for a chosen file, run on a background thread
+    // the editor owns, and stops and joins when it closes
+    juce::TextButton analyseButton { "ANALYSE" };
+    std::unique_ptr<juce::FileChooser> analyseChooser;
+
+    class AnalysisThread : public juce::Thread
+    {
+    public:
+        AnalysisThread (CarTestAudioProcessorEditor& editor, const juce::File& file);
+        void run() override;
+
+    private:
+        juce::Component::SafePointer<CarTestAudioProcessorEditor> editor;
+        const juce::File file;
+    };
+
+    std::unique_ptr<AnalysisThread> analysisThread;
+
+    // The current environment's IR: built-in or one from the user's IR library
+    juce::TextButton irButton { "IR" };
+
+    // A/B against a reference track played through the environment; right-click to load or remove it
+    juce::TextButton referenceButton { "REF" };
+    std::unique_ptr<juce::FileChooser> referenceChooser;
+
+    // APVTS attachments
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> noiseAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> matchAttachment;
 
     // Current selected preset (for button highlighting)
     int currentPreset = 0;
@@ -102,8 +136,23 @@ private:
 
     void selectPreset (int index);
     void updateButtonStates();
+    void updateLoudnessReadout();
+    void toggleCapture();
+    void updateCaptureButton();
+    void chooseFileToAnalyse();
+    void chooseUserIR();
+    void toggleReference();
+    void chooseReference();
+    void updateReferenceButton();
 
     std::vector<juce::TextButton*> presetButtons;
 
+   #if JUCE_DEBUG
+    // Debug builds: the instance's memory footprint, top left, refreshed once a second
+    juce::Label memoryOverlay;
+    int memoryOverlayCountdown = 0;
+    void updateMemoryOverlay();
+   #endif
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CarTestAudioProcessorEditor)
 };
@@ -1,5 +1,6 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "BinaryData.h"
 
 //==============================================================================
 CarTestAudioProcessor::CarTestAudioProcessor()
@@ -10,9 +11,35 @@ CarTestAudioProcessor::CarTestAudioProcessor()
 {
     presetParam      = apvts.getRawParameterValue ("preset");
     noiseAmountParam = apvts.getRawParameterValue ("noiseAmount");
+    fusedIRParam     = apvts.getRawParameterValue ("fusedIR");
+    qualityParam     = apvts.getRawParameterValue ("quality");
+    asyncTailsParam  = apvts.getRawParameterValue ("asyncTails");
+    seatParam        = apvts.getRawParameterValue ("seat");
+    reducedRateParam = apvts.getRawParameterValue ("reducedRate");
+    speedParam       = apvts.getRawParameterValue ("speed");
+    loudnessMatchParam = apvts.getRawParameterValue ("loudnessMatch");
+    blockSchedulingParam = apvts.getRawParameterValue ("blockScheduling");
+    morphParam       = apvts.getRawParameterValue ("morph");
+    morphTargetParam = apvts.getRawParameterValue ("morphTarget");
+    codecPathParam   = apvts.getRawParameterValue ("codecPath");
+    referenceParam   = apvts.getRawParameterValue ("reference");
+
+    userIRNames.resize (static_cast<size_t> (envProcessor.getNumPresets()));
+
+    // User noise profiles, if any, replace the built-in idle / city / highway set
+    const auto profileDir = juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+                                .getChildFile ("Car Test").getChildFile ("NoiseProfiles");
+
+    if (profileDir.isDirectory())
+        noiseGen.setProfiles (NoiseProfile::loadDirectory (profileDir));
+
+    startTimer (kRequestPollMs);
 }
 
-CarTestAudioProcessor::~CarTestAudioProcessor() {}
+CarTestAudioProcessor::~CarTestAudioProcessor()
+{
+    stopTimer();
+}
 
 //==============================================================================
 juce::AudioProcessorValueTreeState::ParameterLayout
@@ -29,6 +56,65 @@ CarTestAudioProcessor::createParameterLayout()
         juce::ParameterID { "noiseAmount", 1 }, "Noise",
         juce::NormalisableRange<float> (0.0f, 1.0f, 0.01f), 0.0f));
 
+    // EQ + IR:  0=Separate, 1=Fused (one precomputed FIR), 2=Auto (whichever measured cheaper per preset).
+    // Was a bool; sessions store the index, so its off / on load as Separate / Fused
+    params.push_back (std::make_unique<juce::AudioParameterChoice> (
+        juce::ParameterID { "fusedIR", 1 }, "Fused EQ + IR",
+        juce::StringArray { "Separate", "Fused", "Auto" }, 0));
+
+    // Quality:  0=Normal (convolution), 1=Eco (fitted IIR approximation of the IR)
+    params.push_back (std::make_unique<juce::AudioParameterChoice> (
+        juce::ParameterID { "quality", 1 }, "Quality",
+        juce::StringArray { "Normal", "Eco" }, 0));
+
+    // Compute late IR partitions on the worker pool shared by all instances
+    params.push_back (std::make_unique<juce::AudioParameterBool> (
+        juce::ParameterID { "asyncTails", 1 }, "Shared IR Tail Threads", false));
+
+    // Listening seat for the car cabin:  0=Driver, 1=Passenger, 2=Rear
+    params.push_back (std::make_unique<juce::AudioParameterChoice> (
+        juce::ParameterID { "seat", 1 }, "Seat",
+        juce::StringArray { "Driver", "Passenger", "Rear" }, 0));
+
+    // Run band-limited presets at a reduced internal rate (changes latency, so not automatable)
+    params.push_back (std::make_unique<juce::AudioParameterBool> (
+        juce::ParameterID { "reducedRate", 1 }, "Reduced Internal Rate", false,
+        juce::AudioParameterBoolAttributes().withAutomatable (false)));
+
+    // Vehicle speed for the noise profiles, km/h
+    params.push_back (std::make_unique<juce::AudioParameterFloat> (
+        juce::ParameterID { "speed", 1 }, "Speed",
+        juce::NormalisableRange<float> (0.0f, 130.0f, 1.0f), 50.0f));
+
+    // Match each environment's loudness to the bypassed input
+    params.push_back (std::make_unique<juce::AudioParameterBool> (
+        juce::ParameterID { "loudnessMatch", 1 }, "Loudness Match", false));
+
+    // Continuous morph from the selected environment towards "Morph To"
+    params.push_back (std::make_unique<juce::AudioParameterFloat> (
+        juce::ParameterID { "morph", 1 }, "Morph",
+        juce::NormalisableRange<float> (0.0f, 1.0f, 0.001f), 0.0f));
+
+    params.push_back (std::make_unique<juce::AudioParameterInt> (
+        juce::ParameterID { "morphTarget", 1 }, "Morph To", 0, 4, 2));
+
+    // Block scheduling:  0=Host blocks, 1=Fixed (zero latency), 2=Fixed + buffered (one block of latency)
+    params.push_back (std::make_unique<juce::AudioParameterChoice> (
+        juce::ParameterID { "blockScheduling", 1 }, "Block Scheduling",
+        juce::StringArray { "Host", "Fixed", "Fixed + Buffered" }, 0,
+        juce::AudioParameterChoiceAttributes().withAutomatable (false)));
+
+    // Lossy codec before the device:  0=Off, 1=Device (BT speaker's SBC), 2=Streaming (AAC 128k on every preset)
+    // Its filterbank adds latency, so not automatable
+    params.push_back (std::make_unique<juce::AudioParameterChoice> (
+        juce::ParameterID { "codecPath", 1 }, "Codec",
+        juce::StringArray { "Off", "Device", "Streaming" }, 0,
+        juce::AudioParameterChoiceAttributes().withAutomatable (false)));
+
+    // Play the loaded reference track through the environment in place of the input
+    params.push_back (std::make_unique<juce::AudioParameterBool> (
+        juce::ParameterID { "reference", 1 }, "Reference", false));
+
     return { params.begin(), params.end() };
 }
 
@@ -40,14 +126,30 @@ void CarTestAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBloc
     spec.maximumBlockSize = static_cast<juce::uint32> (samplesPerBlock);
     spec.numChannels      = static_cast<juce::uint32> (getTotalNumOutputChannels());
 
+    envProcessor.setReducedRate (reducedRateParam->load() >= 0.5f);
+    envProcessor.setBlockScheduling (getBlockSchedulingMode());
+    envProcessor.setCodecPath (getCodecPath());
+
+    // Mapped now, decoded by the processor's preset data job; a name no longer in the library
+    // plays the built-in IR.  The prepare() below takes them all, whatever their length
+    mapUserIRs();
+
+    envProcessor.setHighQuality (isNonRealtime());
     envProcessor.prepare (spec);
+    noiseGen.setSpeed (speedParam->load());
     noiseGen.prepare (sampleRate, samplesPerBlock);
+    loudness.prepare (sampleRate, getTotalNumOutputChannels());
+    capture.prepare (sampleRate, getTotalNumOutputChannels());
+    reference.prepare (sampleRate, samplesPerBlock);
+    setLatencySamples (envProcessor.getLatencySamples());
+    rtMonitor.prepare (sampleRate);
 }
 
 void CarTestAudioProcessor::releaseResources()
 {
     envProcessor.reset();
     noiseGen.reset();
+    loudness.reset();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -71,6 +173,7 @@ void CarTestAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
                                            juce::MidiBuffer& /*midi*/)
 {
     juce::ScopedNoDenormals noDenormals;
+    RealtimeMonitor::ScopedBlock rtCheck (rtMonitor, buffer);
 
     const int totalNumInputChannels  = getTotalNumInputChannels();
     const int totalNumOutputChannels = getTotalNumOutputChannels();
@@ -82,17 +185,152 @@ void CarTestAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
     // Read parameters
     const int   presetIdx  = static_cast<int> (presetParam->load());
     const float noiseAmt   = noiseAmountParam->load();
+    const auto  convMode   = static_cast<EnvironmentProcessor::ConvolutionMode> (
+                                 juce::jlimit (0, 2, static_cast<int> (fusedIRParam->load())));
+    const bool  eco        = static_cast<int> (qualityParam->load()) == 1;
+    const bool  asyncTails = asyncTailsParam->load() >= 0.5f;
+    const int   seat       = juce::jlimit (0, CabinModel::numSeats - 1, static_cast<int> (seatParam->load()));
+    const bool  match      = loudnessMatchParam->load() >= 0.5f;
+    const float morph      = morphParam->load();
+    const int   morphTo    = static_cast<int> (morphTargetParam->load());
+
+    // A reduced-rate, scheduling or codec change needs a fresh prepare (new rate, new latency).
+    // Offline / live isn't one of them: it's picked in prepareToPlay(), which hosts call around a bounce
+    if ((reducedRateParam->load() >= 0.5f) != envProcessor.getReducedRate()
+         || getBlockSchedulingMode() != envProcessor.getBlockScheduling()
+         || getCodecPath() != envProcessor.getCodecPath())
+    {
+        prepareRequested = true;
+    }
+
+    loudness.measureInput (buffer);
 
-    // If bypass and no noise, early out
-    if (presetIdx == 0 && noiseAmt < 0.0001f)
+    // The reference track takes the input's place from here on, so it goes through the
+    // same chain; the live input, metered above, is what it's loudness-matched to
+    const bool fromReference = reference.process (buffer, referenceParam->load() >= 0.5f,
+                                                  loudness.getReadings().inputIntegratedLufs);
+
+    // If bypass and no noise, early out (unless bypass has to carry the latency)
+    if (presetIdx == 0 && noiseAmt < 0.0001f && envProcessor.getLatencySamples() == 0
+         && (morph <= 0.0f || morphTo == 0) && ! envProcessor.isMorphing())
+    {
+        loudness.processOutput (buffer, 0, match, fromReference);
+        capture.push (buffer);
         return;
+    }
 
     // Apply environment processing
+    envProcessor.setConvolutionMode (presetIdx, convMode);
+    envProcessor.setQuality (eco ? EnvironmentProcessor::Quality::eco
+                                 : EnvironmentProcessor::Quality::normal);
+    envProcessor.setAsyncTails (asyncTails);
+    envProcessor.setSeat (static_cast<CabinModel::Seat> (seat));
     envProcessor.setPreset (presetIdx);
+    envProcessor.setMorph (morphTo, morph);
     envProcessor.process (buffer);
 
+    // Meter the environment and apply its matching gain (the noise isn't part of the match)
+    loudness.processOutput (buffer, presetIdx, match, fromReference);
+
     // Add background noise
+    noiseGen.setSpeed (speedParam->load());
     noiseGen.process (buffer, noiseAmt);
+
+    // Record exactly what the listener hears
+    capture.push (buffer);
+}
+
+BlockScheduler::Mode CarTestAudioProcessor::getBlockSchedulingMode() const
+{
+    return static_cast<BlockScheduler::Mode> (juce::jlimit (0, 2, static_cast<int> (blockSchedulingParam->load())));
+}
+
+EnvironmentProcessor::CodecPath CarTestAudioProcessor::getCodecPath() const
+{
+    return static_cast<EnvironmentProcessor::CodecPath> (juce::jlimit (0, 2, static_cast<int> (codecPathParam->load())));
+}
+
+void CarTestAudioProcessor::setUserIR (int presetIndex, const juce::String& name)
+{
+    const juce::ScopedLock sl (userIRNamesLock);
+
+    if (! juce::isPositiveAndBelow (presetIndex, static_cast<int> (userIRNames.size()))
+         || userIRNames[static_cast<size_t> (presetIndex)] == name)
+        return;
+
+    userIRNames[static_cast<size_t> (presetIndex)] = name;
+    userIRsChanged = true;
+}
+
+juce::String CarTestAudioProcessor::getUserIR (int presetIndex) const
+{
+    const juce::ScopedLock sl (userIRNamesLock);
+
+    return juce::isPositiveAndBelow (presetIndex, static_cast<int> (userIRNames.size()))
+             ? userIRNames[static_cast<size_t> (presetIndex)] : juce::String();
+}
+
+std::vector<juce::String> CarTestAudioProcessor::getUserIRNames() const
+{
+    const juce::ScopedLock sl (userIRNamesLock);
+    return userIRNames;
+}
+
+void CarTestAudioProcessor::clearUserIRs()
+{
+    for (int i = 0; i < envProcessor.getNumPresets(); ++i)
+        setUserIR (i, {});
+}
+
+bool CarTestAudioProcessor::mapUserIRs()
+{
+    // A copy, so a restore on another thread can change the names while they're mapped
+    const auto names = getUserIRNames();
+    bool fitted = true;
+
+    for (int i = 0; i < envProcessor.getNumPresets(); ++i)
+        fitted = envProcessor.setUserIR (i, irLibrary->map (irLibrary->indexOf (names[static_cast<size_t> (i)]))) && fitted;
+
+    return fitted;
+}
+
+void CarTestAudioProcessor::timerCallback()
+{
+    if (referenceRestorePending.exchange (false))
+        restoreReference();
+
+    // Mapped here and built by the environment's background job, without a re-prepare,
+    // unless the IR is longer than its convolvers were prepared for
+    if (userIRsChanged.exchange (false) && getSampleRate() > 0.0 && ! mapUserIRs())
+        prepareRequested = true;
+
+    if (prepareRequested.exchange (false) && getSampleRate() > 0.0)
+    {
+        suspendProcessing (true);
+        prepareToPlay (getSampleRate(), getBlockSize());
+        suspendProcessing (false);
+    }
+}
+
+void CarTestAudioProcessor::restoreReference()
+{
+    juce::String path;
+
+    {
+        const juce::ScopedLock sl (pendingReferenceLock);
+        path = pendingReferencePath;
+    }
+
+    // A reference that has moved or gone is simply not loaded
+    if (juce::File::isAbsolutePath (path) && juce::File (path).existsAsFile())
+    {
+        if (juce::File (path) != reference.getFile())
+            reference.load (juce::File (path));
+    }
+    else
+    {
+        reference.unload();
+    }
 }
 
 //==============================================================================
@@ -116,21 +354,157 @@ const juce::String CarTestAudioProcessor::getProgramName (int) { return {}; }
 void   CarTestAudioProcessor::changeProgramName (int, const juce::String&) {}
 
 //==============================================================================
+namespace
+{
+    // Binary state: magic, version, then (parameter ID, plain value) pairs.
+    // Version 2 appends the user IRs as (preset index, library name) pairs,
+    // version 3 the reference track's path
+    constexpr int kStateMagic   = 0x42535443;   // "CTSB"
+    constexpr int kStateVersion = 3;
+}
+
 void CarTestAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    auto state = apvts.copyState();
-    std::unique_ptr<juce::XmlElement> xml (state.createXml());
-    copyXmlToBinary (*xml, destData);
+    juce::MemoryOutputStream out (destData, false);
+    out.writeInt (kStateMagic);
+    out.writeShort (static_cast<short> (kStateVersion));
+
+    const auto& params = getParameters();
+    out.writeCompressedInt (params.size());
+
+    for (auto* p : params)
+    {
+        auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (p);
+        jassert (ranged != nullptr);   // APVTS only creates ranged parameters
+
+        out.writeString (ranged->getParameterID());
+        out.writeFloat (ranged->convertFrom0to1 (ranged->getValue()));
+    }
+
+    const auto names = getUserIRNames();
+    out.writeCompressedInt (static_cast<int> (names.size()));
+
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        out.writeCompressedInt (static_cast<int> (i));
+        out.writeString (names[i]);
+    }
+
+    out.writeString (reference.getFile().getFullPathName());
 }
 
 void CarTestAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
+    if (restoreBinaryState (data, sizeInBytes))
+        return;
+
+    // Sessions saved before the binary format stored the APVTS as XML, and no user IRs
     std::unique_ptr<juce::XmlElement> xml (getXmlFromBinary (data, sizeInBytes));
     if (xml != nullptr && xml->hasTagName (apvts.state.getType()))
+    {
+        clearUserIRs();
         apvts.replaceState (juce::ValueTree::fromXml (*xml));
+    }
+}
+
+bool CarTestAudioProcessor::restoreBinaryState (const void* data, int sizeInBytes)
+{
+    if (data == nullptr || sizeInBytes < 6)
+        return false;
+
+    juce::MemoryInputStream in (data, static_cast<size_t> (sizeInBytes), false);
+
+    if (in.readInt() != kStateMagic)
+        return false;
+
+    // Newer versions only append fields, so any version is readable from here on
+    const int version = in.readShort();
+
+    const int count = in.readCompressedInt();
+    auto state = apvts.copyState();
+
+    for (int i = 0; i < count && ! in.isExhausted(); ++i)
+    {
+        const auto id    = in.readString();
+        const auto value = in.readFloat();
+
+        // Only touches the parameters: IRs and filters are rebuilt lazily on
+        // the audio thread / background loader, not here
+        auto param = state.getChildWithProperty ("id", id);
+
+        if (param.isValid())
+            param.setProperty ("value", value, nullptr);
+    }
+
+    // Through the APVTS, like the XML restore, so processBlock's values,
+    // the host and the editor's attachments all hear about it
+    apvts.replaceState (state);
+
+    // Names only: the library maps them on the next prepare.  Versions
+    // before 2 had none, so their presets all play the built-in IRs
+    clearUserIRs();
+
+    if (version >= 2)
+    {
+        const int numUserIRs = in.readCompressedInt();
+
+        for (int i = 0; i < numUserIRs && ! in.isExhausted(); ++i)
+        {
+            const int  presetIndex = in.readCompressedInt();
+            const auto name        = in.readString();
+            setUserIR (presetIndex, name);
+        }
+    }
+
+    // Mapping and measuring the track is message-thread work, and hosts
+    // restore state on whatever thread they like, so it's loaded from there
+    if (version >= 3)
+    {
+        const auto path = in.readString();
+
+        {
+            const juce::ScopedLock sl (pendingReferenceLock);
+            pendingReferencePath = path;
+        }
+
+        referenceRestorePending = true;
+    }
+
+    return true;
 }
 
 //==============================================================================
+juce::Image CarTestAudioProcessor::getDashboardImage()
+{
+    // Message thread only (editor construction)
+    if (! dashboardImage->image.isValid())
+        dashboardImage->image = juce::ImageCache::getFromMemory (BinaryData::Dashboard_png,
+                                                                 BinaryData::Dashboard_pngSize);
+
+    return dashboardImage->image;
+}
+
+MemoryFootprint CarTestAudioProcessor::getMemoryFootprint() const
+{
+    auto footprint = envProcessor.getMemoryFootprint();
+    footprint[MemoryFootprint::scratch] += noiseGen.getMemoryBytes() + capture.getMemoryBytes()
+                                           + reference.getMemoryBytes();
+
+    // The IR library's catalogue (shared, like the image); mapped IR files are address space, not heap
+    footprint[MemoryFootprint::presetData] += irLibrary->getMemoryBytes();
+
+    const auto& image = dashboardImage->image;
+
+    if (image.isValid())
+    {
+        const juce::Image::BitmapData pixels (image, juce::Image::BitmapData::readOnly);
+        footprint[MemoryFootprint::uiImages] += static_cast<size_t> (pixels.lineStride)
+                                                  * static_cast<size_t> (pixels.height);
+    }
+
+    return footprint;
+}
+
 juce::StringArray CarTestAudioProcessor::getPresetNames() const
 {
     return { "Bypass", "The Sedan", "The Phone", "The Laptop", "The BT Speaker" };
@@ -3,9 +3,14 @@
 #include <JuceHeader.h>
 #include "DSP/EnvironmentProcessor.h"
 #include "DSP/NoiseGenerator.h"
+#include "DSP/LoudnessMatcher.h"
+#include "RealtimeMonitor.h"
+#include "CaptureRecorder.h"
+#include "ReferencePlayer.h"
 
 //==============================================================================
-class CarTestAudioProcessor : public juce::AudioProcessor
+class CarTestAudioProcessor : public juce::AudioProcessor,
+                              private juce::Timer
 {
 public:
     CarTestAudioProcessor();
@@ -50,17 +55,102 @@ public:
     // Convenience: get the list of preset names for the UI
     juce::StringArray getPresetNames() const;
 
+    const EnvironmentProcessor& getEnvironmentProcessor() const { return envProcessor; }
+
+    /** Dashboard background: decoded the first time an editor asks, then shared by every instance. */
+    juce::Image getDashboardImage();
+
+    /** Input / output loudness and the applied match gain; safe from any thread. */
+    LoudnessMatcher::Readings getLoudnessReadings() const { return loudness.getReadings(); }
+
+    /** The user's IR folder, shared by every instance. */
+    IRLibrary& getIRLibrary() { return *irLibrary; }
+
+    /**
+        Plays a library IR (by catalogue name) in place of a preset's own, or
+        the built-in one for an empty name; any thread, since hosts restore
+        state on whatever thread they like.  The name is saved with the
+        session, and the IR is built in the background while the preset
+        keeps playing (see EnvironmentProcessor::setUserIR()).
+    */
+    void setUserIR (int presetIndex, const juce::String& name);
+    juce::String getUserIR (int presetIndex) const;
+
+    /** Records the processed output to disk; start / stop from the message thread. */
+    CaptureRecorder& getCaptureRecorder() { return capture; }
+
+    /** The reference track the "reference" parameter switches to; load / unload from the message thread. */
+    ReferencePlayer& getReferencePlayer() { return reference; }
+
+    /**
+        Bytes this instance holds, by subsystem; message thread.  UI images
+        are the decoded dashboard, one copy shared by every instance.
+    */
+    MemoryFootprint getMemoryFootprint() const;
+
+    // Real-time violations seen by processBlock (populated in CARTEST_RT_CHECKS builds)
+    RealtimeMonitor::Stats getRealtimeStats() const { return rtMonitor.getStats(); }
+    void resetRealtimeStats()                       { rtMonitor.resetStats(); }
+
 private:
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
 
+    /**
+        Message thread: loads a restored reference track, and re-prepares with
+        the new internal rate, scheduling, codec path, user IRs or offline
+        quality, off the audio thread.  Polls the requests below, which the
+        audio thread can set without posting a message.
+    */
+    void timerCallback() override;
+    void restoreReference();
+
+    BlockScheduler::Mode getBlockSchedulingMode() const;
+    EnvironmentProcessor::CodecPath getCodecPath() const;
+
+    /** Reads the compact binary state; false if data is in another format. */
+    bool restoreBinaryState (const void* data, int sizeInBytes);
+
     juce::AudioProcessorValueTreeState apvts;
 
+    struct SharedDashboardImage { juce::Image image; };
+    juce::SharedResourcePointer<SharedDashboardImage> dashboardImage;
+
     EnvironmentProcessor envProcessor;
+    juce::SharedResourcePointer<IRLibrary> irLibrary;
+    std::vector<juce::String> userIRNames;   // per preset; empty = built-in.  Under userIRNamesLock
+    juce::CriticalSection userIRNamesLock;
+    std::vector<juce::String> getUserIRNames() const;
+    bool mapUserIRs();   // false if one needs a re-prepare
+    void clearUserIRs();
     NoiseGenerator       noiseGen;
+    LoudnessMatcher      loudness;
+    RealtimeMonitor      rtMonitor;
+    CaptureRecorder      capture;
+    ReferencePlayer      reference;
+
+    // Requests for timerCallback()
+    static constexpr int kRequestPollMs = 50;
+    std::atomic<bool> prepareRequested { false };
+    std::atomic<bool> userIRsChanged { false };
+    std::atomic<bool> referenceRestorePending { false };
+    juce::CriticalSection pendingReferenceLock;
+    juce::String pendingReferencePath;
 
     // Atomic parameter caches (read in processBlock)
     std::atomic<float>* presetParam     = nullptr;
     std::atomic<float>* noiseAmountParam = nullptr;
+    std::atomic<float>* fusedIRParam     = nullptr;
+    std::atomic<float>* qualityParam     = nullptr;
+    std::atomic<float>* asyncTailsParam  = nullptr;
+    std::atomic<float>* seatParam        = nullptr;
+    std::atomic<float>* reducedRateParam = nullptr;
+    std::atomic<float>* speedParam       = nullptr;
+    std::atomic<float>* loudnessMatchParam = nullptr;
+    std::atomic<float>* blockSchedulingParam = nullptr;
+    std::atomic<float>* morphParam           = nullptr;
+    std::atomic<float>* morphTargetParam     = nullptr;
+    std::atomic<float>* codecPathParam       = nullptr;
+    std::atomic<float>* referenceParam       = nullptr;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CarTestAudioProcessor)
 };
@@ -0,0 +1,293 @@
+#include "RealtimeMonitor.h"
+#include <cmath>
+#include <cstdlib>
+#include <new>
+
+#if CARTEST_RT_CHECKS && JUCE_LINUX
+ #include <dlfcn.h>
+ #include <pthread.h>
+#elif CARTEST_RT_CHECKS && JUCE_WINDOWS
+ #include <malloc.h>
+#endif
+
+namespace
+{
+    // Monitor of the processBlock currently running on this thread (if any)
+    thread_local RealtimeMonitor* activeMonitor = nullptr;
+}
+
+//==============================================================================
+void RealtimeMonitor::prepare (double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    lastSample.fill (0.0f);
+}
+
+RealtimeMonitor::Stats RealtimeMonitor::getStats() const
+{
+    Stats s;
+    s.blocks           = blocks.load();
+    s.allocations      = allocations.load();
+    s.deallocations    = deallocations.load();
+    s.locks            = locks.load();
+    s.nonFiniteSamples = nonFiniteSamples.load();
+    s.denormalSamples  = denormalSamples.load();
+    s.discontinuities  = discontinuities.load();
+    s.worstBlockMs     = worstBlockMs.load();
+    s.worstBlockLoad   = worstBlockLoad.load();
+    return s;
+}
+
+void RealtimeMonitor::resetStats()
+{
+    blocks = 0;
+    allocations = 0;
+    deallocations = 0;
+    locks = 0;
+    nonFiniteSamples = 0;
+    denormalSamples = 0;
+    discontinuities = 0;
+    worstBlockMs = 0.0;
+    worstBlockLoad = 0.0;
+}
+
+void RealtimeMonitor::noteAllocation() noexcept
+{
+    if (auto* m = activeMonitor)
+        m->allocations.fetch_add (1, std::memory_order_relaxed);
+}
+
+void RealtimeMonitor::noteDeallocation() noexcept
+{
+    if (auto* m = activeMonitor)
+        m->deallocations.fetch_add (1, std::memory_order_relaxed);
+}
+
+void RealtimeMonitor::noteLock() noexcept
+{
+    if (auto* m = activeMonitor)
+        m->locks.fetch_add (1, std::memory_order_relaxed);
+}
+
+//==============================================================================
+void RealtimeMonitor::analyseBlock (const juce::AudioBuffer<float>& buffer, juce::int64 elapsedTicks)
+{
+    const int numSamples = buffer.getNumSamples();
+    const int channels   = juce::jmin (buffer.getNumChannels(), kMaxChannels);
+
+    blocks.fetch_add (1, std::memory_order_relaxed);
+
+    // ---- Timing ----
+    const double ms = juce::Time::highResolutionTicksToSeconds (elapsedTicks) * 1000.0;
+    if (ms > worstBlockMs.load (std::memory_order_relaxed))
+        worstBlockMs.store (ms, std::memory_order_relaxed);
+
+    if (numSamples > 0)
+    {
+        const double budgetMs = 1000.0 * numSamples / sampleRate;
+        const double load     = ms / budgetMs;
+
+        if (load > worstBlockLoad.load (std::memory_order_relaxed))
+            worstBlockLoad.store (load, std::memory_order_relaxed);
+    }
+
+    // ---- Output sanity ----
+    juce::int64 badSamples = 0, denormals = 0, jumps = 0;
+
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        const auto* d = buffer.getReadPointer (ch);
+        float maxStep = 0.0f;
+
+        for (int s = 0; s < numSamples; ++s)
+        {
+            if (! std::isfinite (d[s]))
+                ++badSamples;
+            else if (std::fpclassify (d[s]) == FP_SUBNORMAL)
+                ++denormals;
+
+            if (s > 0)
+                maxStep = juce::jmax (maxStep, std::abs (d[s] - d[s - 1]));
+        }
+
+        if (numSamples > 0)
+        {
+            // A step at the boundary much larger than anything inside the
+            // block means state was lost between calls
+            const float boundaryStep = std::abs (d[0] - lastSample[static_cast<size_t> (ch)]);
+
+            if (boundaryStep > 0.25f && boundaryStep > 4.0f * maxStep + 1.0e-3f)
+                ++jumps;
+
+            lastSample[static_cast<size_t> (ch)] = d[numSamples - 1];
+        }
+    }
+
+    if (badSamples > 0) nonFiniteSamples.fetch_add (badSamples, std::memory_order_relaxed);
+    if (denormals > 0)  denormalSamples.fetch_add (denormals, std::memory_order_relaxed);
+    if (jumps > 0)      discontinuities.fetch_add (jumps, std::memory_order_relaxed);
+}
+
+//==============================================================================
+#if CARTEST_RT_CHECKS
+
+RealtimeMonitor::ScopedBlock::ScopedBlock (RealtimeMonitor& monitor, const juce::AudioBuffer<float>& buffer)
+    : owner (monitor), output (buffer), previous (activeMonitor)
+{
+    activeMonitor = &owner;
+    startTicks = juce::Time::getHighResolutionTicks();
+}
+
+RealtimeMonitor::ScopedBlock::~ScopedBlock()
+{
+    const auto elapsed = juce::Time::getHighResolutionTicks() - startTicks;
+
+    // Analysis itself may not allocate, but keep it out of the counters anyway
+    activeMonitor = previous;
+    owner.analyseBlock (output, elapsed);
+}
+
+//==============================================================================
+// Debug allocator hooks: count every heap operation made inside a ScopedBlock.
+// Every replaceable form is here, so nothing (aligned types, nothrow new) gets past
+
+namespace
+{
+    void* allocate (std::size_t size) noexcept
+    {
+        RealtimeMonitor::noteAllocation();
+        return std::malloc (size == 0 ? 1 : size);
+    }
+
+    void* allocateAligned (std::size_t size, std::align_val_t alignment) noexcept
+    {
+        RealtimeMonitor::noteAllocation();
+        const auto align = juce::jmax (static_cast<std::size_t> (alignment), sizeof (void*));
+
+       #if JUCE_WINDOWS
+        return _aligned_malloc (size == 0 ? 1 : size, align);
+       #else
+        void* p = nullptr;
+        return posix_memalign (&p, align, size == 0 ? 1 : size) == 0 ? p : nullptr;
+       #endif
+    }
+
+    void deallocate (void* p) noexcept
+    {
+        if (p != nullptr)
+            RealtimeMonitor::noteDeallocation();
+
+        std::free (p);
+    }
+
+    void deallocateAligned (void* p) noexcept
+    {
+        if (p != nullptr)
+            RealtimeMonitor::noteDeallocation();
+
+       #if JUCE_WINDOWS
+        _aligned_free (p);
+       #else
+        std::free (p);
+       #endif
+    }
+}
+
+void* operator new (std::size_t size)
+{
+    if (auto* p = allocate (size))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)
+{
+    return operator new (size);
+}
+
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate (size);
+}
+
+void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate (size);
+}
+
+void* operator new (std::size_t size, std::align_val_t alignment)
+{
+    if (auto* p = allocateAligned (size, alignment))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size, std::align_val_t alignment)
+{
+    return operator new (size, alignment);
+}
+
+void* operator new (std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocateAligned (size, alignment);
+}
+
+void* operator new[] (std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocateAligned (size, alignment);
+}
+
+void operator delete   (void* p) noexcept                                          { deallocate (p); }
+void operator delete[] (void* p) noexcept                                          { deallocate (p); }
+void operator delete   (void* p, std::size_t) noexcept                             { deallocate (p); }
+void operator delete[] (void* p, std::size_t) noexcept                             { deallocate (p); }
+void operator delete   (void* p, const std::nothrow_t&) noexcept                   { deallocate (p); }
+void operator delete[] (void* p, const std::nothrow_t&) noexcept                   { deallocate (p); }
+void operator delete   (void* p, std::align_val_t) noexcept                        { deallocateAligned (p); }
+void operator delete[] (void* p, std::align_val_t) noexcept                        { deallocateAligned (p); }
+void operator delete   (void* p, std::size_t, std::align_val_t) noexcept           { deallocateAligned (p); }
+void operator delete[] (void* p, std::size_t, std::align_val_t) noexcept           { deallocateAligned (p); }
+void operator delete   (void* p, std::align_val_t, const std::nothrow_t&) noexcept { deallocateAligned (p); }
+void operator delete[] (void* p, std::align_val_t, const std::nothrow_t&) noexcept { deallocateAligned (p); }
+
+//==============================================================================
+// Lock hook: count every blocking mutex lock made inside a ScopedBlock.  In an
+// executable this definition takes libc's place for the whole process (the
+// standard library's and JUCE's mutexes included).  A shared object built with
+// hidden visibility would bind its own calls to it too, which is why only the
+// harness builds the checks.  Other platforms go unchecked
+
+#if JUCE_LINUX
+
+namespace
+{
+    using MutexLockFunction = int (*) (pthread_mutex_t*);
+
+    // Resolved on first use, without a function-local static: its guard may itself lock
+    std::atomic<MutexLockFunction> libcMutexLock { nullptr };
+}
+
+extern "C" int pthread_mutex_lock (pthread_mutex_t* mutex)
+{
+    auto lock = libcMutexLock.load (std::memory_order_acquire);
+
+    if (lock == nullptr)
+    {
+        lock = reinterpret_cast<MutexLockFunction> (dlsym (RTLD_NEXT, "pthread_mutex_lock"));
+        libcMutexLock.store (lock, std::memory_order_release);
+    }
+
+    RealtimeMonitor::noteLock();
+    return lock (mutex);
+}
+
+#endif
+
+#else
+
+RealtimeMonitor::ScopedBlock::ScopedBlock (RealtimeMonitor&, const juce::AudioBuffer<float>&) {}
+RealtimeMonitor::ScopedBlock::~ScopedBlock() {}
+
+#endif
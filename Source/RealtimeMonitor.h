@@ -0,0 +1,86 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+/**
+    Watches processBlock for real-time violations in builds compiled with
+    CARTEST_RT_CHECKS.  Only car-test-rt-harness defines it: the checks
+    replace the global allocator and pthread_mutex_lock, which a plugin
+    mustn't do inside a host.
+
+    Per block it records:
+      - heap allocations / frees made on the audio thread (via the debug
+        operator new / delete in RealtimeMonitor.cpp, every overload)
+      - blocking mutex locks taken on the audio thread (Linux, where the
+        monitor's pthread_mutex_lock stands in for libc's).  Try-locks are
+        fine
+      - wall-clock time, and the worst block as a fraction of its real-time budget
+      - NaN / Inf and denormal output samples
+      - step discontinuities at the block boundary
+
+    Counters are atomics so the editor or a debugger can read them while
+    audio is running.  In other builds ScopedBlock compiles to nothing.
+*/
+class RealtimeMonitor
+{
+public:
+    struct Stats
+    {
+        juce::int64 blocks           = 0;
+        juce::int64 allocations      = 0;
+        juce::int64 deallocations    = 0;
+        juce::int64 locks            = 0;
+        juce::int64 nonFiniteSamples = 0;
+        juce::int64 denormalSamples  = 0;
+        juce::int64 discontinuities  = 0;
+        double      worstBlockMs     = 0.0;
+        double      worstBlockLoad   = 0.0;   // block time / block duration
+
+        bool hasViolations() const
+        {
+            return allocations > 0 || deallocations > 0 || locks > 0 || nonFiniteSamples > 0
+                || denormalSamples > 0 || discontinuities > 0 || worstBlockLoad > 1.0;
+        }
+    };
+
+    void  prepare (double sampleRate);
+    Stats getStats() const;
+    void  resetStats();
+
+    //==========================================================================
+    /** Put one of these at the top of processBlock. */
+    class ScopedBlock
+    {
+    public:
+        ScopedBlock (RealtimeMonitor& monitor, const juce::AudioBuffer<float>& buffer);
+        ~ScopedBlock();
+
+    private:
+       #if CARTEST_RT_CHECKS
+        RealtimeMonitor& owner;
+        const juce::AudioBuffer<float>& output;
+        RealtimeMonitor* previous = nullptr;
+        juce::int64 startTicks = 0;
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedBlock)
+    };
+
+    /** Called by the debug allocator hooks; cheap no-ops off the audio thread. */
+    static void noteAllocation() noexcept;
+    static void noteDeallocation() noexcept;
+    static void noteLock() noexcept;
+
+private:
+    void analyseBlock (const juce::AudioBuffer<float>& buffer, juce::int64 elapsedTicks);
+
+    static constexpr int kMaxChannels = 8;
+
+    double sampleRate = 44100.0;
+    std::array<float, kMaxChannels> lastSample {};
+
+    std::atomic<juce::int64> blocks { 0 }, allocations { 0 }, deallocations { 0 }, locks { 0 },
+                             nonFiniteSamples { 0 }, denormalSamples { 0 }, discontinuities { 0 };
+    std::atomic<double> worstBlockMs { 0.0 }, worstBlockLoad { 0.0 };
+};
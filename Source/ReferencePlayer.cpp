@@ -0,0 +1,391 @@
+#include "ReferencePlayer.h"
+#include "DSP/LoudnessMatcher.h"
+#include "DSP/MemoryFootprint.h"
+#include <cmath>
+
+//==============================================================================
+/** One mapped reference file and everything the three threads keep about it. */
+struct ReferencePlayer::Track
+{
+    // The loudness pass reads this much of the file per poll, so one long
+    // track doesn't hold up the other instances' read-ahead
+    static constexpr int kMeasureSlice = 1 << 17;
+
+    /** Reads numSamples from start (unwrapped: the track loops) into dest's first channels. */
+    void read (juce::AudioBuffer<float>& dest, juce::int64 start, int numSamples) noexcept
+    {
+        for (int done = 0; done < numSamples;)
+        {
+            const auto index = (start + done) % length;
+            const int  count = static_cast<int> (juce::jmin<juce::int64> (numSamples - done, length - index));
+            float* const destChannels[] = { dest.getWritePointer (0, done), dest.getWritePointer (1, done) };
+
+            reader->read (destChannels, numChannels, index, count);
+            done += count;
+        }
+    }
+
+    juce::File file;
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader;
+    juce::int64 length      = 0;
+    int         numChannels = 1;   // 1 or 2
+    int         pageStride  = 1;   // samples per page of the file
+    juce::int64 readAhead   = 0;   // kReadAheadSeconds, in samples of the file
+
+    // Read-ahead thread: the loudness pass, then the touched range
+    LoudnessMeter meter;
+    juce::AudioBuffer<float> measureBuffer;
+    juce::int64 measuredUntil = 0;
+    juce::int64 touchedUntil  = 0;
+
+    std::atomic<float> loudnessLufs { LoudnessMeter::kSilenceLufs };
+    std::atomic<bool>  measured     { false };
+
+    // File samples played since load, unwrapped (the position is this modulo
+    // length), and how far past it the read-ahead has touched
+    std::atomic<juce::int64> consumed      { 0 };
+    std::atomic<juce::int64> residentUntil { 0 };
+
+    // Audio thread, sized by retune()
+    double ratio = 1.0;   // file samples per output sample
+    juce::AudioBuffer<float> sourceBuffer;
+    std::array<juce::LagrangeInterpolator, 2> interpolators;
+};
+
+//==============================================================================
+/** Measures and reads ahead for every loaded instance, every few milliseconds. */
+class ReferencePlayer::ReadAheadThread : private juce::Thread
+{
+public:
+    ReadAheadThread() : juce::Thread ("Car Test reference read-ahead") {}
+    ~ReadAheadThread() override { stopThread (4000); }
+
+    void add (ReferencePlayer& player)
+    {
+        const juce::ScopedLock sl (lock);
+        players.addIfNotAlreadyThere (&player);
+
+        if (! isThreadRunning())
+            startThread();
+    }
+
+    /** Once this returns, the thread won't touch player again. */
+    void remove (ReferencePlayer& player)
+    {
+        const juce::ScopedLock sl (lock);
+        players.removeFirstMatchingValue (&player);
+    }
+
+private:
+    // Polled rather than signalled, so process() never has to wake anyone;
+    // kReadAheadSeconds is far longer than a poll
+    static constexpr int kPollMs = 10;
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            {
+                const juce::ScopedLock sl (lock);
+
+                for (auto* player : players)
+                    player->readAhead();
+            }
+
+            wait (kPollMs);
+        }
+    }
+
+    juce::CriticalSection lock;
+    juce::Array<ReferencePlayer*> players;
+};
+
+//==============================================================================
+ReferencePlayer::ReferencePlayer() = default;
+
+ReferencePlayer::~ReferencePlayer()
+{
+    unload();
+}
+
+void ReferencePlayer::prepare (double newSampleRate, int maximumBlockSize)
+{
+    sampleRate = newSampleRate;
+    maxBlock   = juce::jmax (1, maximumBlockSize);
+
+    referenceBuffer.setSize (2, maxBlock);
+    gain.reset (sampleRate, kGainRampSeconds);
+    fadeStep = static_cast<float> (1.0 / (kFadeSeconds * sampleRate));
+    fade     = 0.0f;
+
+    const juce::ScopedLock sl (trackLock);
+
+    if (track != nullptr)
+        retune (*track);
+}
+
+size_t ReferencePlayer::getMemoryBytes() const
+{
+    const juce::ScopedLock sl (trackLock);
+    size_t bytes = MemoryFootprint::bytesOf (referenceBuffer);
+
+    if (track != nullptr)
+        bytes += MemoryFootprint::bytesOf (track->sourceBuffer) + MemoryFootprint::bytesOf (track->measureBuffer);
+
+    return bytes;
+}
+
+void ReferencePlayer::retune (Track& t)
+{
+    t.ratio = t.reader->sampleRate / sampleRate;
+    t.sourceBuffer.setSize (2, static_cast<int> (std::ceil (maxBlock * t.ratio)) + 2);
+
+    for (auto& interpolator : t.interpolators)
+        interpolator.reset();
+}
+
+//==============================================================================
+juce::Result ReferencePlayer::load (const juce::File& file)
+{
+    unload();
+
+    // Only uncompressed formats can be read in place from a mapping
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader;
+
+    if (file.hasFileExtension ("wav"))
+        reader.reset (juce::WavAudioFormat().createMemoryMappedReader (file));
+    else if (file.hasFileExtension ("aif;aiff"))
+        reader.reset (juce::AiffAudioFormat().createMemoryMappedReader (file));
+    else
+        return juce::Result::fail ("Only WAV and AIFF references can be streamed: convert "
+                                   + file.getFileName() + " first");
+
+    if (reader == nullptr || reader->sampleRate <= 0.0 || reader->lengthInSamples <= 0)
+        return juce::Result::fail ("Couldn't read " + file.getFullPathName());
+
+    if (reader->numChannels != 1 && reader->numChannels != 2)
+        return juce::Result::fail ("References must be mono or stereo");
+
+    // Address space only: nothing is read until the read-ahead thread gets to it
+    if (! reader->mapEntireFile())
+        return juce::Result::fail ("Couldn't map " + file.getFullPathName());
+
+    auto t = std::make_unique<Track>();
+    t->file        = file;
+    t->length      = reader->lengthInSamples;
+    t->numChannels = static_cast<int> (reader->numChannels);
+    t->pageStride  = juce::jmax (1, juce::SystemStats::getPageSize()
+                                      / juce::jmax (1, t->numChannels * static_cast<int> (reader->bitsPerSample) / 8));
+    t->readAhead   = static_cast<juce::int64> (kReadAheadSeconds * reader->sampleRate);
+    t->reader      = std::move (reader);
+
+    // Measured as it's heard: a mono track plays on both channels
+    t->meter.prepare (t->reader->sampleRate, 2);
+    t->measureBuffer.setSize (2, Track::kMeasureSlice);
+    retune (*t);
+
+    {
+        const juce::ScopedLock sl (trackLock);
+        const juce::SpinLock::ScopedLockType al (audioLock);
+        track = std::move (t);
+    }
+
+    underruns = 0;
+    readAheadThread->add (*this);
+    return juce::Result::ok();
+}
+
+void ReferencePlayer::unload()
+{
+    readAheadThread->remove (*this);
+
+    std::unique_ptr<Track> old;
+
+    {
+        const juce::ScopedLock sl (trackLock);
+        const juce::SpinLock::ScopedLockType al (audioLock);
+        old = std::move (track);
+
+        // Back to the live input; the next track fades in from it
+        fade   = 0.0f;
+        gainDb = 0.0f;
+        gain.setCurrentAndTargetValue (1.0f);
+    }
+
+    appliedGainDb = 0.0f;
+
+    // old is unmapped here, on this thread
+}
+
+juce::File ReferencePlayer::getFile() const
+{
+    const juce::ScopedLock sl (trackLock);
+    return track != nullptr ? track->file : juce::File();
+}
+
+ReferencePlayer::Stats ReferencePlayer::getStats() const
+{
+    Stats s;
+    s.underruns   = underruns.load (std::memory_order_relaxed);
+    s.matchGainDb = appliedGainDb.load (std::memory_order_relaxed);
+
+    const juce::ScopedLock sl (trackLock);
+
+    if (track != nullptr)
+    {
+        const double fileRate = track->reader->sampleRate;
+        s.lengthSeconds   = static_cast<double> (track->length) / fileRate;
+        s.positionSeconds = static_cast<double> (track->consumed.load (std::memory_order_relaxed) % track->length) / fileRate;
+        s.loudnessLufs    = track->loudnessLufs.load (std::memory_order_relaxed);
+        s.ready           = track->measured.load (std::memory_order_acquire);
+    }
+
+    return s;
+}
+
+//==============================================================================
+void ReferencePlayer::readAhead()
+{
+    const juce::ScopedLock sl (trackLock);
+
+    if (track == nullptr)
+        return;
+
+    auto& t = *track;
+
+    // The loudness pass reads the whole file once, so it also pages in the start
+    if (! t.measured.load (std::memory_order_relaxed))
+    {
+        const int count = static_cast<int> (juce::jmin<juce::int64> (Track::kMeasureSlice, t.length - t.measuredUntil));
+        t.read (t.measureBuffer, t.measuredUntil, count);
+
+        if (t.numChannels == 1)
+            t.measureBuffer.copyFrom (1, 0, t.measureBuffer, 0, 0, count);
+
+        t.meter.process (juce::AudioBuffer<float> (t.measureBuffer.getArrayOfWritePointers(), 2, count));
+        t.measuredUntil += count;
+
+        if (t.measuredUntil >= t.length)
+        {
+            t.loudnessLufs.store (t.meter.getIntegratedLufs(), std::memory_order_relaxed);
+            t.measureBuffer.setSize (0, 0);
+            t.measured.store (true, std::memory_order_release);
+        }
+    }
+
+    // Each touch faults in one page, here rather than on the audio thread
+    const auto consumed = t.consumed.load (std::memory_order_acquire);
+    const auto until    = consumed + t.readAhead;
+
+    for (auto pos = juce::jmax (consumed, t.touchedUntil); pos < until; pos += t.pageStride)
+        t.reader->touchSample (pos % t.length);
+
+    t.touchedUntil = until;
+    t.residentUntil.store (until, std::memory_order_release);
+}
+
+//==============================================================================
+bool ReferencePlayer::render (Track& t, int numSamples) noexcept
+{
+    const auto start  = t.consumed.load (std::memory_order_relaxed);
+    const bool direct = t.ratio == 1.0;
+    const int  needed = direct ? numSamples : static_cast<int> (std::ceil (numSamples * t.ratio)) + 2;
+
+    // Reading past what the read-ahead has touched could fault on the audio thread
+    if (start + needed > t.residentUntil.load (std::memory_order_acquire))
+    {
+        referenceBuffer.clear (0, numSamples);
+        underruns.fetch_add (1, std::memory_order_relaxed);
+        return false;
+    }
+
+    if (direct)
+    {
+        t.read (referenceBuffer, start, numSamples);
+        t.consumed.store (start + numSamples, std::memory_order_release);
+        return true;
+    }
+
+    t.read (t.sourceBuffer, start, needed);
+    int used = 0;
+
+    for (int ch = 0; ch < t.numChannels; ++ch)
+        used = t.interpolators[static_cast<size_t> (ch)].process (t.ratio, t.sourceBuffer.getReadPointer (ch),
+                                                                   referenceBuffer.getWritePointer (ch), numSamples);
+
+    t.consumed.store (start + used, std::memory_order_release);
+    return true;
+}
+
+bool ReferencePlayer::process (juce::AudioBuffer<float>& buffer, bool useReference, float targetLufs) noexcept
+{
+    const juce::SpinLock::ScopedTryLockType tl (audioLock);
+
+    if (! tl.isLocked() || track == nullptr)
+        return false;
+
+    auto& t = *track;
+    const bool  ready  = t.measured.load (std::memory_order_acquire);
+    const float target = useReference && ready ? 1.0f : 0.0f;
+
+    // Paused while it isn't heard
+    if (fade == 0.0f && target == 0.0f)
+        return false;
+
+    // Matched to the live input's programme loudness; held while either is too quiet to measure
+    const float trackLufs = t.loudnessLufs.load (std::memory_order_relaxed);
+
+    if (ready && targetLufs > LoudnessMatcher::kMinLevelLufs && trackLufs > LoudnessMatcher::kMinLevelLufs)
+        gainDb = juce::jlimit (-LoudnessMatcher::kMaxGainDb, LoudnessMatcher::kMaxGainDb, targetLufs - trackLufs);
+
+    gain.setTargetValue (juce::Decibels::decibelsToGain (gainDb));
+    appliedGainDb = gainDb;
+
+    const int numChannels    = buffer.getNumChannels();
+    const int numSamples     = buffer.getNumSamples();
+    const int sourceChannels = numChannels == 1 ? 1 : t.numChannels;
+
+    for (int offset = 0; offset < numSamples; offset += maxBlock)
+    {
+        if (fade == 0.0f && target == 0.0f)
+            break;
+
+        const int n = juce::jmin (maxBlock, numSamples - offset);
+        render (t, n);
+
+        // A stereo track into a mono bus is folded down
+        if (t.numChannels == 2 && numChannels == 1)
+        {
+            juce::FloatVectorOperations::add (referenceBuffer.getWritePointer (0), referenceBuffer.getReadPointer (1), n);
+            juce::FloatVectorOperations::multiply (referenceBuffer.getWritePointer (0), 0.5f, n);
+        }
+
+        gain.applyGain (referenceBuffer, n);
+
+        if (fade == target)
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+                buffer.copyFrom (ch, offset, referenceBuffer, juce::jmin (ch, sourceChannels - 1), 0, n);
+
+            continue;
+        }
+
+        // Equal power, from the block's first sample: the two sides are uncorrelated
+        for (int i = 0; i < n; ++i)
+        {
+            fade = target > fade ? juce::jmin (target, fade + fadeStep) : juce::jmax (target, fade - fadeStep);
+
+            const float angle     = fade * juce::MathConstants<float>::halfPi;
+            const float refGain   = std::sin (angle);
+            const float inputGain = std::cos (angle);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto* out = buffer.getWritePointer (ch, offset);
+                out[i] = out[i] * inputGain + referenceBuffer.getSample (juce::jmin (ch, sourceChannels - 1), i) * refGain;
+            }
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "DSP/LoudnessMeter.h"
+
+//==============================================================================
+/**
+    Plays a reference track (a commercial mix to compare against) in place of
+    the plugin's input, so it goes through the same environment chain.
+
+    The file is memory-mapped, not loaded: the audio thread reads samples
+    straight from the mapping (juce::MemoryMappedAudioFormatReader), with no
+    file I/O, waiting or allocation.  It only converts format and sample rate
+    into buffers sized on load.  One read-ahead thread per process, shared
+    through a SharedResourcePointer, first measures each track's integrated
+    loudness, then keeps touching the pages kReadAheadSeconds ahead of its
+    play position so they're resident before they're read.  If the audio
+    thread ever gets ahead of it, the block is silent and counted as an
+    underrun rather than risking a page fault.
+
+    process() switches on the first sample of the block where useReference
+    changes, with a kFadeSeconds equal-power crossfade, so the switch lands
+    in the same place however the host splits its buffers.  The track is
+    level-matched to the integrated loudness of the live input, pauses while
+    it isn't heard and loops at its end.  At the session's own sample rate
+    it plays bit-exact, apart from the match gain.
+
+    load(), unload() and prepare() belong to the message thread; process()
+    to the audio thread.  Only WAV and AIFF can be mapped.
+*/
+class ReferencePlayer
+{
+public:
+    struct Stats
+    {
+        double lengthSeconds   = 0.0;
+        double positionSeconds = 0.0;
+        float  loudnessLufs    = LoudnessMeter::kSilenceLufs;   // the whole track's integrated loudness
+        float  matchGainDb     = 0.0f;                          // applied now
+        int    underruns       = 0;                             // blocks played silent, read-ahead behind
+        bool   ready           = false;                         // loaded and measured
+    };
+
+    static constexpr double kReadAheadSeconds = 4.0;
+    static constexpr double kFadeSeconds      = 0.01;
+    static constexpr double kGainRampSeconds  = 0.05;
+
+    ReferencePlayer();
+    ~ReferencePlayer();
+
+    /** Sizes the buffers; a loaded track is kept and re-rated. */
+    void prepare (double sampleRate, int maximumBlockSize);
+
+    /** Heap bytes of the conversion and metering buffers (the mapping is address space, not heap). */
+    size_t getMemoryBytes() const;
+
+    /** Maps file and plays it once its loudness is measured; any previous track is unloaded first. */
+    juce::Result load (const juce::File& file);
+
+    void unload();
+
+    juce::File getFile() const;
+    Stats getStats() const;
+
+    /**
+        Audio thread: crossfades buffer towards the reference while
+        useReference is set, and back to the live input while it isn't.
+        targetLufs is the loudness to match (the live input's integrated
+        loudness).  Returns true if any of the block came from the reference.
+        Wait-free: if load() holds the track, the block plays the live input.
+    */
+    bool process (juce::AudioBuffer<float>& buffer, bool useReference, float targetLufs) noexcept;
+
+private:
+    class ReadAheadThread;
+    friend class ReadAheadThread;
+
+    struct Track;
+
+    /** Measures loudness, then touches the pages ahead of the play position: read-ahead thread. */
+    void readAhead();
+
+    /** Fills referenceBuffer with numSamples of the track at the session's rate; false on underrun. */
+    bool render (Track& t, int numSamples) noexcept;
+
+    /** Sizes the track's buffers and interpolation for the prepared rate and block size. */
+    void retune (Track& t);
+
+    juce::SharedResourcePointer<ReadAheadThread> readAheadThread;
+
+    // load() / unload() take both: trackLock against the read-ahead thread,
+    // audioLock against process(), which only ever tries it
+    juce::CriticalSection trackLock;
+    juce::SpinLock audioLock;
+    std::unique_ptr<Track> track;
+
+    double sampleRate = 44100.0;
+    int    maxBlock   = 512;
+
+    // Audio thread
+    juce::AudioBuffer<float> referenceBuffer;
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> gain { 1.0f };
+    float fade     = 0.0f;   // 0 = live input, 1 = reference
+    float fadeStep = 0.0f;
+    float gainDb   = 0.0f;
+
+    std::atomic<int>   underruns     { 0 };
+    std::atomic<float> appliedGainDb { 0.0f };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ReferencePlayer)
+};
@@ -0,0 +1,256 @@
+#include <juce_events/juce_events.h>
+#include <iostream>
+#include "../DSP/MixAnalyser.h"
+#include "../DSP/OfflineRenderer.h"
+#include "../DSP/DspKernels.h"
+#include "../DSP/IRLibrary.h"
+
+//==============================================================================
+/**
+    car-test-analyse: prints a mix-translation report for one or more files.
+
+        car-test-analyse [--presets 1,2,3,4] [--threads N] [--eco] [--reduced-rate]
+                         [--codec off|device|streaming]
+                         [--isa generic|avx2|avx512] [--out report.txt] file...
+
+        car-test-analyse --check-kernels
+        car-test-analyse --bench-instances N [--presets P] [--reduced-rate]
+        car-test-analyse --bench-compressor [--isa generic|avx2|avx512]
+        car-test-analyse --check-memory
+        car-test-analyse --pack-irs folder archive.irpack
+
+    --codec picks the lossy link in front of the device: none (the
+    default), each preset's own (SBC for the Bluetooth speaker) or 128 kbps
+    AAC streaming for every preset.
+
+    --check-kernels runs every DSP kernel variant this CPU supports against
+    the generic build and exits non-zero if any of them disagree.  With
+    CARTEST_ISA set it also checks that variant is the one in use, and
+    exits with 77 (skipped) if the CPU doesn't support it.
+
+    --check-memory prints each preset's memory footprint by subsystem and
+    exits non-zero if any is over its budget (see OfflineRenderer).
+
+    --pack-irs packs every WAV under folder into one IR library archive
+    (see IRLibrary), for the plugin's IR folder.
+
+    --bench-instances runs N chains of the first listed preset round-robin
+    on 64-sample blocks and compares the per-sample cost with one chain run
+    alone (see OfflineRenderer::benchmarkInstances).
+
+    --bench-compressor times LinkedCompressor against juce::dsp::Compressor
+    on the Phone's limiter settings (see OfflineRenderer::benchmarkCompressor);
+    put --isa first to time a particular kernel variant.
+*/
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit;   // message manager for the convolution loaders
+
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add (juce::String::fromUTF8 (argv[i]));
+
+    MixAnalyser::Options options;
+    juce::File reportFile;
+    juce::Array<juce::File> inputs;
+    int benchInstances = 0;
+
+    for (int i = 0; i < args.size(); ++i)
+    {
+        const auto& arg = args[i];
+
+        if (arg == "--presets" && i + 1 < args.size())
+        {
+            options.presets.clear();
+
+            for (const auto& token : juce::StringArray::fromTokens (args[++i], ",", {}))
+                options.presets.push_back (token.getIntValue());
+        }
+        else if (arg == "--threads" && i + 1 < args.size())
+        {
+            options.numThreads = args[++i].getIntValue();
+        }
+        else if (arg == "--eco")
+        {
+            options.quality = EnvironmentProcessor::Quality::eco;
+        }
+        else if (arg == "--reduced-rate")
+        {
+            options.reducedRate = true;
+        }
+        else if (arg == "--codec" && i + 1 < args.size())
+        {
+            const auto name = args[++i];
+
+            if (name == "off")
+                options.codecPath = EnvironmentProcessor::CodecPath::off;
+            else if (name == "device")
+                options.codecPath = EnvironmentProcessor::CodecPath::device;
+            else if (name == "streaming")
+                options.codecPath = EnvironmentProcessor::CodecPath::streaming;
+            else
+            {
+                std::cerr << "Unknown codec path " << name << "\n";
+                return 2;
+            }
+        }
+        else if (arg == "--isa" && i + 1 < args.size())
+        {
+            const auto name = args[++i];
+            bool forced = false;
+
+            for (auto isa : { DspKernels::Isa::generic, DspKernels::Isa::avx2, DspKernels::Isa::avx512 })
+                if (name == DspKernels::getIsaName (isa))
+                    forced = DspKernels::forceIsa (isa);
+
+            if (! forced)
+            {
+                std::cerr << "Instruction set " << name << " isn't available on this machine\n";
+                return 2;
+            }
+        }
+        else if (arg == "--check-kernels")
+        {
+            // Under CARTEST_ISA the override itself is checked too, and a variant
+            // this machine can't run is a skip (77, as ctest expects), not a pass
+            const auto requested = juce::SystemStats::getEnvironmentVariable ("CARTEST_ISA", {}).trim().toLowerCase();
+
+            for (auto isa : { DspKernels::Isa::generic, DspKernels::Isa::avx2, DspKernels::Isa::avx512 })
+            {
+                if (requested != DspKernels::getIsaName (isa))
+                    continue;
+
+                if (! DspKernels::isSupported (isa))
+                {
+                    std::cout << "CARTEST_ISA=" << requested << " isn't available on this machine: skipped\n";
+                    return 77;
+                }
+
+                if (DspKernels::getActiveIsa() != isa)
+                {
+                    std::cout << "CARTEST_ISA=" << requested << " was ignored: running "
+                              << DspKernels::getIsaName (DspKernels::getActiveIsa()) << "\n";
+                    return 1;
+                }
+            }
+
+            const auto failures = DspKernels::verifyVariants();
+
+            for (auto isa : { DspKernels::Isa::generic, DspKernels::Isa::avx2, DspKernels::Isa::avx512 })
+                std::cout << DspKernels::getIsaName (isa) << ": "
+                          << (DspKernels::isSupported (isa) ? "checked" : "not available") << "\n";
+
+            std::cout << (failures.empty() ? "All kernel variants agree\n" : failures);
+            return failures.empty() ? 0 : 1;
+        }
+        else if (arg == "--check-memory")
+        {
+            juce::String report;
+            const bool passed = OfflineRenderer::checkMemoryBudgets (report);
+
+            std::cout << report << (passed ? "All presets within their memory budgets\n" : "");
+            return passed ? 0 : 1;
+        }
+        else if (arg == "--pack-irs" && i + 2 < args.size())
+        {
+            const auto folder  = juce::File::getCurrentWorkingDirectory().getChildFile (args[i + 1]);
+            const auto archive = juce::File::getCurrentWorkingDirectory().getChildFile (args[i + 2]);
+            const auto error   = IRLibrary::writeArchive (folder, archive);
+
+            if (error.isNotEmpty())
+            {
+                std::cerr << error << "\n";
+                return 1;
+            }
+
+            std::cout << "Packed " << folder.getFullPathName() << " into " << archive.getFullPathName() << "\n";
+            return 0;
+        }
+        else if (arg == "--bench-instances" && i + 1 < args.size())
+        {
+            benchInstances = juce::jmax (1, args[++i].getIntValue());
+        }
+        else if (arg == "--bench-compressor")
+        {
+            const auto bench = OfflineRenderer::benchmarkCompressor (48000.0, 512, 10.0);
+
+            std::cout << "Phone limiter, 48 kHz stereo, 512-sample blocks, "
+                      << DspKernels::getIsaName (DspKernels::getActiveIsa()) << " kernels\n"
+                      << "  LinkedCompressor:       " << bench.nsPerSampleLinked << " ns/sample\n"
+                      << "  juce::dsp::Compressor:  " << bench.nsPerSampleJuce << " ns/sample\n";
+            return 0;
+        }
+        else if (arg == "--out" && i + 1 < args.size())
+        {
+            reportFile = juce::File::getCurrentWorkingDirectory().getChildFile (args[++i]);
+        }
+        else if (arg.startsWith ("--"))
+        {
+            std::cerr << "Unknown option " << arg << "\n";
+            return 2;
+        }
+        else
+        {
+            inputs.add (juce::File::getCurrentWorkingDirectory().getChildFile (arg));
+        }
+    }
+
+    if (benchInstances > 0)
+    {
+        // Small blocks, as in a busy session, where the per-block state matters most
+        OfflineRenderer::Settings settings;
+        settings.presetIndex = options.presets.empty() ? 1 : options.presets.front();
+        settings.sampleRate  = 48000.0;
+        settings.blockSize   = 64;
+        settings.quality     = options.quality;
+        settings.codecPath   = options.codecPath;
+        settings.reducedRate = options.reducedRate;
+
+        const auto bench = OfflineRenderer::benchmarkInstances (settings, benchInstances, 2.0);
+
+        if (bench.error.isNotEmpty())
+        {
+            std::cerr << bench.error << "\n";
+            return 1;
+        }
+
+        std::cout << "Preset " << settings.presetIndex << ", " << settings.blockSize << "-sample blocks, "
+                  << bench.hotStateBytes << " bytes of hot state per instance\n"
+                  << "  1 chain alone:        " << bench.nsPerSampleOne << " ns/sample\n"
+                  << "  " << bench.numInstances << " chains round-robin: " << bench.nsPerSampleMany << " ns/sample\n";
+        return 0;
+    }
+
+    if (inputs.isEmpty())
+    {
+        std::cerr << "Usage: car-test-analyse [--presets 1,2,3,4] [--threads N] [--eco] [--reduced-rate]\n"
+                     "                        [--codec off|device|streaming]\n"
+                     "                        [--isa generic|avx2|avx512] [--out report.txt] file...\n"
+                     "       car-test-analyse --check-kernels\n"
+                     "       car-test-analyse --bench-instances N [--presets P] [--reduced-rate]\n"
+                     "       car-test-analyse --bench-compressor [--isa generic|avx2|avx512]\n"
+                     "       car-test-analyse --check-memory\n"
+                     "       car-test-analyse --pack-irs folder archive.irpack\n";
+        return 2;
+    }
+
+    juce::String text;
+    bool failed = false;
+
+    for (const auto& input : inputs)
+    {
+        const auto report = MixAnalyser::analyse (input, options);
+        failed = failed || report.error.isNotEmpty();
+        text << report.toString() << "\n";
+    }
+
+    std::cout << text;
+
+    if (reportFile != juce::File() && ! reportFile.replaceWithText (text))
+    {
+        std::cerr << "Couldn't write " << reportFile.getFullPathName() << "\n";
+        return 1;
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,267 @@
+#include <juce_events/juce_events.h>
+#include <iostream>
+#include <map>
+#include "../DSP/OfflineRenderer.h"
+
+//==============================================================================
+/**
+    car-test-golden: renders a fixed program through each preset and compares
+    it with the golden render checked in under Tests/Golden.
+
+        car-test-golden [--goldens folder] [--case name] [--record]
+
+    A case fails if its render's peak or RMS difference from the golden is
+    above that case's limits, if its golden is missing, or if its chain
+    doesn't load.  Each line also shows how much faster than real time the
+    case rendered.  --record writes the goldens instead; only do that for a
+    change that is meant to alter the sound, and say so in the commit.
+
+    A goldens folder without any goldens in it is skipped (exit code
+    kSkipped), so a fresh checkout passes until they've been recorded.
+*/
+namespace
+{
+    constexpr int kSkipped = 77;   // ctest's SKIP_RETURN_CODE for this test
+
+    struct GoldenCase
+    {
+        const char* name;
+        OfflineRenderer::Settings settings;
+
+        // Renders are deterministic, so on the machine that recorded them the
+        // difference is zero.  The limits cover what moves between machines:
+        // the kernel variant (AVX or generic) and JUCE's FFT backend change
+        // float rounding, around -130 dB, and the limiter, driver and codec
+        // can turn that into a slightly different gain or quantiser step
+        float maxAbsLimitDb;
+        float rmsLimitDb;
+    };
+
+    OfflineRenderer::Settings makeSettings (int presetIndex, double sampleRate = 48000.0, int blockSize = 512)
+    {
+        OfflineRenderer::Settings settings;
+        settings.presetIndex = presetIndex;
+        settings.sampleRate  = sampleRate;
+        settings.blockSize   = blockSize;
+        return settings;
+    }
+
+    std::vector<GoldenCase> makeCases()
+    {
+        std::vector<GoldenCase> cases;
+
+        // Each preset on its default path.  Bypass is the input, untouched
+        cases.push_back ({ "bypass", makeSettings (0), -140.0f, -160.0f });
+        cases.push_back ({ "sedan",  makeSettings (1), -90.0f,  -110.0f });   // cabin model, reflections
+        cases.push_back ({ "phone",  makeSettings (2), -80.0f,  -100.0f });   // fast limiter into the driver
+        cases.push_back ({ "laptop", makeSettings (3), -90.0f,  -110.0f });
+        cases.push_back ({ "bt",     makeSettings (4), -80.0f,  -100.0f });   // true stereo, RMS compressor
+
+        // The alternative paths, on the preset each matters most for
+        auto fused = makeSettings (3);
+        fused.convolutionMode = EnvironmentProcessor::ConvolutionMode::fused;
+        cases.push_back ({ "laptop-fused", fused, -90.0f, -110.0f });
+
+        auto eco = makeSettings (3);
+        eco.quality = EnvironmentProcessor::Quality::eco;
+        cases.push_back ({ "laptop-eco", eco, -90.0f, -110.0f });
+
+        auto rear = makeSettings (1);
+        rear.seat = CabinModel::Seat::rear;
+        cases.push_back ({ "sedan-rear", rear, -90.0f, -110.0f });
+
+        auto reduced = makeSettings (2);
+        reduced.reducedRate = true;
+        cases.push_back ({ "phone-reduced-rate", reduced, -80.0f, -100.0f });
+
+        auto highQuality = makeSettings (2);
+        highQuality.highQuality = true;
+        cases.push_back ({ "phone-high-quality", highQuality, -80.0f, -100.0f });
+
+        // A quantiser step that rounds the other way is a whole step of noise in one bin
+        auto codec = makeSettings (4);
+        codec.codecPath = EnvironmentProcessor::CodecPath::device;
+        cases.push_back ({ "bt-codec", codec, -40.0f, -70.0f });
+
+        // The seeded road noise on top
+        auto noise = makeSettings (1);
+        noise.noiseAmount = 0.5f;
+        cases.push_back ({ "sedan-noise", noise, -90.0f, -110.0f });
+
+        // Other rates, and block sizes a host might really send: odd ones, one
+        // sample, and larger than the convolver's partitions
+        cases.push_back ({ "sedan-44k1-block-37",    makeSettings (1, 44100.0,  37),   -90.0f, -110.0f });
+        cases.push_back ({ "phone-48k-block-1",      makeSettings (2, 48000.0,  1),    -80.0f, -100.0f });
+        cases.push_back ({ "bt-88k2-block-64",       makeSettings (4, 88200.0,  64),   -80.0f, -100.0f });
+        cases.push_back ({ "phone-96k-block-1000",   makeSettings (2, 96000.0,  1000), -80.0f, -100.0f });
+        cases.push_back ({ "laptop-192k-block-4096", makeSettings (3, 192000.0, 4096), -90.0f, -110.0f });
+
+        auto reducedHighRate = makeSettings (2, 96000.0, 333);
+        reducedHighRate.reducedRate = true;
+        cases.push_back ({ "phone-reduced-rate-96k-block-333", reducedHighRate, -80.0f, -100.0f });
+
+        return cases;
+    }
+
+    /**
+        2.25 s, stereo: an impulse left to ring out for the IRs' tails, a log
+        sweep for the filters, pink noise for the dynamics, and the seeded
+        city noise for the codec and limiter on real-world material.
+    */
+    juce::AudioBuffer<float> makeProgram (double sampleRate)
+    {
+        const juce::AudioBuffer<float> parts[] = {
+            OfflineRenderer::TestSignals::impulse   (sampleRate, 0.25),
+            OfflineRenderer::TestSignals::sweep     (sampleRate, 0.75),
+            OfflineRenderer::TestSignals::pinkNoise (sampleRate, 0.75),
+            OfflineRenderer::TestSignals::cityNoise (sampleRate, 0.5)
+        };
+
+        int length = 0;
+        for (const auto& part : parts)
+            length += part.getNumSamples();
+
+        juce::AudioBuffer<float> program (2, length);
+        int pos = 0;
+
+        for (const auto& part : parts)
+        {
+            for (int ch = 0; ch < 2; ++ch)
+                program.copyFrom (ch, pos, part, ch, 0, part.getNumSamples());
+
+            pos += part.getNumSamples();
+        }
+
+        return program;
+    }
+
+    bool hasAnyGoldens (const juce::File& folder)
+    {
+        return folder.isDirectory() && folder.getNumberOfChildFiles (juce::File::findFiles, "*.wav") > 0;
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit;   // message manager for the convolution loaders
+
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add (juce::String::fromUTF8 (argv[i]));
+
+    auto goldens = juce::File::getCurrentWorkingDirectory().getChildFile ("Tests/Golden");
+    juce::String onlyCase;
+    bool record = false;
+
+    for (int i = 0; i < args.size(); ++i)
+    {
+        const auto& arg = args[i];
+
+        if (arg == "--goldens" && i + 1 < args.size())
+        {
+            goldens = juce::File::getCurrentWorkingDirectory().getChildFile (args[++i]);
+        }
+        else if (arg == "--case" && i + 1 < args.size())
+        {
+            onlyCase = args[++i];
+        }
+        else if (arg == "--record")
+        {
+            record = true;
+        }
+        else
+        {
+            std::cerr << "Usage: car-test-golden [--goldens folder] [--case name] [--record]\n";
+            return 2;
+        }
+    }
+
+    if (record && ! goldens.createDirectory())
+    {
+        std::cerr << "Couldn't create " << goldens.getFullPathName() << "\n";
+        return 1;
+    }
+
+    // Nothing recorded yet: nothing to compare with, which isn't a regression
+    if (! record && ! hasAnyGoldens (goldens))
+    {
+        std::cout << "SKIP  no goldens in " << goldens.getFullPathName()
+                  << " (record them with --record, or build the record-goldens target)\n";
+        return kSkipped;
+    }
+
+    std::map<double, juce::AudioBuffer<float>> programs;   // one per sample rate
+    int failures = 0;
+    int run = 0;
+
+    for (const auto& c : makeCases())
+    {
+        if (onlyCase.isNotEmpty() && onlyCase != c.name)
+            continue;
+
+        const auto sampleRate = c.settings.sampleRate;
+
+        if (programs.count (sampleRate) == 0)
+            programs[sampleRate] = makeProgram (sampleRate);
+
+        ++run;
+        const auto file   = goldens.getChildFile (juce::String (c.name) + ".wav");
+        const auto render = OfflineRenderer::render (programs[sampleRate], c.settings);
+        const auto speed  = ", " + juce::String (render.realtimeFactor, 1) + "x real time";
+
+        if (render.error.isNotEmpty())
+        {
+            std::cout << "FAIL  " << c.name << ": " << render.error << "\n";
+            ++failures;
+            continue;
+        }
+
+        if (record)
+        {
+            const bool written = OfflineRenderer::writeWav (render.output, sampleRate, file);
+            std::cout << (written ? "WROTE " : "FAIL  ") << c.name << ": " << file.getFullPathName() << speed << "\n";
+            failures += written ? 0 : 1;
+            continue;
+        }
+
+        juce::AudioBuffer<float> golden;
+        double goldenRate = 0.0;
+
+        if (! OfflineRenderer::readWav (file, golden, goldenRate))
+        {
+            std::cout << "FAIL  " << c.name << ": no golden at " << file.getFullPathName()
+                      << " (record it with --record)\n";
+            ++failures;
+            continue;
+        }
+
+        // A render of a different shape is a different test, whatever the samples say
+        if (goldenRate != sampleRate || golden.getNumChannels() != render.output.getNumChannels()
+             || golden.getNumSamples() != render.output.getNumSamples())
+        {
+            std::cout << "FAIL  " << c.name << ": golden is " << golden.getNumChannels() << " x "
+                      << golden.getNumSamples() << " at " << goldenRate << " Hz, render is "
+                      << render.output.getNumChannels() << " x " << render.output.getNumSamples()
+                      << " at " << sampleRate << " Hz\n";
+            ++failures;
+            continue;
+        }
+
+        const auto d      = OfflineRenderer::compare (golden, render.output);
+        const bool passed = d.within (c.maxAbsLimitDb, c.rmsLimitDb);
+        failures += passed ? 0 : 1;
+
+        std::cout << (passed ? "ok    " : "FAIL  ") << c.name << ": peak " << juce::String (d.maxAbsDb, 1)
+                  << " dB (limit " << c.maxAbsLimitDb << "), rms " << juce::String (d.rmsDb, 1)
+                  << " dB (limit " << c.rmsLimitDb << ")" << speed << "\n";
+    }
+
+    if (run == 0)
+    {
+        std::cerr << "No case called " << onlyCase << "\n";
+        return 2;
+    }
+
+    std::cout << run - failures << " of " << run << " golden renders " << (record ? "written" : "match") << "\n";
+    return failures == 0 ? 0 : 1;
+}
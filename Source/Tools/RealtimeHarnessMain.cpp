@@ -0,0 +1,300 @@
+#include <juce_events/juce_events.h>
+#include <iostream>
+#include "../PluginProcessor.h"
+#include "../DSP/OfflineRenderer.h"
+
+#if ! CARTEST_RT_CHECKS
+ #error "car-test-rt-harness reads RealtimeMonitor's counters: build it with CARTEST_RT_CHECKS=1"
+#endif
+
+//==============================================================================
+/**
+    car-test-rt-harness: plays audio through the plugin's processBlock the way
+    an awkward host would, and fails on any real-time violation.
+
+        car-test-rt-harness [--blocks N] [--rates 44100,96000,...] [--max-block N]
+                            [--check-budget] [--seed N]
+
+    An audio thread plays pink noise through the processor at each sample
+    rate in turn, --blocks blocks in all (two million by default).  Between
+    rates the message thread re-prepares it, as a host does when the
+    device's rate changes.  It's prepared for a quarter of --max-block, and
+    each device callback of --max-block samples is split into blocks of
+    random size, so most blocks are larger than prepareToPlay() promised.
+    Every block comes with automation: the continuous parameters wander a
+    little and the discrete ones (preset, modes, seat, morph target...)
+    jump now and then.  The automation is set before processBlock, as a
+    host wrapper does it, so only the plugin's own work is checked.
+
+    A block fails if it allocates, frees or takes a blocking lock, or puts
+    out a NaN, Inf or denormal.  It also fails if it steps at its start
+    without a discrete parameter having jumped.  The checks are
+    RealtimeMonitor's, which only this target builds; locks are only seen
+    on Linux.  With --check-budget, a callback also fails if processBlock
+    took longer than the callback's duration.  That's only meaningful in
+    an optimised build, so ctest passes it in Release only.
+*/
+namespace
+{
+    constexpr int    kMaxReportedFailures = 20;
+    constexpr int    kDiscreteJumpOdds    = 50;      // a discrete parameter jumps once in this many blocks
+    constexpr float  kContinuousStep      = 0.02f;   // largest per-block move of a continuous one, normalised
+    constexpr double kInputSeconds        = 10.0;    // of pink noise, played back and forth
+
+    struct Options
+    {
+        juce::int64 blocks = 2000000;   // over all the rates
+        std::vector<double> rates { 44100.0, 96000.0, 48000.0, 88200.0 };
+        int maxBlock       = 1024;      // the device callback; prepareToPlay() is told a quarter of it
+        bool checkBudget   = false;
+        juce::int64 seed   = 1;
+
+        int getPreparedBlockSize() const { return juce::jmax (1, maxBlock / 4); }
+    };
+
+    //==========================================================================
+    class HostThread : public juce::Thread
+    {
+    public:
+        HostThread (CarTestAudioProcessor& p, const Options& o)
+            : juce::Thread ("car-test-rt-harness audio"), processor (p), options (o), random (o.seed)
+        {
+        }
+
+        void run() override
+        {
+            const auto blocksPerRate = juce::jmax<juce::int64> (1, options.blocks / static_cast<juce::int64> (options.rates.size()));
+
+            for (const auto rate : options.rates)
+            {
+                if (threadShouldExit())
+                    break;
+
+                prepareOnMessageThread (rate);
+                play (rate, blocksRun + blocksPerRate);
+            }
+
+            juce::MessageManager::getInstance()->stopDispatchLoop();
+        }
+
+        int failures = 0;
+        juce::int64 blocksRun = 0;
+
+    private:
+        void prepareOnMessageThread (double rate)
+        {
+            juce::WaitableEvent prepared;
+
+            // Audio is stopped meanwhile, as a host stops the device to change its rate
+            juce::MessageManager::callAsync ([this, rate, &prepared]
+            {
+                processor.releaseResources();
+                processor.setRateAndBufferSizeDetails (rate, options.getPreparedBlockSize());
+                processor.prepareToPlay (rate, options.getPreparedBlockSize());
+                processor.resetRealtimeStats();
+                prepared.signal();
+            });
+
+            prepared.wait();
+        }
+
+        void play (double rate, juce::int64 lastBlock)
+        {
+            const auto input = OfflineRenderer::TestSignals::pinkNoise (rate, kInputSeconds, options.seed);
+            juce::AudioBuffer<float> buffer (input.getNumChannels(), options.maxBlock);
+            juce::MidiBuffer midi;
+            bool fromSilence = true;   // the monitor compares the first block with zeros
+            int  inputPos    = 0;
+
+            while (blocksRun < lastBlock && ! threadShouldExit())
+            {
+                juce::int64 processTicks = 0;
+
+                for (int offset = 0; offset < options.maxBlock;)
+                {
+                    const int  numSamples = juce::jmin (options.maxBlock - offset, 1 + random.nextInt (options.maxBlock));
+                    const bool jumped     = automate();
+
+                    juce::AudioBuffer<float> block (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), numSamples);
+                    readInput (input, inputPos, block);
+
+                    const auto before = processor.getRealtimeStats();
+
+                    {
+                        // Hosts hold this lock for the callback; suspendProcessing() takes it to re-prepare
+                        const juce::ScopedLock sl (processor.getCallbackLock());
+
+                        if (processor.isSuspended())
+                        {
+                            block.clear();
+                            fromSilence = true;
+                        }
+                        else
+                        {
+                            const auto startTicks = juce::Time::getHighResolutionTicks();
+                            processor.processBlock (block, midi);
+                            processTicks += juce::Time::getHighResolutionTicks() - startTicks;
+                        }
+                    }
+
+                    check (rate, numSamples, before, processor.getRealtimeStats(), jumped || fromSilence);
+                    fromSilence = false;
+                    offset += numSamples;
+                    ++blocksRun;
+                }
+
+                const double ms       = 1000.0 * juce::Time::highResolutionTicksToSeconds (processTicks);
+                const double budgetMs = 1000.0 * options.maxBlock / rate;
+
+                if (options.checkBudget && ms > budgetMs)
+                    fail (rate, "a " + juce::String (options.maxBlock) + "-sample callback took "
+                                  + juce::String (ms, 2) + " ms, budget " + juce::String (budgetMs, 2) + " ms");
+            }
+
+            const auto stats = processor.getRealtimeStats();
+            std::cout << "ran   " << rate << " Hz: " << stats.blocks << " blocks, worst block "
+                      << juce::String (stats.worstBlockMs, 3) << " ms\n";
+        }
+
+        /** The input forwards then backwards, so it runs on for as long as needed without a step. */
+        static void readInput (const juce::AudioBuffer<float>& input, int& pos, juce::AudioBuffer<float>& block)
+        {
+            const int length = input.getNumSamples();
+
+            for (int s = 0; s < block.getNumSamples(); ++s)
+            {
+                const int index = pos < length ? pos : 2 * length - 1 - pos;
+
+                for (int ch = 0; ch < block.getNumChannels(); ++ch)
+                    block.setSample (ch, s, input.getSample (ch, index));
+
+                pos = (pos + 1) % (2 * length);
+            }
+        }
+
+        /** Moves the automatable parameters; true if a discrete one jumped. */
+        bool automate()
+        {
+            bool jumped = false;
+
+            for (auto* param : processor.getParameters())
+            {
+                if (! param->isAutomatable())
+                    continue;
+
+                float value = param->getValue();
+
+                if (param->isDiscrete() || param->isBoolean())
+                {
+                    if (random.nextInt (kDiscreteJumpOdds) != 0)
+                        continue;
+
+                    value  = random.nextFloat();
+                    jumped = true;
+                }
+                else
+                {
+                    value = juce::jlimit (0.0f, 1.0f, value + (2.0f * random.nextFloat() - 1.0f) * kContinuousStep);
+                }
+
+                param->setValue (value);
+                param->sendValueChangedMessageToListeners (value);
+            }
+
+            return jumped;
+        }
+
+        void check (double rate, int numSamples, const RealtimeMonitor::Stats& before,
+                    const RealtimeMonitor::Stats& after, bool stepAllowed)
+        {
+            juce::StringArray problems;
+
+            auto count = [&problems] (juce::int64 n, const char* what)
+            {
+                if (n > 0)
+                    problems.add (juce::String (n) + " " + what);
+            };
+
+            count (after.allocations - before.allocations, "allocations");
+            count (after.deallocations - before.deallocations, "frees");
+            count (after.locks - before.locks, "blocking locks");
+            count (after.nonFiniteSamples - before.nonFiniteSamples, "NaN / Inf samples");
+            count (after.denormalSamples - before.denormalSamples, "denormal samples");
+
+            if (! stepAllowed)
+                count (after.discontinuities - before.discontinuities, "discontinuities");
+
+            if (! problems.isEmpty())
+                fail (rate, "block " + juce::String (blocksRun) + " (" + juce::String (numSamples) + " samples): "
+                              + problems.joinIntoString (", "));
+        }
+
+        void fail (double rate, const juce::String& what)
+        {
+            if (++failures <= kMaxReportedFailures)
+                std::cout << "FAIL  " << rate << " Hz, " << what << "\n";
+        }
+
+        CarTestAudioProcessor& processor;
+        const Options& options;
+        juce::Random random;
+    };
+}
+
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit;   // message thread for the processor's prepares and timers
+
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add (juce::String::fromUTF8 (argv[i]));
+
+    Options options;
+
+    for (int i = 0; i < args.size(); ++i)
+    {
+        const auto& arg = args[i];
+
+        if (arg == "--blocks" && i + 1 < args.size())
+        {
+            options.blocks = juce::jmax<juce::int64> (1, args[++i].getLargeIntValue());
+        }
+        else if (arg == "--rates" && i + 1 < args.size())
+        {
+            options.rates.clear();
+
+            for (const auto& token : juce::StringArray::fromTokens (args[++i], ",", {}))
+                options.rates.push_back (token.getDoubleValue());
+        }
+        else if (arg == "--max-block" && i + 1 < args.size())
+        {
+            options.maxBlock = juce::jmax (1, args[++i].getIntValue());
+        }
+        else if (arg == "--check-budget")
+        {
+            options.checkBudget = true;
+        }
+        else if (arg == "--seed" && i + 1 < args.size())
+        {
+            options.seed = args[++i].getLargeIntValue();
+        }
+        else
+        {
+            std::cerr << "Usage: car-test-rt-harness [--blocks N] [--rates 44100,96000,...] [--max-block N]"
+                         " [--check-budget] [--seed N]\n";
+            return 2;
+        }
+    }
+
+    CarTestAudioProcessor processor;
+    HostThread host (processor, options);
+
+    host.startThread();
+    juce::MessageManager::getInstance()->runDispatchLoop();
+    host.stopThread (-1);
+    processor.releaseResources();
+
+    std::cout << host.blocksRun << " blocks at " << options.rates.size() << " sample rates, "
+              << host.failures << " real-time violations\n";
+    return host.failures == 0 ? 0 : 1;
+}
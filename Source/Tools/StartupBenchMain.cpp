@@ -0,0 +1,89 @@
+#include <juce_events/juce_events.h>
+#include <iostream>
+#include "../DSP/OfflineRenderer.h"
+
+//==============================================================================
+/**
+    car-test-startup-bench: what building preset data on demand saves when a
+    session loads (see OfflineRenderer::benchmarkStartup).
+
+        car-test-startup-bench [--instances N] [--preset P] [--rate Hz] [--block N]
+
+    Loads N chains of preset P (the Phone by default, which needs no preset
+    data in its default modes) as they are, then with every preset's data
+    built in prepare().  Prints the time until all of them are ready and
+    their memory each way.  Exits non-zero if the lazy load started the
+    preset data job, or wasn't both quicker and smaller: the data must only
+    be built once a mode asks for it.
+*/
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit;   // message manager for the convolution loaders
+
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add (juce::String::fromUTF8 (argv[i]));
+
+    OfflineRenderer::Settings settings;
+    settings.presetIndex = 2;
+    settings.sampleRate  = 48000.0;
+    settings.blockSize   = 512;
+    int instances = 16;
+
+    for (int i = 0; i < args.size(); ++i)
+    {
+        const auto& arg = args[i];
+
+        if (arg == "--instances" && i + 1 < args.size())
+        {
+            instances = juce::jmax (1, args[++i].getIntValue());
+        }
+        else if (arg == "--preset" && i + 1 < args.size())
+        {
+            settings.presetIndex = args[++i].getIntValue();
+        }
+        else if (arg == "--rate" && i + 1 < args.size())
+        {
+            settings.sampleRate = args[++i].getDoubleValue();
+        }
+        else if (arg == "--block" && i + 1 < args.size())
+        {
+            settings.blockSize = juce::jmax (1, args[++i].getIntValue());
+        }
+        else
+        {
+            std::cerr << "Usage: car-test-startup-bench [--instances N] [--preset P] [--rate Hz] [--block N]\n";
+            return 2;
+        }
+    }
+
+    const auto bench = OfflineRenderer::benchmarkStartup (settings, instances);
+
+    if (bench.error.isNotEmpty())
+    {
+        std::cerr << bench.error << "\n";
+        return 1;
+    }
+
+    auto megabytes = [] (size_t bytes) { return juce::String (static_cast<double> (bytes) / (1024.0 * 1024.0), 1); };
+
+    std::cout << bench.numInstances << " chains of preset " << settings.presetIndex << " at "
+              << settings.sampleRate << " Hz / " << settings.blockSize << " samples\n"
+              << "  on demand (as shipped):  ready in " << juce::String (bench.lazyReadyMs, 1) << " ms, "
+              << megabytes (bench.lazyBytes) << " MB\n"
+              << "  all data at prepare():   ready in " << juce::String (bench.eagerReadyMs, 1) << " ms, "
+              << megabytes (bench.eagerBytes) << " MB\n";
+
+    const bool passed = ! bench.lazyBuiltData && bench.lazyReadyMs < bench.eagerReadyMs
+                     && bench.lazyBytes < bench.eagerBytes;
+
+    if (bench.lazyBuiltData)
+        std::cout << "FAIL  the on-demand load started the preset data job\n";
+    else if (! passed)
+        std::cout << "FAIL  loading on demand saved nothing\n";
+    else
+        std::cout << "ok    saved " << juce::String (bench.eagerReadyMs - bench.lazyReadyMs, 1) << " ms and "
+                  << megabytes (bench.eagerBytes - bench.lazyBytes) << " MB\n";
+
+    return passed ? 0 : 1;
+}